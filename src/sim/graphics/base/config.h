@@ -11,6 +11,13 @@ struct Config {
   bool vsync{true};
   uint32_t sampleCount{1};
   uint32_t numFrame{2};
+  /**render into an offscreen image ring instead of a window surface and swapchain.*/
+  bool headless{false};
+  /**file the pipeline cache is loaded from at startup and saved to on shutdown; empty
+   * disables persistence.*/
+  std::string pipelineCacheFile{"pipeline.cache"};
+  /**size in bytes of the staging ring that batches buffer and texture uploads.*/
+  uint32_t stagingRingSize{64u * 1024u * 1024u};
 };
 
 struct DebugConfig {
@@ -1,5 +1,7 @@
 #include "device.h"
 #include "vulkan_base.h"
+#include "resource/staging_ring.h"
+#include "resource/images.h"
 #include "sim/util/syntactic_sugar.h"
 
 #define VMA_IMPLEMENTATION
@@ -41,8 +43,10 @@ auto findQueueFamily(
   QueueInfo compute{search(Flag::eCompute)};
   QueueInfo transfer{search(Flag::eTransfer)};
   QueueInfo present{VK_QUEUE_FAMILY_IGNORED};
-  for(uint32_t i = 0; i < queueFamilies.size(); i++)
-    if(physicalDevice.getSurfaceSupportKHR(i, surface)) present.index = i;
+  if(!surface) present.index = graphics.index;
+  else
+    for(uint32_t i = 0; i < queueFamilies.size(); i++)
+      if(physicalDevice.getSurfaceSupportKHR(i, surface)) present.index = i;
   errorIf(present.index == VK_QUEUE_FAMILY_IGNORED, "failed to find present family!");
   debugLog(
     "Queue Family:", "graphics[", graphics.index, "]", "compute[", compute.index, "]",
@@ -63,6 +67,12 @@ void checkDeviceExtensionSupport(
   }
 }
 
+bool deviceExtensionSupported(const vk::PhysicalDevice &device, const char *extension) {
+  for(auto &properties: device.enumerateDeviceExtensionProperties())
+    if(std::string(properties.extensionName) == extension) return true;
+  return false;
+}
+
 Device::Device(VulkanBase &framework) {
   auto &instance = *framework.vkInstance;
   auto &surface = *framework.surface;
@@ -87,7 +97,9 @@ Device::Device(VulkanBase &framework) {
 
   bool useFeature2{false};
 
-  std::vector<const char *> deviceExtensions{VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  std::vector<const char *> deviceExtensions;
+  if(!framework.config.headless)
+    deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
   featureConfig = framework.featureConfig;
   if(featureConfig & FeatureConfig::DedicatedAllocation)
     deviceExtensions.push_back(VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME);
@@ -96,16 +108,26 @@ Device::Device(VulkanBase &framework) {
     useFeature2 = true;
     auto featuresExt = physicalDevice.getFeatures2<
       vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>();
-    auto descriptorFeatures =
+    descriptorIndexingFeatures =
       featuresExt.get<vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>();
     errorIf(
-      !descriptorFeatures.descriptorBindingSampledImageUpdateAfterBind ||
-        !descriptorFeatures.descriptorBindingVariableDescriptorCount ||
-        !descriptorFeatures.descriptorBindingPartiallyBound ||
-        !descriptorFeatures.descriptorBindingStorageImageUpdateAfterBind,
+      !descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind ||
+        !descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount ||
+        !descriptorIndexingFeatures.descriptorBindingPartiallyBound ||
+        !descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending ||
+        !descriptorIndexingFeatures.descriptorBindingStorageImageUpdateAfterBind ||
+        !descriptorIndexingFeatures.runtimeDescriptorArray,
       "descriptor features not satisfied!");
 
+    // the chain returned by getFeatures2 is gone by the time the device is created.
     features2 = featuresExt.get<vk::PhysicalDeviceFeatures2>();
+    descriptorIndexingFeatures.pNext = nullptr;
+    features2.pNext = &descriptorIndexingFeatures;
+
+    auto properties = physicalDevice.getProperties2<
+      vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingPropertiesEXT>();
+    descriptorIndexingProperties =
+      properties.get<vk::PhysicalDeviceDescriptorIndexingPropertiesEXT>();
 
     deviceExtensions.push_back(VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME);
     deviceExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
@@ -119,6 +141,11 @@ Device::Device(VulkanBase &framework) {
     rayTracingProperties = result.get<vk::PhysicalDeviceRayTracingPropertiesNV>();
   }
 
+  drawIndirectCount = deviceExtensionSupported(
+    physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+  if(drawIndirectCount)
+    deviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
   checkDeviceExtensionSupport(physicalDevice, deviceExtensions);
 
   vk::DeviceCreateInfo deviceInfo;
@@ -147,8 +174,15 @@ Device::Device(VulkanBase &framework) {
   VULKAN_HPP_DEFAULT_DISPATCHER.init(*device);
 
   createAllocator();
+
+  pipelineCache =
+    u<PipelineCache>(physicalDevice, *device, framework.config.pipelineCacheFile);
+  stagingRing = u<StagingRing>(*this, framework.config.stagingRingSize);
+  samplerCache = u<SamplerCache>(*device);
 }
 
+Device::~Device() = default;
+
 void Device::createAllocator() {
   VmaAllocatorCreateInfo createInfo{};
   if(featureConfig & FeatureConfig::DedicatedAllocation)
@@ -190,11 +224,14 @@ void Device::createAllocator() {
 
 void Device::graphicsImmediately(
   const std::function<void(vk::CommandBuffer cb)> &func, uint64_t timeout) {
+  // pending uploads go to the same queue first, so func observes them.
+  stagingRing->flush();
   executeImmediately(*device, *graphicsCmdPool, graphics.queue, func, timeout);
 }
 
 void Device::computeImmediately(
   const std::function<void(vk::CommandBuffer cb)> &func, uint64_t timeout) {
+  stagingRing->wait(stagingRing->flush());
   executeImmediately(*device, *computeCmdPool, compute.queue, func, timeout);
 }
 
@@ -252,8 +289,19 @@ const vk::Queue &Device::transferQueue() const { return transfer.queue; }
 const vk::Device &Device::getDevice() const { return *device; }
 
 const vk::PhysicalDeviceLimits &Device::getLimits() const { return limits; }
+const vk::PipelineCache &Device::getPipelineCache() const {
+  return pipelineCache->cache();
+}
+void Device::savePipelineCache() { pipelineCache->save(); }
+StagingRing &Device::staging() { return *stagingRing; }
+SamplerCache &Device::samplers() { return *samplerCache; }
 
 const vk::PhysicalDeviceRayTracingPropertiesNV &Device::getRayTracingProperties() const {
   return rayTracingProperties;
 }
+const vk::PhysicalDeviceDescriptorIndexingPropertiesEXT &Device::
+  getDescriptorIndexingProperties() const {
+  return descriptorIndexingProperties;
+}
+bool Device::supportsDrawIndirectCount() const { return drawIndirectCount; }
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "vkcommon.h"
 #include "config.h"
+#include "pipeline/pipeline_cache.h"
 #include <vector>
 #include <set>
 
@@ -12,6 +13,8 @@ struct QueueInfo {
 };
 
 class VulkanBase;
+class StagingRing;
+class SamplerCache;
 
 class Device {
 public:
@@ -24,6 +27,7 @@ public:
   __only_move__(Device);
 
   explicit Device(VulkanBase &framework);
+  ~Device();
 
   const vk::PhysicalDevice &getPhysicalDevice() const;
   const vk::PhysicalDeviceMemoryProperties &getMemProps() const;
@@ -43,6 +47,20 @@ public:
   const vk::Queue &transferQueue() const;
   const VmaAllocator &allocator() const;
   const vk::PhysicalDeviceRayTracingPropertiesNV &getRayTracingProperties() const;
+  /**limits of update after bind descriptors; only filled with
+   * FeatureConfig::DescriptorIndexing.*/
+  const vk::PhysicalDeviceDescriptorIndexingPropertiesEXT &
+    getDescriptorIndexingProperties() const;
+  /**whether VK_KHR_draw_indirect_count is enabled, so that draw counts can come from a
+   * buffer.*/
+  bool supportsDrawIndirectCount() const;
+  /**the pipeline cache shared by every pipeline created on this device.*/
+  const vk::PipelineCache &getPipelineCache() const;
+  void savePipelineCache();
+  /**the staging ring that batches uploads to device local resources.*/
+  StagingRing &staging();
+  /**the samplers shared by the textures created on this device.*/
+  SamplerCache &samplers();
 
   void graphicsImmediately(
     const std::function<void(vk::CommandBuffer cb)> &func,
@@ -66,8 +84,11 @@ private:
   FeatureConfig featureConfig;
   vk::PhysicalDeviceFeatures features;
   vk::PhysicalDeviceFeatures2 features2;
+  vk::PhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures;
+  vk::PhysicalDeviceDescriptorIndexingPropertiesEXT descriptorIndexingProperties;
 
   vk::PhysicalDeviceRayTracingPropertiesNV rayTracingProperties;
+  bool drawIndirectCount{false};
 
   vk::UniqueCommandPool graphicsCmdPool;
   QueueInfo graphics;
@@ -78,6 +99,10 @@ private:
   vk::UniqueCommandPool transferCmdPool;
   QueueInfo transfer;
 
+  uPtr<PipelineCache> pipelineCache;
+  uPtr<StagingRing> stagingRing;
+  uPtr<SamplerCache> samplerCache;
+
   void createAllocator();
 };
 }
\ No newline at end of file
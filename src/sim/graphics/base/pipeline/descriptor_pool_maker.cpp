@@ -2,9 +2,14 @@
 namespace sim::graphics {
 
 DescriptorPoolMaker &DescriptorPoolMaker::pipelineLayout(PipelineLayoutDef &def) {
-  for(auto setDef: def.layoutDef().setDefs())
+  // update after bind layouts need pools of their own.
+  uint32_t numSets = 0;
+  for(auto setDef: def.layoutDef().setDefs()) {
+    if(setDef->updateAfterBind()) continue;
     setLayout(*setDef);
-  _numSets += def.numSets();
+    ++numSets;
+  }
+  _numSets += numSets;
   return *this;
 }
 DescriptorPoolMaker &DescriptorPoolMaker::setLayout(DescriptorSetDef &def) {
@@ -115,6 +120,11 @@ auto DescriptorPoolMaker::set(uint32_t numSets) -> DescriptorPoolMaker & {
   return *this;
 }
 
+auto DescriptorPoolMaker::updateAfterBind() -> DescriptorPoolMaker & {
+  _updateAfterBind = true;
+  return *this;
+}
+
 vk::UniqueDescriptorPool DescriptorPoolMaker::createUnique(const vk::Device &device) {
 
   std::vector<vk::DescriptorPoolSize> poolSizes{};
@@ -149,8 +159,10 @@ vk::UniqueDescriptorPool DescriptorPoolMaker::createUnique(const vk::Device &dev
   if(_numAccelerationStructure > 0)
     poolSizes.emplace_back(
       vk::DescriptorType::eAccelerationStructureNV, _numAccelerationStructure);
+  vk::DescriptorPoolCreateFlags flags;
+  if(_updateAfterBind) flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBindEXT;
   vk::DescriptorPoolCreateInfo descriptorPoolInfo{
-    {}, _numSets, (uint32_t)poolSizes.size(), poolSizes.data()};
+    flags, _numSets, (uint32_t)poolSizes.size(), poolSizes.data()};
   return device.createDescriptorPoolUnique(descriptorPoolInfo);
 }
 }
\ No newline at end of file
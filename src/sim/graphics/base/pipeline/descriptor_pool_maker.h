@@ -21,6 +21,8 @@ public:
   DescriptorPoolMaker &storageImage(uint32_t num);
   DescriptorPoolMaker &accelerationStructure(uint32_t num);
   auto set(uint32_t numSets) -> DescriptorPoolMaker &;
+  /**create the pool with update after bind, for sets of update after bind layouts.*/
+  auto updateAfterBind() -> DescriptorPoolMaker &;
   vk::UniqueDescriptorPool createUnique(const vk::Device &device);
 
 private:
@@ -32,5 +34,6 @@ private:
     _numStorageBufferDynamic{0}, _numInputAttachment{0}, _numInlineUniformBlock{0},
     _numAccelerationStructure{0};
   uint32_t _numSets{0};
+  bool _updateAfterBind{false};
 };
 }
\ No newline at end of file
@@ -32,7 +32,7 @@ auto DescriptorSetLayoutMaker::descriptor(
   -> DescriptorSetLayoutMaker & {
   _bindings.emplace_back(binding, descriptorType, descriptorCount, stageFlags, nullptr);
   flags.push_back(bindingFlags);
-  useDescriptorIndexing = bool(bindingFlags);
+  useDescriptorIndexing = useDescriptorIndexing || bool(bindingFlags);
   if(bindingFlags & vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind)
     updateAfterBindPool = true;
   if(bindingFlags & vk::DescriptorBindingFlagBitsEXT::eVariableDescriptorCount)
@@ -62,6 +62,14 @@ auto DescriptorSetLayoutMaker::buffer(
     binding, descriptor::eStorageBuffer, currentStage, descriptorCount, bindingFlags);
 }
 
+auto DescriptorSetLayoutMaker::bufferDynamic(
+  uint32_t binding, uint32_t descriptorCount, vk::DescriptorBindingFlagsEXT bindingFlags)
+  -> DescriptorSetLayoutMaker & {
+  return descriptor(
+    binding, descriptor::eStorageBufferDynamic, currentStage, descriptorCount,
+    bindingFlags);
+}
+
 auto DescriptorSetLayoutMaker::sampler2D(
   uint32_t binding, uint32_t descriptorCount, vk::DescriptorBindingFlagsEXT bindingFlags)
   -> DescriptorSetLayoutMaker & {
@@ -125,6 +133,9 @@ auto DescriptorSetLayoutMaker::getVariableDescriptorCount() const -> uint32_t {
            0 :
            _bindings[variableDescriptorBinding].descriptorCount;
 }
+auto DescriptorSetLayoutMaker::updateAfterBind() const -> bool {
+  return updateAfterBindPool;
+}
 auto DescriptorSetLayoutMaker::bindings() const
   -> const std::vector<vk::DescriptorSetLayoutBinding> & {
   return _bindings;
@@ -319,10 +330,10 @@ auto DescriptorSetUpdater::uniform(uint32_t dstBinding, vk::Buffer buffer)
     dstBinding, 0, descriptor::eUniformBuffer, buffer, 0, VK_WHOLE_SIZE);
 }
 
-auto DescriptorSetUpdater::uniformDynamic(uint32_t dstBinding, vk::Buffer buffer)
+auto DescriptorSetUpdater::uniformDynamic(
+  uint32_t dstBinding, vk::Buffer buffer, vk::DeviceSize range)
   -> DescriptorSetUpdater & {
-  return this->buffer(
-    dstBinding, 0, descriptor::eUniformBufferDynamic, buffer, 0, VK_WHOLE_SIZE);
+  return this->buffer(dstBinding, 0, descriptor::eUniformBufferDynamic, buffer, 0, range);
 }
 
 auto DescriptorSetUpdater::buffer(uint32_t dstBinding, vk::Buffer buffer)
@@ -331,6 +342,12 @@ auto DescriptorSetUpdater::buffer(uint32_t dstBinding, vk::Buffer buffer)
     dstBinding, 0, descriptor::eStorageBuffer, buffer, 0, VK_WHOLE_SIZE);
 }
 
+auto DescriptorSetUpdater::bufferDynamic(
+  uint32_t dstBinding, vk::Buffer buffer, vk::DeviceSize range)
+  -> DescriptorSetUpdater & {
+  return this->buffer(dstBinding, 0, descriptor::eStorageBufferDynamic, buffer, 0, range);
+}
+
 auto DescriptorSetUpdater::beginAccelerationStructures(
   uint32_t dstBinding, uint32_t dstArrayElement) -> AccelerationStructureUpdater {
   vk::WriteDescriptorSet writeDescriptorSet{
@@ -18,6 +18,9 @@ public:
   DescriptorSetLayoutMaker &buffer(
     uint32_t binding, uint32_t descriptorCount = 1,
     vk::DescriptorBindingFlagsEXT bindingFlags = {});
+  DescriptorSetLayoutMaker &bufferDynamic(
+    uint32_t binding, uint32_t descriptorCount = 1,
+    vk::DescriptorBindingFlagsEXT bindingFlags = {});
   DescriptorSetLayoutMaker &sampler2D(
     uint32_t binding, uint32_t descriptorCount = 1,
     vk::DescriptorBindingFlagsEXT bindingFlags = {});
@@ -38,6 +41,8 @@ public:
   vk::UniqueDescriptorSetLayout createUnique(const vk::Device &device) const;
   int getVariableDescriptorBinding() const;
   uint32_t getVariableDescriptorCount() const;
+  /**whether sets of this layout must come from a pool created with update after bind.*/
+  bool updateAfterBind() const;
 
   auto bindings() const -> const std::vector<vk::DescriptorSetLayoutBinding> &;
 
@@ -131,8 +136,11 @@ public:
     uint32_t dstBinding, uint32_t dstArrayElement, vk::DescriptorType descriptorType,
     vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range);
   DescriptorSetUpdater &uniform(uint32_t dstBinding, vk::Buffer buffer);
-  DescriptorSetUpdater &uniformDynamic(uint32_t dstBinding, vk::Buffer buffer);
+  DescriptorSetUpdater &uniformDynamic(
+    uint32_t dstBinding, vk::Buffer buffer, vk::DeviceSize range = VK_WHOLE_SIZE);
   DescriptorSetUpdater &buffer(uint32_t dstBinding, vk::Buffer buffer);
+  DescriptorSetUpdater &bufferDynamic(
+    uint32_t dstBinding, vk::Buffer buffer, vk::DeviceSize range = VK_WHOLE_SIZE);
 
   DescriptorSetUpdater &images(
     uint32_t dstBinding, uint32_t dstArrayElement, vk::DescriptorType descriptorType,
@@ -188,6 +196,16 @@ public:
       .create(_device, pool)[0];
   }
 
+  /**allocate a set whose variable count binding holds variableDescriptorCount
+   * descriptors.*/
+  vk::DescriptorSet createSet(
+    vk::DescriptorPool &pool, uint32_t variableDescriptorCount) {
+    errorIf(!descriptorSetLayout, "descriptorSetLayout hasn't been created!");
+    return DescriptorSetMaker()
+      .layout(*descriptorSetLayout, variableDescriptorCount)
+      .create(_device, pool)[0];
+  }
+
   void update(const vk::DescriptorSet &descriptorSet) {
     errorIf(!_device, "call init() first");
     updater.update(_device, descriptorSet);
@@ -230,8 +248,13 @@ struct DescriptorUniformDynamicUpdater: DescriptorUpdater {
     uint32_t descriptorCount = 1)
     : DescriptorUpdater(layout, updater, binding, descriptorCount) {}
 
-  DescriptorUniformDynamicUpdater &operator()(vk::Buffer buffer) {
-    updater.uniformDynamic(binding, buffer);
+  /**
+   * @param range the size of the window that a dynamic offset selects; must not be
+   * VK_WHOLE_SIZE if the offset is ever non-zero.
+   */
+  DescriptorUniformDynamicUpdater &operator()(
+    vk::Buffer buffer, vk::DeviceSize range = VK_WHOLE_SIZE) {
+    updater.uniformDynamic(binding, buffer, range);
     return *this;
   }
 };
@@ -253,6 +276,20 @@ struct DescriptorBufferUpdater: DescriptorUpdater {
   }
 };
 
+struct DescriptorBufferDynamicUpdater: DescriptorUpdater {
+  explicit DescriptorBufferDynamicUpdater(
+    DescriptorSetLayoutMaker &layout, DescriptorSetUpdater &updater, uint32_t binding,
+    uint32_t descriptorCount = 1)
+    : DescriptorUpdater(layout, updater, binding, descriptorCount) {}
+
+  /**@param range the size of one per-frame slice of buffer.*/
+  DescriptorBufferDynamicUpdater &operator()(
+    vk::Buffer buffer, vk::DeviceSize range = VK_WHOLE_SIZE) {
+    updater.bufferDynamic(binding, buffer, range);
+    return *this;
+  }
+};
+
 struct DescriptorStorageImageUpdater: DescriptorUpdater {
   explicit DescriptorStorageImageUpdater(
     DescriptorSetLayoutMaker &layout, DescriptorSetUpdater &updater, uint32_t binding,
@@ -340,6 +377,11 @@ public:                                  \
 public:                          \
   DescriptorBufferUpdater field{ \
     layout, updater, (layout.shaderStage(stage), layout.buffer(binding), binding++)};
+#define __bufferDynamic__(field, stage) \
+public:                                 \
+  DescriptorBufferDynamicUpdater field{ \
+    layout, updater,                    \
+    (layout.shaderStage(stage), layout.bufferDynamic(binding), binding++)};
 #define __sampler__(field, stage)   \
 public:                             \
   DescriptorSampler2DUpdater field{ \
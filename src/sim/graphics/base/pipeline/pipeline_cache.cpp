@@ -0,0 +1,94 @@
+#include "pipeline_cache.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+namespace sim::graphics {
+namespace {
+constexpr uint32_t cacheMagic = 0x43505353; // "SSPC"
+constexpr uint32_t cacheVersion = 1;
+
+/**the header vulkan itself writes in front of the cache data.*/
+struct VkCacheHeader {
+  uint32_t headerLength;
+  uint32_t headerVersion;
+  uint32_t vendorID;
+  uint32_t deviceID;
+  uint8_t uuid[VK_UUID_SIZE];
+};
+}
+
+PipelineCache::PipelineCache(
+  const vk::PhysicalDevice &physicalDevice, const vk::Device &device, std::string path)
+  : device{device}, path{std::move(path)} {
+  properties = physicalDevice.getProperties();
+
+  auto data = load();
+  vk::PipelineCacheCreateInfo info{{}, data.size(), data.data()};
+  try {
+    pipelineCache = device.createPipelineCacheUnique(info);
+  } catch(const vk::SystemError &e) {
+    debugLog("discarding pipeline cache", this->path, e.what());
+    pipelineCache = device.createPipelineCacheUnique({});
+  }
+}
+
+bool PipelineCache::matches(const Header &header) const {
+  return header.magic == cacheMagic && header.version == cacheVersion &&
+         header.vendorID == properties.vendorID &&
+         header.deviceID == properties.deviceID &&
+         header.driverVersion == properties.driverVersion &&
+         std::memcmp(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+std::vector<char> PipelineCache::load() const {
+  if(path.empty()) return {};
+  auto file = std::ifstream(path, std::ios::binary);
+  if(!file.good()) return {};
+
+  Header header{};
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if(!file || !matches(header) || header.dataSize < sizeof(VkCacheHeader)) {
+    debugLog("pipeline cache", path, "is stale, rebuilding");
+    return {};
+  }
+  std::vector<char> data(header.dataSize);
+  file.read(data.data(), data.size());
+  if(!file) return {};
+
+  VkCacheHeader vkHeader{};
+  std::memcpy(&vkHeader, data.data(), sizeof(vkHeader));
+  if(
+    vkHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+    vkHeader.vendorID != properties.vendorID ||
+    vkHeader.deviceID != properties.deviceID ||
+    std::memcmp(vkHeader.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    return {};
+  debugLog("loaded pipeline cache", path, data.size(), "bytes");
+  return data;
+}
+
+void PipelineCache::save() {
+  if(path.empty()) return;
+  auto data = device.getPipelineCacheData(*pipelineCache);
+
+  Header header{cacheMagic, cacheVersion, properties.vendorID, properties.deviceID,
+                properties.driverVersion};
+  std::memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+  header.dataSize = data.size();
+
+  // write to a temporary file first so that a crash never leaves a torn cache behind.
+  auto tmp = path + ".tmp";
+  {
+    std::ofstream file(tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file.good()) return;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    if(!file) return;
+  }
+  std::remove(path.c_str());
+  std::rename(tmp.c_str(), path.c_str());
+}
+
+const vk::PipelineCache &PipelineCache::cache() const { return *pipelineCache; }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "sim/graphics/base/vkcommon.h"
+#include <string>
+
+namespace sim::graphics {
+/**
+ * A VkPipelineCache that is loaded from and saved back to a file. The file is keyed by
+ * the vendor, device, driver version and pipelineCacheUUID of the physical device; a
+ * file written by any other device or driver is ignored and the cache starts empty.
+ */
+class PipelineCache {
+public:
+  __only_move__(PipelineCache);
+
+  /**
+   * @param path the cache file; an empty path keeps the cache in memory only.
+   */
+  PipelineCache(
+    const vk::PhysicalDevice &physicalDevice, const vk::Device &device, std::string path);
+
+  /**write the current cache data back to the file. */
+  void save();
+
+  const vk::PipelineCache &cache() const;
+
+private:
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t uuid[VK_UUID_SIZE];
+    uint64_t dataSize;
+  };
+
+  std::vector<char> load() const;
+  bool matches(const Header &header) const;
+
+  const vk::Device &device;
+  std::string path;
+  vk::PhysicalDeviceProperties properties;
+  vk::UniquePipelineCache pipelineCache;
+};
+}
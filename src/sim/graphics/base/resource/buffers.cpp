@@ -1,4 +1,5 @@
 #include "buffers.h"
+#include "staging_ring.h"
 
 namespace sim::graphics {
 BufferBase::BufferBase(
@@ -53,15 +54,7 @@ void BufferBase::barrier(
 void DeviceBuffer::upload(
   Device &device, const void *value, vk::DeviceSize sizeInBytes,
   vk::DeviceSize dstOffsetInBytes) {
-  if(sizeInBytes == 0) return;
-  using buf = vk::BufferUsageFlagBits;
-  using pfb = vk::MemoryPropertyFlagBits;
-  auto tmp = HostBuffer{vmaBuffer->allocator, buf::eTransferSrc, sizeInBytes};
-  tmp.updateRaw(value, sizeInBytes);
-  device.graphicsImmediately([&](vk::CommandBuffer cb) {
-    vk::BufferCopy copy{0, dstOffsetInBytes, sizeInBytes};
-    cb.copyBuffer(tmp.buffer(), vmaBuffer->buffer, copy);
-  });
+  device.staging().upload(vmaBuffer->buffer, value, sizeInBytes, dstOffsetInBytes);
 }
 
 void HostCoherentBuffer::updateRaw(
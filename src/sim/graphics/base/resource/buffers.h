@@ -47,8 +47,8 @@ public:
     : BufferBase{allocator, usageFlags, size, VMA_MEMORY_USAGE_GPU_ONLY} {}
 
   /**
-		 * For a device local buffer, copy memory to the buffer object immediately.
-		 * Note that this will stall the pipeline!
+		 * For a device local buffer, stage the memory and record the copy in the device
+		 * staging ring. The copy is submitted by the next StagingRing::flush().
 		 */
   void upload(
     Device &device, const void *value, vk::DeviceSize sizeInBytes,
@@ -143,6 +143,7 @@ public:
   IndexBuffer(const VmaAllocator &allocator, vk::DeviceSize size)
     : DeviceBuffer{allocator,
                    vk::BufferUsageFlagBits::eIndexBuffer |
+                     vk::BufferUsageFlagBits::eTransferSrc |
                      vk::BufferUsageFlagBits::eTransferDst |
                      vk::BufferUsageFlagBits::eStorageBuffer,
                    size} {}
@@ -204,6 +205,7 @@ public:
   VertexBuffer(const VmaAllocator &allocator, vk::DeviceSize size)
     : DeviceBuffer{allocator,
                    vk::BufferUsageFlagBits::eVertexBuffer |
+                     vk::BufferUsageFlagBits::eTransferSrc |
                      vk::BufferUsageFlagBits::eTransferDst |
                      vk::BufferUsageFlagBits::eStorageBuffer,
                    size} {}
@@ -325,10 +327,11 @@ public:
 class IndirectBuffer: public DeviceBuffer {
 public:
   IndirectBuffer(const VmaAllocator &allocator, vk::DeviceSize size)
-    : DeviceBuffer{
-        allocator,
-        vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
-        size} {}
+    : DeviceBuffer{allocator,
+                   vk::BufferUsageFlagBits::eIndirectBuffer |
+                     vk::BufferUsageFlagBits::eStorageBuffer |
+                     vk::BufferUsageFlagBits::eTransferDst,
+                   size} {}
 
   template<class Type, class Allocator>
   IndirectBuffer(Device &device, const std::vector<Type, Allocator> &value)
@@ -340,7 +343,11 @@ public:
 class HostIndirectBuffer: public HostBuffer {
 public:
   HostIndirectBuffer(const VmaAllocator &allocator, vk::DeviceSize size)
-    : HostBuffer{allocator, vk::BufferUsageFlagBits::eIndirectBuffer, size} {}
+    : HostBuffer{
+        allocator,
+        vk::BufferUsageFlagBits::eIndirectBuffer |
+          vk::BufferUsageFlagBits::eStorageBuffer,
+        size} {}
 
   template<class Type>
   HostIndirectBuffer(const VmaAllocator &allocator, const Type &value)
@@ -89,7 +89,12 @@ vk::UniqueImageView Texture::createImageView(
   return device.createImageViewUnique(viewCreateInfo);
 }
 
-void Texture::setSampler(vk::UniqueSampler &&sampler) { _sampler = std::move(sampler); }
+void Texture::setSampler(vk::UniqueSampler &&sampler) {
+  _sampler = std::make_shared<const vk::UniqueSampler>(std::move(sampler));
+}
+void Texture::setSampler(SamplerCache::SharedSampler sampler) {
+  _sampler = std::move(sampler);
+}
 
 void Texture::clear(const vk::CommandBuffer &cb, const std::array<float, 4> &color) {
   setLayoutByGuess(cb, layout::eTransferDstOptimal);
@@ -108,7 +113,10 @@ vk::ImageSubresourceRange Texture::subresourceRange(
   const vk::ImageAspectFlags &aspectMask) const {
   return {aspectMask, 0, _info.mipLevels, 0, _info.arrayLayers};
 }
-const vk::Sampler &Texture::sampler() const { return *_sampler; }
+const vk::Sampler &Texture::sampler() const {
+  static const vk::Sampler none{};
+  return _sampler ? **_sampler : none;
+}
 const vk::ImageCreateInfo &Texture::getInfo() const { return _info; }
 
 }
@@ -1,5 +1,8 @@
 #pragma once
 #include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include "sim/graphics/base/vkcommon.h"
 #include "sim/graphics/base/pipeline/sampler.h"
 #include "sim/graphics/base/device.h"
@@ -7,6 +10,39 @@
 namespace sim::graphics {
 uint32_t calcMipLevels(uint32_t dim);
 
+/**
+ * Samplers shared by all the textures created with the same sampler create info. A
+ * sampler lives as long as a texture holds it; drivers limit the number of live
+ * samplers, often to about 4000.
+ */
+class SamplerCache {
+public:
+  using SharedSampler = std::shared_ptr<const vk::UniqueSampler>;
+  struct Stats {
+    /**acquires served by a live sampler, and the ones that created a sampler.*/
+    uint64_t hits{0}, misses{0};
+    /**number of live samplers.*/
+    uint32_t live{0};
+  };
+
+  explicit SamplerCache(const vk::Device &device);
+  /**@return the live sampler created with info, or a new one. Thread safe.*/
+  SharedSampler acquire(const vk::SamplerCreateInfo &info);
+  /**forget the samplers no texture holds anymore, and count the others.*/
+  Stats stats();
+
+private:
+  struct Hash {
+    size_t operator()(const vk::SamplerCreateInfo &info) const;
+  };
+
+  vk::Device device;
+  std::mutex mutex;
+  std::unordered_map<vk::SamplerCreateInfo, std::weak_ptr<const vk::UniqueSampler>, Hash>
+    samplers;
+  uint64_t hits{0}, misses{0};
+};
+
 /**
 	 * Generic image with a view and memory object.
 	 * Vulkan images need a memory object to hold the data and a view object for
@@ -83,6 +119,7 @@ public:
     vk::ImageLayout newLayout, vk::AccessFlags dstAccess,
     vk::PipelineStageFlagBits dstStage);
   void setSampler(vk::UniqueSampler &&sampler);
+  void setSampler(SamplerCache::SharedSampler sampler);
   void setImageView(
     const vk::Device &device, vk::ImageViewType viewType,
     const vk::ImageAspectFlags &aspectMask);
@@ -138,7 +175,7 @@ protected:
   bool mappable{false};
 
   vk::UniqueImageView _imageView;
-  vk::UniqueSampler _sampler;
+  SamplerCache::SharedSampler _sampler;
   vk::ImageLayout currentLayout;
   vk::AccessFlags srcAccess;
   vk::PipelineStageFlagBits srcStage{vk::PipelineStageFlagBits::eAllCommands};
@@ -171,6 +208,9 @@ uPtr<Texture> depthStencilInputAttachmentUnique(
   vk::Format format = vk::Format::eD24UnormS8Uint,
   vk::SampleCountFlagBits sampleCount = vk::SampleCountFlagBits::e1);
 
+/**a full mip chain of single channel floats, written by compute and sampled.*/
+uPtr<Texture> depthPyramidUnique(Device &device, uint32_t width, uint32_t height);
+
 }
 
 class Texture2D: public Texture {
@@ -203,9 +243,14 @@ public:
     Device &device, uint32_t width, uint32_t height, uint32_t mipLevels = 1,
     vk::Format format = vk::Format::eR16G16B16A16Sfloat);
 
+  /**hash of the faces and levels the cube was loaded with; 0 if it was not loaded.*/
+  uint64_t contentHash() const;
+
 private:
   static vk::ImageCreateInfo info(
     uint32_t width, uint32_t height, uint32_t mipLevels, vk::Format format);
+
+  uint64_t _contentHash{0};
 };
 
 class SamplerMaker {
@@ -229,6 +274,8 @@ public:
   SamplerMaker &borderColor(vk::BorderColor value);
   SamplerMaker &unnormalizedCoordinates(vk::Bool32 value);
   vk::UniqueSampler createUnique(const vk::Device &device) const;
+  /**@return the sampler of the device's sampler cache with this create info.*/
+  SamplerCache::SharedSampler createShared(Device &device) const;
   vk::Sampler create(const vk::Device &device) const;
 
 private:
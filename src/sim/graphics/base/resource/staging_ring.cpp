@@ -0,0 +1,164 @@
+#include "staging_ring.h"
+
+namespace sim::graphics {
+using access = vk::AccessFlagBits;
+using stage = vk::PipelineStageFlagBits;
+
+namespace {
+vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+}
+
+StagingRing::StagingRing(Device &device, vk::DeviceSize capacity)
+  : device{device}, capacity{capacity} {
+  ring = u<UploadBuffer>(device.allocator(), capacity);
+}
+
+StagingRing::~StagingRing() {
+  flush();
+  while(!inFlight.empty())
+    retire(true);
+  std::vector<vk::CommandBuffer> cbs;
+  for(auto &batch: freeBatches)
+    cbs.push_back(batch.cb);
+  if(current.cb) cbs.push_back(current.cb);
+  if(!cbs.empty())
+    device.getDevice().freeCommandBuffers(device.getGraphicsCMDPool(), cbs);
+}
+
+auto StagingRing::upload(
+  vk::Buffer dst, const void *data, vk::DeviceSize sizeInBytes,
+  vk::DeviceSize dstOffsetInBytes) -> Ticket {
+  return upload(
+    data, sizeInBytes, 16,
+    [&](vk::CommandBuffer cb, vk::Buffer src, vk::DeviceSize srcOffset) {
+      vk::BufferCopy copy{srcOffset, dstOffsetInBytes, sizeInBytes};
+      cb.copyBuffer(src, dst, copy);
+    });
+}
+
+auto StagingRing::upload(
+  const void *data, vk::DeviceSize sizeInBytes, vk::DeviceSize alignment,
+  const Recorder &record) -> Ticket {
+  std::lock_guard<std::recursive_mutex> lock{mutex};
+  if(sizeInBytes == 0) return nextTicket;
+  alignment = std::max(alignment, device.getLimits().optimalBufferCopyOffsetAlignment);
+
+  if(sizeInBytes > capacity / 2) {
+    // not worth draining the ring for; stage it separately and free it with the batch.
+    auto tmp = u<HostBuffer>(
+      device.allocator(), vk::BufferUsageFlagBits::eTransferSrc, sizeInBytes);
+    tmp->updateRaw(data, sizeInBytes);
+    auto cb = begin();
+    record(cb, tmp->buffer(), 0);
+    current.oversized.push_back(std::move(tmp));
+    return nextTicket;
+  }
+
+  auto offset = allocate(sizeInBytes, alignment);
+  ring->updateRaw(data, sizeInBytes, offset);
+  auto cb = begin();
+  record(cb, ring->buffer(), offset);
+  return nextTicket;
+}
+
+vk::DeviceSize StagingRing::allocate(
+  vk::DeviceSize sizeInBytes, vk::DeviceSize alignment) {
+  while(true) {
+    if(!recording && inFlight.empty()) head = tail = 0;
+    auto offset = alignUp(head, alignment);
+    // head == tail means empty, so the ring is never allowed to fill up completely.
+    if(tail <= head) {
+      if(offset + sizeInBytes <= capacity) {
+        head = offset + sizeInBytes;
+        return offset;
+      }
+      if(sizeInBytes < tail) {
+        head = sizeInBytes;
+        return 0;
+      }
+    } else if(offset + sizeInBytes < tail) {
+      head = offset + sizeInBytes;
+      return offset;
+    }
+    // out of space: hand the pending copies to the device and wait for the oldest batch.
+    if(recording) submit();
+    retire(true);
+  }
+}
+
+vk::CommandBuffer StagingRing::begin() {
+  if(recording) return current.cb;
+  if(!freeBatches.empty()) {
+    current = std::move(freeBatches.back());
+    freeBatches.pop_back();
+  } else {
+    current = {};
+    current.cb = device.getDevice().allocateCommandBuffers(
+      {device.getGraphicsCMDPool(), vk::CommandBufferLevel::ePrimary, 1})[0];
+    current.fence = device.getDevice().createFenceUnique({});
+  }
+  current.ticket = nextTicket;
+  current.cb.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+  recording = true;
+  return current.cb;
+}
+
+auto StagingRing::submit() -> Ticket {
+  // make the copies visible to everything submitted after this batch.
+  vk::MemoryBarrier barrier{access::eTransferWrite, access::eMemoryRead};
+  current.cb.pipelineBarrier(
+    stage::eTransfer, stage::eAllCommands, {}, barrier, nullptr, nullptr);
+  current.cb.end();
+
+  vk::SubmitInfo submit;
+  submit.commandBufferCount = 1;
+  submit.pCommandBuffers = &current.cb;
+  device.graphicsQueue().submit(submit, *current.fence);
+
+  current.end = head;
+  inFlight.push_back(std::move(current));
+  current = {};
+  recording = false;
+  return nextTicket++;
+}
+
+void StagingRing::retire(bool block) {
+  auto &vkDevice = device.getDevice();
+  while(!inFlight.empty()) {
+    auto &batch = inFlight.front();
+    if(block)
+      vkDevice.waitForFences(*batch.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    else if(vkDevice.getFenceStatus(*batch.fence) != vk::Result::eSuccess)
+      return;
+    vkDevice.resetFences(*batch.fence);
+    batch.cb.reset({});
+    batch.oversized.clear();
+    tail = batch.end;
+    completed = batch.ticket;
+    freeBatches.push_back(std::move(batch));
+    inFlight.pop_front();
+    if(block) return;
+  }
+}
+
+auto StagingRing::flush() -> Ticket {
+  std::lock_guard<std::recursive_mutex> lock{mutex};
+  if(recording) return submit();
+  return nextTicket - 1;
+}
+
+void StagingRing::wait(Ticket ticket) {
+  std::lock_guard<std::recursive_mutex> lock{mutex};
+  if(recording && ticket >= current.ticket) flush();
+  while(completed < ticket && !inFlight.empty())
+    retire(true);
+}
+
+bool StagingRing::finished(Ticket ticket) {
+  std::lock_guard<std::recursive_mutex> lock{mutex};
+  retire(false);
+  return completed >= ticket;
+}
+}
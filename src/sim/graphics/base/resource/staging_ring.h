@@ -0,0 +1,71 @@
+#pragma once
+#include "buffers.h"
+#include <deque>
+#include <mutex>
+
+namespace sim::graphics {
+/**
+ * A persistent host-visible staging arena that is allocated as a ring. Copies are
+ * recorded into a shared command buffer and submitted together by flush(); the ring
+ * space of a batch is reclaimed once its fence has signaled.
+ */
+class StagingRing {
+public:
+  /**identifies a batch of copies; batches complete in submission order.*/
+  using Ticket = uint64_t;
+  using Recorder =
+    std::function<void(vk::CommandBuffer cb, vk::Buffer src, vk::DeviceSize srcOffset)>;
+
+  __only_move__(StagingRing);
+  StagingRing(Device &device, vk::DeviceSize capacity);
+  ~StagingRing();
+
+  /**
+   * stage the bytes and record a copy into dst. The source can be released as soon as
+   * this returns, but the copy is only submitted by the next flush().
+   */
+  Ticket upload(
+    vk::Buffer dst, const void *data, vk::DeviceSize sizeInBytes,
+    vk::DeviceSize dstOffsetInBytes = 0);
+
+  /**stage the bytes and let record() emit the commands that consume them.*/
+  Ticket upload(
+    const void *data, vk::DeviceSize sizeInBytes, vk::DeviceSize alignment,
+    const Recorder &record);
+
+  /**submit the pending copies, if any. @return the ticket of the last submitted batch.*/
+  Ticket flush();
+  /**block until the batch of ticket has completed on the device.*/
+  void wait(Ticket ticket);
+  /**@return true if the batch of ticket has completed, without blocking.*/
+  bool finished(Ticket ticket);
+
+private:
+  struct Batch {
+    vk::CommandBuffer cb;
+    vk::UniqueFence fence;
+    Ticket ticket{0};
+    /**ring head when the batch was submitted; the tail moves here on retire.*/
+    vk::DeviceSize end{0};
+    /**staging buffers for uploads larger than the whole ring.*/
+    std::vector<uPtr<HostBuffer>> oversized;
+  };
+
+  vk::DeviceSize allocate(vk::DeviceSize sizeInBytes, vk::DeviceSize alignment);
+  vk::CommandBuffer begin();
+  Ticket submit();
+  void retire(bool block);
+
+  Device &device;
+  uPtr<UploadBuffer> ring;
+  vk::DeviceSize capacity, head{0}, tail{0};
+
+  Batch current;
+  bool recording{false};
+  std::deque<Batch> inFlight;
+  std::vector<Batch> freeBatches;
+  Ticket nextTicket{1}, completed{0};
+
+  std::recursive_mutex mutex;
+};
+}
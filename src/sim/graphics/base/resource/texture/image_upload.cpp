@@ -1,5 +1,6 @@
 #include "../images.h"
 #include "../buffers.h"
+#include "../staging_ring.h"
 #include "sim/util/syntactic_sugar.h"
 
 #include <stb_image.h>
@@ -16,13 +17,13 @@ void Texture::upload(
 void Texture::upload(
   Device &device, const unsigned char *bytes, size_t sizeInBytes,
   bool transitToShaderRead) {
-  HostBuffer stagingBuffer{vmaImage->allocator, buffer::eTransferSrc,
-                           static_cast<vk::DeviceSize>(sizeInBytes)};
-  stagingBuffer.updateRaw(reinterpret_cast<const void *>(bytes), sizeInBytes);
-  device.graphicsImmediately([&](vk::CommandBuffer cb) {
-    auto buf = stagingBuffer.buffer();
-    copy(cb, buf, 0, 0, _info.extent.width, _info.extent.height, _info.extent.depth, 0);
-    if(transitToShaderRead) setLayoutByGuess(cb, layout::eShaderReadOnlyOptimal);
-  });
+  device.staging().upload(
+    bytes, sizeInBytes, 16,
+    [&](vk::CommandBuffer cb, vk::Buffer buf, vk::DeviceSize offset) {
+      copy(
+        cb, buf, 0, 0, _info.extent.width, _info.extent.height, _info.extent.depth,
+        uint32_t(offset));
+      if(transitToShaderRead) setLayoutByGuess(cb, layout::eShaderReadOnlyOptimal);
+    });
 }
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "../images.h"
 #include "../buffers.h"
+#include <cstring>
 
 namespace sim::graphics {
 
@@ -181,4 +182,63 @@ vk::UniqueSampler SamplerMaker::createUnique(const vk::Device &device) const {
 vk::Sampler SamplerMaker::create(const vk::Device &device) const {
   return device.createSampler(state.info);
 }
+
+auto SamplerMaker::createShared(Device &device) const -> SamplerCache::SharedSampler {
+  return device.samplers().acquire(state.info);
+}
+
+SamplerCache::SamplerCache(const vk::Device &device): device{device} {}
+
+size_t SamplerCache::Hash::operator()(const vk::SamplerCreateInfo &info) const {
+  size_t seed = 0;
+  auto combine = [&](uint32_t value) {
+    seed ^= std::hash<uint32_t>{}(value) + 0x9e3779b9 + (seed << 6u) + (seed >> 2u);
+  };
+  auto bits = [](float value) {
+    uint32_t result;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+  };
+  combine(uint32_t(VkSamplerCreateFlags(info.flags)));
+  combine(uint32_t(info.magFilter));
+  combine(uint32_t(info.minFilter));
+  combine(uint32_t(info.mipmapMode));
+  combine(uint32_t(info.addressModeU));
+  combine(uint32_t(info.addressModeV));
+  combine(uint32_t(info.addressModeW));
+  combine(bits(info.mipLodBias));
+  combine(info.anisotropyEnable);
+  combine(bits(info.maxAnisotropy));
+  combine(info.compareEnable);
+  combine(uint32_t(info.compareOp));
+  combine(bits(info.minLod));
+  combine(bits(info.maxLod));
+  combine(uint32_t(info.borderColor));
+  combine(info.unnormalizedCoordinates);
+  return seed;
+}
+
+auto SamplerCache::acquire(const vk::SamplerCreateInfo &info) -> SharedSampler {
+  errorIf(info.pNext != nullptr, "extended samplers can't be shared!");
+  std::lock_guard<std::mutex> lock{mutex};
+  auto &cached = samplers[info];
+  if(auto sampler = cached.lock()) {
+    ++hits;
+    return sampler;
+  }
+  ++misses;
+  auto sampler =
+    std::make_shared<const vk::UniqueSampler>(device.createSamplerUnique(info));
+  cached = sampler;
+  return sampler;
+}
+
+auto SamplerCache::stats() -> Stats {
+  std::lock_guard<std::mutex> lock{mutex};
+  for(auto it = samplers.begin(); it != samplers.end();)
+    if(it->second.expired()) it = samplers.erase(it);
+    else
+      ++it;
+  return {hits, misses, uint32_t(samplers.size())};
+}
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "../images.h"
 #include "../buffers.h"
+#include "../staging_ring.h"
 #include "sim/util/syntactic_sugar.h"
+#include "sim/util/hash.h"
 
 #include <stb_image.h>
 #include <gli/gli.hpp>
@@ -24,26 +26,26 @@ TextureImageCube TextureImageCube::loadFromFile(
   auto extent = tex.extent();
   uint32_t texWidth = extent.x, texHeight = extent.y, miplevels = tex.levels();
   auto texture = TextureImageCube{device, texWidth, texHeight, miplevels};
+  texture._contentHash = util::fnv1a(tex.data(), tex.size());
+  uint32_t dims[]{texWidth, texHeight, miplevels};
+  texture._contentHash = util::fnv1a(dims, sizeof(dims), texture._contentHash);
 
-  HostBuffer stagingBuffer{device.allocator(), buffer::eTransferSrc,
-                           static_cast<vk::DeviceSize>(tex.size())};
-  stagingBuffer.updateRaw(tex.data(), tex.size());
+  device.staging().upload(
+    tex.data(), tex.size(), 16,
+    [&](vk::CommandBuffer cb, vk::Buffer buf, vk::DeviceSize stagingOffset) {
+      texture.setLayoutByGuess(cb, layout::eTransferDstOptimal);
 
-  device.graphicsImmediately([&](vk::CommandBuffer cb) {
-    auto buf = stagingBuffer.buffer();
-
-    texture.setLayoutByGuess(cb, layout::eTransferDstOptimal);
-
-    size_t offset = 0;
-    for(uint32_t face = 0; face < 6; face++)
-      for(uint32_t mipLevel = 0; mipLevel < miplevels; ++mipLevel) {
-        auto extent = tex[face][mipLevel].extent();
-        texture.copy(
-          cb, buf, mipLevel, face, uint32_t(extent.x), uint32_t(extent.y), 1, offset);
-        offset += tex[face][mipLevel].size();
-      }
-    texture.setLayoutByGuess(cb, layout::eShaderReadOnlyOptimal);
-  });
+      auto offset = stagingOffset;
+      for(uint32_t face = 0; face < 6; face++)
+        for(uint32_t mipLevel = 0; mipLevel < miplevels; ++mipLevel) {
+          auto extent = tex[face][mipLevel].extent();
+          texture.copy(
+            cb, buf, mipLevel, face, uint32_t(extent.x), uint32_t(extent.y), 1,
+            uint32_t(offset));
+          offset += tex[face][mipLevel].size();
+        }
+      texture.setLayoutByGuess(cb, layout::eShaderReadOnlyOptimal);
+    });
 
   return texture;
 }
@@ -55,6 +57,8 @@ TextureImageCube::TextureImageCube(
     device.getDevice(), vk::ImageViewType::eCube, vk::ImageAspectFlagBits::eColor);
 }
 
+uint64_t TextureImageCube::contentHash() const { return _contentHash; }
+
 vk::ImageCreateInfo TextureImageCube::info(
   uint32_t width, uint32_t height, uint32_t mipLevels, vk::Format format) {
   return {vk::ImageCreateFlagBits::eCubeCompatible,
@@ -1,6 +1,7 @@
 #include "../images.h"
 #include "../buffers.h"
 #include "sim/util/syntactic_sugar.h"
+#include <algorithm>
 
 namespace sim::graphics::image {
 using aspect = vk::ImageAspectFlagBits;
@@ -88,8 +89,24 @@ uPtr<Texture> depthStencilInputAttachmentUnique(
                                             sampleCount,
                                             vk::ImageTiling::eOptimal,
                                             imageUsage::eDepthStencilAttachment |
-                                              imageUsage::eInputAttachment});
+                                              imageUsage::eInputAttachment |
+                                              imageUsage::eSampled});
   texture->setImageView(device.getDevice(), vk::ImageViewType::e2D, aspect::eDepth);
   return texture;
 }
+
+uPtr<Texture> depthPyramidUnique(Device &device, uint32_t width, uint32_t height) {
+  auto texture = u<Texture>(
+    device.allocator(), vk::ImageCreateInfo{{},
+                                            vk::ImageType::e2D,
+                                            vk::Format::eR32Sfloat,
+                                            {width, height, 1U},
+                                            calcMipLevels(std::max(width, height)),
+                                            1,
+                                            vk::SampleCountFlagBits::e1,
+                                            vk::ImageTiling::eOptimal,
+                                            imageUsage::eSampled | imageUsage::eStorage});
+  texture->setImageView(device.getDevice(), vk::ImageViewType::e2D, aspect::eColor);
+  return texture;
+}
 }
\ No newline at end of file
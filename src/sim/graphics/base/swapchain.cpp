@@ -42,7 +42,14 @@ vk::Extent2D chooseExtent(
 Swapchain::Swapchain(const VulkanBase &framework)
   : base{framework},
     physicalDevice{base.device->getPhysicalDevice()},
-    vkDevice{base.device->getDevice()} {
+    vkDevice{base.device->getDevice()},
+    _headless{base.config.headless} {
+  if(_headless) {
+    surfaceFormat = {vk::Format::eB8G8R8A8Unorm, vk::ColorSpaceKHR::eSrgbNonlinear};
+    presentQueue = base.device->getGraphics().queue;
+    imageCount = std::max(base.config.numFrame, 1u);
+    return;
+  }
   auto presentModes = physicalDevice.getSurfacePresentModesKHR(*base.surface);
   presentMode = choosePresentMode(presentModes, base.config.vsync);
 
@@ -56,6 +63,10 @@ Swapchain::Swapchain(const VulkanBase &framework)
 }
 
 void Swapchain::resize() {
+  if(_headless) {
+    createOffscreenImages();
+    return;
+  }
   auto cap = physicalDevice.getSurfaceCapabilitiesKHR(*base.surface);
   imageExtent = chooseExtent(base.window, cap);
 
@@ -104,8 +115,46 @@ void Swapchain::resize() {
   }
 }
 
+void Swapchain::createOffscreenImages() {
+  using usage = vk::ImageUsageFlagBits;
+  imageExtent = vk::Extent2D{base.config.width, base.config.height};
+
+  imageViews.clear();
+  images.clear();
+  offscreenImages.clear();
+  for(auto i = 0u; i < imageCount; i++) {
+    auto image = u<Texture>(
+      base.device->allocator(),
+      vk::ImageCreateInfo{{},
+                          vk::ImageType::e2D,
+                          surfaceFormat.format,
+                          {imageExtent.width, imageExtent.height, 1U},
+                          1,
+                          1,
+                          vk::SampleCountFlagBits::e1,
+                          vk::ImageTiling::eOptimal,
+                          usage::eColorAttachment | usage::eTransferDst |
+                            usage::eTransferSrc});
+    images.push_back(image->image());
+
+    vk::ImageViewCreateInfo imageViewInfo;
+    imageViewInfo.image = images[i];
+    imageViewInfo.viewType = vk::ImageViewType::e2D;
+    imageViewInfo.format = surfaceFormat.format;
+    imageViewInfo.subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
+    imageViews.push_back(vkDevice.createImageViewUnique(imageViewInfo));
+    offscreenImages.push_back(std::move(image));
+  }
+  nextImage = 0;
+}
+
 vk::Result Swapchain::acquireNextImage(
   const vk::Semaphore &imageAvailableSemaphore, uint32_t &imageIndex) {
+  if(_headless) {
+    imageIndex = nextImage;
+    nextImage = (nextImage + 1) % imageCount;
+    return vk::Result::eSuccess;
+  }
   return vkDevice.acquireNextImageKHR(
     *swapchain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphore,
     vk::Fence(), &imageIndex);
@@ -113,6 +162,7 @@ vk::Result Swapchain::acquireNextImage(
 
 vk::Result Swapchain::present(
   const uint32_t &imageIndex, const vk::Semaphore &renderFinishedSemaphore) {
+  if(_headless) return vk::Result::eSuccess;
   vk::PresentInfoKHR presentInfo;
   presentInfo.waitSemaphoreCount = 1;
   presentInfo.pWaitSemaphores = &renderFinishedSemaphore;
@@ -126,4 +176,9 @@ vk::Result Swapchain::present(
 vk::ImageSubresourceRange Swapchain::subresourceRange() const {
   return {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
 }
+
+vk::ImageLayout Swapchain::presentLayout() const {
+  return _headless ? vk::ImageLayout::eTransferSrcOptimal :
+                     vk::ImageLayout::ePresentSrcKHR;
+}
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "vkcommon.h"
 #include "device.h"
+#include "resource/images.h"
 
 namespace sim::graphics {
 class VulkanBase;
@@ -17,12 +18,18 @@ public:
     const uint32_t &imageIndex, const vk::Semaphore &renderFinishedSemaphore);
 
   vk::ImageSubresourceRange subresourceRange() const;
+  /**layout the rendered image should be left in at the end of a frame.*/
+  vk::ImageLayout presentLayout() const;
 
   vk::Format &getImageFormat() { return surfaceFormat.format; }
   const vk::Extent2D &getImageExtent() const { return imageExtent; }
   const std::vector<vk::UniqueImageView> &getImageViews() const { return imageViews; }
   vk::Image &getImage(uint32_t index) { return images[index]; }
   const uint32_t &getImageCount() const { return imageCount; }
+  bool headless() const { return _headless; }
+
+private:
+  void createOffscreenImages();
 
 private:
   const VulkanBase &base;
@@ -39,5 +46,9 @@ private:
   vk::Extent2D imageExtent;
   std::vector<vk::Image> images;
   std::vector<vk::UniqueImageView> imageViews;
+
+  bool _headless{false};
+  std::vector<uPtr<Texture>> offscreenImages;
+  uint32_t nextImage{0};
 };
 }
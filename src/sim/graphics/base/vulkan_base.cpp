@@ -61,13 +61,15 @@ VulkanBase::VulkanBase(
   const DebugConfig &debugConfig)
   : config{config}, featureConfig{featureConfig}, debugConfig{debugConfig} {
   input.gui = config.gui;
-  createWindow();
+  if(!config.headless) createWindow();
   createVkInstance();
   createDebug();
   device = u<Device>(*this);
   checkConfig();
   debugMarker = {device->getDevice()};
   swapchain = u<Swapchain>(*this);
+  // per-frame resources are indexed by the swapchain image index.
+  config.numFrame = swapchain->getImageCount();
   VulkanBase::resize();
 
   createSyncObjects();
@@ -88,6 +90,10 @@ auto VulkanBase::run(CallFrameUpdater &updater) -> void {
 }
 
 auto VulkanBase::run(std::function<void(uint32_t, float)> updater) -> void {
+  if(config.headless) {
+    runHeadless(updater);
+    return;
+  }
   glfwSetTime(0.0);
   auto prevTime = 0.0;
   while(!glfwWindowShouldClose(window)) {
@@ -108,15 +114,33 @@ auto VulkanBase::run(std::function<void(uint32_t, float)> updater) -> void {
   terminate();
 }
 
+void VulkanBase::runHeadless(std::function<void(uint32_t, float)> &updater) {
+  using clock = std::chrono::steady_clock;
+  auto prevTime = clock::now();
+  while(!shouldClose) {
+    auto curTime = clock::now();
+    auto deltaTime = std::chrono::duration<float>(curTime - prevTime).count();
+    prevTime = curTime;
+
+    update(updater, deltaTime);
+  }
+  terminate();
+}
+
 void VulkanBase::setWindowTitle(const std::string &title) {
-  glfwSetWindowTitle(window, title.c_str());
+  if(window) glfwSetWindowTitle(window, title.c_str());
 }
 
-void VulkanBase::closeWindow() { glfwSetWindowShouldClose(window, true); }
+void VulkanBase::closeWindow() {
+  shouldClose = true;
+  if(window) glfwSetWindowShouldClose(window, true);
+}
 
 auto VulkanBase::terminate() -> void {
   device->getDevice().waitIdle();
+  device->savePipelineCache();
   dispose();
+  if(config.headless) return;
   glfwDestroyWindow(window);
   glfwTerminate();
 }
@@ -166,7 +190,8 @@ bool VulkanBase::createVkInstance() {
 
   vk::ApplicationInfo appInfo;
 
-  std::vector<const char *> extensions{getGLFWRequiredInstanceExtensions()}, layers;
+  std::vector<const char *> extensions, layers;
+  if(!config.headless) extensions = getGLFWRequiredInstanceExtensions();
   if(featureConfig & FeatureConfig::DescriptorIndexing)
     extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
   if(debugConfig.enableValidationLayer) {
@@ -188,6 +213,7 @@ bool VulkanBase::createVkInstance() {
   vkInstance = createInstanceUnique(instanceInfo.get<vk::InstanceCreateInfo>());
   VULKAN_HPP_DEFAULT_DISPATCHER.init(*vkInstance);
 
+  if(config.headless) return true;
   VkSurfaceKHR _surface;
   glfwCreateWindowSurface(*vkInstance, window, nullptr, &_surface);
   surface = vk::UniqueSurfaceKHR{
@@ -227,6 +253,7 @@ void VulkanBase::createSyncObjects() {
   auto numFrames = swapchain->getImageCount();
   semaphores.resize(numFrames);
   inFlightFrameFences.resize(numFrames);
+  imagesInFlight.resize(numFrames);
   vk::FenceCreateInfo fenceInfo{vk::FenceCreateFlagBits::eSignaled};
   for(uint32_t i = 0; i < swapchain->getImageCount(); i++) {
     semaphores[i].imageAvailable = _device.createSemaphoreUnique({});
@@ -234,10 +261,13 @@ void VulkanBase::createSyncObjects() {
     semaphores[i].computeFinished = _device.createSemaphoreUnique({});
     semaphores[i].renderFinished = _device.createSemaphoreUnique({});
 
-    semaphores[i].renderWaits.push_back(*semaphores[i].imageAvailable);
+    // offscreen images are never acquired, so there is nothing to wait for.
+    if(!config.headless) {
+      semaphores[i].renderWaits.push_back(*semaphores[i].imageAvailable);
+      semaphores[i].renderWaitStages.emplace_back(stage::eAllCommands);
+    }
     semaphores[i].renderWaits.push_back(*semaphores[i].computeFinished);
     semaphores[i].renderWaitStages.emplace_back(stage::eAllCommands);
-    semaphores[i].renderWaitStages.emplace_back(stage::eAllCommands);
 
     inFlightFrameFences[i] = _device.createFenceUnique(fenceInfo);
   }
@@ -267,7 +297,6 @@ void VulkanBase::update(std::function<void(uint32_t, float)> &updater, float dt)
   auto frameFinishedFence = *inFlightFrameFences[frameIndex];
   auto result =
     vkDevice.waitForFences(frameFinishedFence, 1, std::numeric_limits<uint64_t>::max());
-  vkDevice.resetFences(frameFinishedFence);
 
   uint32_t imageIndex = 0;
   try {
@@ -284,12 +313,19 @@ void VulkanBase::update(std::function<void(uint32_t, float)> &updater, float dt)
     input.resizeWanted = false;
   }
 
+  // the image may still be in use by an earlier frame that has a different frameIndex.
+  if(imagesInFlight[imageIndex])
+    result = vkDevice.waitForFences(
+      imagesInFlight[imageIndex], 1, std::numeric_limits<uint64_t>::max());
+  imagesInFlight[imageIndex] = frameFinishedFence;
+
+  // uploads issued by the last frame may be read by any queue below.
+  device->staging().wait(device->staging().flush());
+
   auto &graphicsCB = graphicsCmdBuffers[imageIndex];
   auto &computeCB = computeCmdBuffers[imageIndex];
   auto &transferCB = transferCmdBuffers[imageIndex];
 
-  auto &swapchainImage = swapchain->getImage(imageIndex);
-
   transferCB.begin({cbFlag::eSimultaneousUse});
   computeCB.begin({cbFlag ::eSimultaneousUse});
   graphicsCB.begin({cbFlag::eSimultaneousUse});
@@ -321,11 +357,13 @@ void VulkanBase::update(std::function<void(uint32_t, float)> &updater, float dt)
   submit.pSignalSemaphores = &(*semaphore.computeFinished);
   device->computeQueue().submit(submit, vk::Fence{});
 
+  vkDevice.resetFences(frameFinishedFence);
   submit.pCommandBuffers = &graphicsCB;
   submit.waitSemaphoreCount = uint32_t(semaphore.renderWaits.size());
   submit.pWaitSemaphores = semaphore.renderWaits.data();
   submit.pWaitDstStageMask = semaphore.renderWaitStages.data();
-  submit.signalSemaphoreCount = 1;
+  // nothing presents offscreen images, so nothing would wait for renderFinished.
+  submit.signalSemaphoreCount = config.headless ? 0 : 1;
   submit.pSignalSemaphores = &(*semaphore.renderFinished);
   device->graphicsQueue().submit(submit, frameFinishedFence);
 
@@ -343,10 +381,5 @@ void VulkanBase::update(std::function<void(uint32_t, float)> &updater, float dt)
   }
 
   frameIndex = (frameIndex + 1) % swapchain->getImageCount();
-  //  device->presentQueue().waitIdle();
-  //  device->transferQueue().waitIdle();
-  //  device->graphicsQueue().waitIdle();
-  //  device->computeQueue().waitIdle();
-  device->getDevice().waitIdle();
 }
 }
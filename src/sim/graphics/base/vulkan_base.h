@@ -46,6 +46,8 @@ protected:
 
   virtual void resize();
 
+  void runHeadless(std::function<void(uint32_t, float)> &updater);
+
   void update(std::function<void(uint32_t, float)> &updater, float dt);
 
   virtual void updateFrame(
@@ -65,6 +67,7 @@ protected:
   FeatureConfig featureConfig;
   DebugConfig debugConfig;
   GLFWwindow *window{nullptr};
+  bool shouldClose{false};
 
   vk::DynamicLoader dl;
   vk::UniqueInstance vkInstance;
@@ -91,6 +94,8 @@ protected:
 
   std::vector<Semaphores> semaphores;
   std::vector<vk::UniqueFence> inFlightFrameFences;
+  /**fence of the frame that last rendered into each swapchain image.*/
+  std::vector<vk::Fence> imagesInFlight;
   uint32_t frameIndex{0};
 };
 }
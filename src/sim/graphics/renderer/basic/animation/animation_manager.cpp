@@ -0,0 +1,229 @@
+#include "animation_manager.h"
+#include <algorithm>
+#include "../basic_scene_manager.h"
+
+namespace sim::graphics::renderer::basic {
+
+AnimationManager::AnimationManager(BasicSceneManager &mm, uint32_t numThreads): mm{mm} {
+  if(numThreads != 1) pool = u<ThreadPool>(numThreads);
+}
+
+void AnimationManager::play(Ptr<Model> model, uint32_t animation) {
+  errorIf(
+    animation >= model->animations().size(), "animation ", animation,
+    " doesn't exist in model");
+  model->animations()[animation].resetAll();
+  if(playing(model, animation)) return;
+  playing_.push_back({model, animation});
+  stale = true;
+}
+
+void AnimationManager::stop(Ptr<Model> model, uint32_t animation) {
+  auto it = std::find_if(playing_.begin(), playing_.end(), [&](const Playing &p) {
+    return p.model.index() == model.index() && p.animation == animation;
+  });
+  if(it == playing_.end()) return;
+  playing_.erase(it);
+  stale = true;
+}
+
+void AnimationManager::stopAll() {
+  playing_.clear();
+  stale = true;
+}
+
+bool AnimationManager::playing(Ptr<Model> model, uint32_t animation) const {
+  return std::any_of(playing_.begin(), playing_.end(), [&](const Playing &p) {
+    return p.model.index() == model.index() && p.animation == animation;
+  });
+}
+
+void AnimationManager::play(
+  Ptr<ModelInstance> instance, uint32_t animation, float startTime) {
+  errorIf(instance->_removed, "model instance has been removed!");
+  auto &model = *instance->model();
+  errorIf(
+    animation >= model._animations.size(), "animation ", animation,
+    " doesn't exist in model");
+
+  auto [it, added] =
+    instanceStates.try_emplace(instance.index(), uint32_t(instances.size()));
+  if(added) {
+    instance->ownPose();
+    auto &state = instances.emplace_back();
+    state.instance = instance;
+    state.locals.reserve(model._hierarchy.size());
+    for(auto &node: model._hierarchy)
+      state.locals.push_back(node->transform());
+  }
+  auto &state = instances[it->second];
+  auto &animations = state.animations;
+  auto playing =
+    std::find_if(animations.begin(), animations.end(), [&](const InstanceAnimation &a) {
+      return a.animation == animation;
+    });
+  if(playing == animations.end()) {
+    auto numChannels = model._animations[animation].channels.size();
+    animations.push_back(
+      {animation, std::vector<float>(numChannels), std::vector<uint32_t>(numChannels)});
+    playing = animations.end() - 1;
+  }
+  std::fill(playing->times.begin(), playing->times.end(), startTime);
+  std::fill(playing->keys.begin(), playing->keys.end(), 0u);
+}
+
+void AnimationManager::stop(Ptr<ModelInstance> instance, uint32_t animation) {
+  auto it = instanceStates.find(instance.index());
+  if(it == instanceStates.end()) return;
+  auto &animations = instances[it->second].animations;
+  animations.erase(
+    std::remove_if(
+      animations.begin(), animations.end(),
+      [&](const InstanceAnimation &a) { return a.animation == animation; }),
+    animations.end());
+  if(animations.empty()) remove(instance);
+}
+
+void AnimationManager::remove(Ptr<ModelInstance> instance) {
+  auto it = instanceStates.find(instance.index());
+  if(it == instanceStates.end()) return;
+  auto index = it->second;
+  instanceStates.erase(it);
+  if(index + 1 != instances.size()) {
+    instances[index] = std::move(instances.back());
+    instanceStates[instances[index].instance.index()] = index;
+  }
+  instances.pop_back();
+}
+
+bool AnimationManager::playing(Ptr<ModelInstance> instance, uint32_t animation) const {
+  auto it = instanceStates.find(instance.index());
+  if(it == instanceStates.end()) return false;
+  auto &animations = instances[it->second].animations;
+  return std::any_of(
+    animations.begin(), animations.end(),
+    [&](const InstanceAnimation &a) { return a.animation == animation; });
+}
+
+void AnimationManager::rebuild() {
+  channels.clear();
+  targets.clear();
+  uint32_t numTranslations{0}, numRotations{0}, numScales{0};
+  std::unordered_map<uint32_t, uint32_t> nodeTargets;
+  for(uint32_t p = 0; p < playing_.size(); ++p) {
+    auto &animation = playing_[p].model->animations()[playing_[p].animation];
+    for(uint32_t c = 0; c < animation.channels.size(); ++c) {
+      auto &node = animation.channels[c].node;
+      auto path = animation.channels[c].path;
+      auto [it, added] = nodeTargets.try_emplace(node.index(), uint32_t(targets.size()));
+      if(added) targets.push_back({node});
+      auto &target = targets[it->second];
+      uint32_t slot{0};
+      switch(path) {
+        case Path::Translation:
+          target.translation = int32_t(slot = numTranslations++);
+          break;
+        case Path::Rotation: target.rotation = int32_t(slot = numRotations++); break;
+        case Path::Scale: target.scale = int32_t(slot = numScales++); break;
+      }
+      channels.push_back({p, c, path, slot});
+    }
+  }
+  translations.resize(numTranslations);
+  rotations.resize(numRotations);
+  scales.resize(numScales);
+  stale = false;
+}
+
+void AnimationManager::sample(size_t begin, size_t end, float elapsed) {
+  for(auto i = begin; i < end; ++i) {
+    auto &channel = channels[i];
+    auto value = resolved[channel.playing]->sample(channel.channel, elapsed);
+    switch(channel.path) {
+      case Path::Translation: translations[channel.slot] = value; break;
+      case Path::Rotation:
+        rotations[channel.slot] =
+          glm::normalize(glm::quat{value.w, value.x, value.y, value.z});
+        break;
+      case Path::Scale: scales[channel.slot] = value; break;
+    }
+  }
+}
+
+void AnimationManager::animate(InstanceState &state, float elapsed) {
+  auto instance = state.instance;
+  auto &model = *instance->model();
+  for(auto &playing: state.animations) {
+    auto &animation = model._animations[playing.animation];
+    auto &targets = model._channelTargets[playing.animation];
+    for(uint32_t i = 0; i < animation.channels.size(); ++i) {
+      auto value = animation.sample(i, elapsed, playing.times[i], playing.keys[i]);
+      auto &local = state.locals[targets[i]];
+      switch(animation.channels[i].path) {
+        case Path::Translation: local.translation = value; break;
+        case Path::Rotation:
+          local.rotation = glm::normalize(glm::quat{value.w, value.x, value.y, value.z});
+          break;
+        case Path::Scale: local.scale = value; break;
+      }
+    }
+  }
+
+  // the pose lives in the host copy of the transforms, so parents are read back from it;
+  // update logs the write for the per-frame slices.
+  auto &hierarchy = model._hierarchy;
+  auto pose = instance->_pose.ptr;
+  for(size_t i = 0; i < hierarchy.size(); ++i) {
+    auto local = model._animated[i] ? state.locals[i] : hierarchy[i]->transform();
+    auto parent = model._parents[i];
+    pose[i] = parent < 0 ? local.toMatrix() : pose[parent] * local.toMatrix();
+  }
+}
+
+void AnimationManager::update(float elapsed) {
+  if(stale) rebuild();
+  updateModels(elapsed);
+
+  auto numChunks = (instances.size() + instanceChunkSize - 1) / instanceChunkSize;
+  auto animateChunk = [&](size_t chunk) {
+    auto begin = chunk * instanceChunkSize;
+    auto end = std::min(begin + instanceChunkSize, instances.size());
+    for(auto i = begin; i < end; ++i)
+      animate(instances[i], elapsed);
+  };
+  if(pool && numChunks > 1) pool->parallelFor(numChunks, animateChunk);
+  else
+    for(size_t chunk = 0; chunk < numChunks; ++chunk)
+      animateChunk(chunk);
+
+  // the write log is not thread safe, so the poses are logged after the workers finish.
+  for(auto &state: instances)
+    state.instance->_pose.written(uint32_t(state.instance->model()->_hierarchy.size()));
+}
+
+void AnimationManager::updateModels(float elapsed) {
+  if(channels.empty()) return;
+
+  // models may have moved since last frame, so the animations are resolved again.
+  resolved.resize(playing_.size());
+  for(size_t i = 0; i < playing_.size(); ++i)
+    resolved[i] = &playing_[i].model->animations()[playing_[i].animation];
+
+  auto numChunks = (channels.size() + chunkSize - 1) / chunkSize;
+  if(pool && numChunks > 1)
+    pool->parallelFor(numChunks, [&](size_t chunk) {
+      auto begin = chunk * chunkSize;
+      sample(begin, std::min(begin + chunkSize, channels.size()), elapsed);
+    });
+  else
+    sample(0, channels.size(), elapsed);
+
+  for(auto &target: targets) {
+    auto transform = target.node->transform();
+    if(target.translation >= 0) transform.translation = translations[target.translation];
+    if(target.rotation >= 0) transform.rotation = rotations[target.rotation];
+    if(target.scale >= 0) transform.scale = scales[target.scale];
+    target.node->setTransform(transform);
+  }
+}
+}
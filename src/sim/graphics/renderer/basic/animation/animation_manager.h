@@ -0,0 +1,106 @@
+#pragma once
+#include <unordered_map>
+#include "sim/util/thread_pool.h"
+#include "sim/graphics/base/vkcommon.h"
+#include "../model/model_instance.h"
+
+namespace sim::graphics::renderer::basic {
+class BasicSceneManager;
+
+/**
+ * Plays model animations in one batch per frame. Every channel of every playing
+ * animation is sampled into translation, rotation and scale arrays, split into chunks
+ * over a thread pool; the samples are then written to their nodes in a single pass that
+ * sets each animated node's transform once.
+ *
+ * Animations played on a ModelInstance give that instance its own block of node
+ * matrices and its own animation time, so instances of one model animate independently.
+ * Instances are evaluated in parallel, each writing its whole pose parents-first. An
+ * instance keeps its last pose after its animations stop.
+ */
+class AnimationManager {
+public:
+  /**@param numThreads worker threads; 1 samples on the calling thread, 0 uses the
+   * hardware concurrency.*/
+  AnimationManager(BasicSceneManager &mm, uint32_t numThreads);
+
+  /**restart animation of model and keep playing it every frame until stopped.*/
+  void play(Ptr<Model> model, uint32_t animation);
+  void stop(Ptr<Model> model, uint32_t animation);
+  void stopAll();
+  bool playing(Ptr<Model> model, uint32_t animation) const;
+
+  /**
+   * play animation on instance alone, keeping it until stopped.
+   * @param startTime seconds into the animation, e.g. to desynchronize instances.
+   */
+  void play(Ptr<ModelInstance> instance, uint32_t animation, float startTime = 0);
+  void stop(Ptr<ModelInstance> instance, uint32_t animation);
+  bool playing(Ptr<ModelInstance> instance, uint32_t animation) const;
+
+private:
+  friend class BasicSceneManager;
+
+  /**stop every animation played on instance.*/
+  void remove(Ptr<ModelInstance> instance);
+  /**advance every playing animation by elapsed and apply the samples.*/
+  void update(float elapsed);
+  void updateModels(float elapsed);
+  void rebuild();
+  void sample(size_t begin, size_t end, float elapsed);
+  struct InstanceState;
+  static void animate(InstanceState &state, float elapsed);
+
+  using Path = Animation::AnimationChannel::PathType;
+
+  struct Playing {
+    Ptr<Model> model;
+    uint32_t animation;
+  };
+  struct Channel {
+    uint32_t playing;
+    uint32_t channel;
+    Path path;
+    /**index into the array of path.*/
+    uint32_t slot;
+  };
+  /**a node with the sample slots of the channels targeting it, -1 if none.*/
+  struct Target {
+    Ptr<Node> node;
+    int32_t translation{-1}, rotation{-1}, scale{-1};
+  };
+
+  /**the channel cursors of one animation played on an instance.*/
+  struct InstanceAnimation {
+    uint32_t animation;
+    std::vector<float> times;
+    std::vector<uint32_t> keys;
+  };
+  struct InstanceState {
+    Ptr<ModelInstance> instance;
+    /**local transforms of the animated nodes, in Model::hierarchy order.*/
+    std::vector<Transform> locals;
+    std::vector<InstanceAnimation> animations;
+  };
+
+  static constexpr size_t chunkSize = 256;
+  static constexpr size_t instanceChunkSize = 16;
+
+  BasicSceneManager &mm;
+  uPtr<ThreadPool> pool;
+
+  std::vector<Playing> playing_;
+  bool stale{false};
+
+  std::vector<Animation *> resolved;
+  std::vector<Channel> channels;
+  std::vector<Target> targets;
+  std::vector<glm::vec3> translations;
+  std::vector<glm::quat> rotations;
+  std::vector<glm::vec3> scales;
+
+  std::vector<InstanceState> instances;
+  /**state index of each instance playing animations, by instance index.*/
+  std::unordered_map<uint32_t, uint32_t> instanceStates;
+};
+}
@@ -10,10 +10,18 @@ using access = vk::AccessFlagBits;
 using bindpoint = vk::PipelineBindPoint;
 using descriptor = vk::DescriptorType;
 
+namespace {
+/**the texture table of the scene manager needs descriptor indexing.*/
+FeatureConfig withDescriptorIndexing(const FeatureConfig &featureConfig) {
+  return FeatureConfig{
+    FeatureConfig::Value(featureConfig | FeatureConfig::DescriptorIndexing)};
+}
+}
+
 BasicRenderer::BasicRenderer(
   const Config &config, const ModelConfig &modelConfig,
   const FeatureConfig &featureConfig, const DebugConfig &debugConfig)
-  : VulkanBase{config, featureConfig, debugConfig},
+  : VulkanBase{config, withDescriptorIndexing(featureConfig), debugConfig},
     modelConfig{modelConfig},
     vkDevice{device->getDevice()} {
   sampleCount = static_cast<vk::SampleCountFlagBits>(config.sampleCount);
@@ -40,7 +48,8 @@ void BasicRenderer::createQueryPool() {
     flag::eTessellationControlShaderPatches |
     flag::eTessellationEvaluationShaderInvocations | flag::eComputeShaderInvocations;
   info.queryType = vk::QueryType ::ePipelineStatistics;
-  info.queryCount = 9;
+  // one query per swapchain image, so results are read back only after its fence.
+  info.queryCount = swapchain->getImageCount();
   queryPool = vkDevice.createQueryPoolUnique(info);
 
   pipelineStatNames = {
@@ -75,7 +84,7 @@ void BasicRenderer::createRenderPass() {
   auto pbr = maker.attachment(vk::Format::eR8G8B8A8Unorm).index();
   auto emissive = maker.attachment(vk::Format::eR8G8B8A8Unorm).index();
   auto depth = maker.attachment(vk::Format::eD24UnormS8Uint)
-                 .storeOp(vk::AttachmentStoreOp::eDontCare)
+                 .storeOp(vk::AttachmentStoreOp::eStore)
                  .finalLayout(layout::eDepthStencilAttachmentOptimal)
                  .index();
   Subpasses.gBuffer = maker.subpass(bindpoint::eGraphics)
@@ -107,11 +116,13 @@ void BasicRenderer::createRenderPass() {
     Subpasses.resolve = maker.subpass(bindpoint::eGraphics)
                           .color(color)
                           .index(); //resolve using tiled on chip memory.
+  // the attachments are shared by all frames in flight, so the previous frame's
+  // attachment writes must finish before this frame writes them again.
   maker.dependency(VK_SUBPASS_EXTERNAL, Subpasses.gBuffer)
-    .srcStageMask(stage::eBottomOfPipe)
-    .dstStageMask(stage::eColorAttachmentOutput)
-    .srcAccessMask(access::eMemoryRead)
-    .dstAccessMask(access::eColorAttachmentWrite)
+    .srcStageMask(stage::eColorAttachmentOutput | stage::eLateFragmentTests)
+    .dstStageMask(stage::eColorAttachmentOutput | stage::eEarlyFragmentTests)
+    .srcAccessMask(access::eColorAttachmentWrite | access::eDepthStencilAttachmentWrite)
+    .dstAccessMask(access::eColorAttachmentWrite | access::eDepthStencilAttachmentWrite)
     .dependencyFlags(vk::DependencyFlagBits::eByRegion);
   maker.dependency(Subpasses.gBuffer, Subpasses.deferred)
     .srcStageMask(stage::eColorAttachmentOutput)
@@ -145,12 +156,34 @@ void BasicRenderer::createRenderPass() {
 
 void BasicRenderer::createPipelines() {
   auto pipelineLayout = *mm->basicLayout.pipelineLayout;
-  pipelineCache = vkDevice.createPipelineCacheUnique({});
 
-  createOpaquePipeline(pipelineLayout);
+  createOpaquePipeline(pipelineLayout, false);
   createDeferredPipeline(pipelineLayout);
-  createTranslucentPipeline(pipelineLayout);
-  createTerrainPipeline(pipelineLayout);
+  createTranslucentPipeline(pipelineLayout, false);
+  createTerrainPipeline(pipelineLayout, false);
+  if(modelConfig.quantizeVertices) {
+    createOpaquePipeline(pipelineLayout, true);
+    createTranslucentPipeline(pipelineLayout, true);
+    createTerrainPipeline(pipelineLayout, true);
+  }
+}
+
+void BasicRenderer::vertexInput(GraphicsPipelineMaker &pipelineMaker, bool quantized) {
+  using f = vk::Format;
+  if(quantized)
+    pipelineMaker.vertexBinding(0, sizeof(QuantizedVertex::Position))
+      .vertexAttribute(0, 0, f::eR16G16B16A16Snorm, 0)
+      .vertexBinding(1, sizeof(QuantizedVertex::Normal))
+      .vertexAttribute(1, 1, f::eR16G16Snorm, 0)
+      .vertexBinding(2, sizeof(QuantizedVertex::UV))
+      .vertexAttribute(2, 2, f::eR16G16Sfloat, 0);
+  else
+    pipelineMaker.vertexBinding(0, sizeof(Vertex::Position))
+      .vertexAttribute(0, 0, f::eR32G32B32Sfloat, 0)
+      .vertexBinding(1, sizeof(Vertex::Normal))
+      .vertexAttribute(1, 1, f::eR32G32B32Sfloat, 0)
+      .vertexBinding(2, sizeof(Vertex::UV))
+      .vertexAttribute(2, 2, f::eR32G32Sfloat, 0);
 }
 
 void BasicRenderer::recreateResources() {
@@ -216,7 +249,13 @@ void BasicRenderer::updateFrame(
 
   mm->updateScene(transfeCB, compCB, imageIndex,elapsedDuration);
 
-  cb.resetQueryPool(*queryPool, 0, pipelineStats.size());
+  // the previous frame on this image has finished, so its statistics are available.
+  vkDevice.getQueryPoolResults(
+    *queryPool, imageIndex, 1, pipelineStats.size() * sizeof(uint64_t),
+    pipelineStats.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+  cb.resetQueryPool(*queryPool, imageIndex, 1);
+
+  mm->cullScene(cb, imageIndex);
 
   std::array<vk::ClearValue, 8> clearValues{
     vk::ClearColorValue{std::array{0.0f, 0.0f, 0.0f, 0.0f}},
@@ -238,7 +277,7 @@ void BasicRenderer::updateFrame(
   vk::Rect2D scissor{{0, 0}, {extent.width, extent.height}};
   cb.setScissor(0, scissor);
 
-  cb.beginQuery(*queryPool, 0, {});
+  cb.beginQuery(*queryPool, imageIndex, {});
 
   debugMarker.begin(cb, "subpass direct shading");
 
@@ -247,7 +286,9 @@ void BasicRenderer::updateFrame(
   debugMarker.end(cb);
   cb.endRenderPass();
 
-  cb.endQuery(*queryPool, 0);
+  cb.endQuery(*queryPool, imageIndex);
+
+  mm->buildDepthPyramid(cb, imageIndex);
 
   auto &swapchainImage = swapchain->getImage(imageIndex);
   if(config.sampleCount == 1) {
@@ -259,17 +300,13 @@ void BasicRenderer::updateFrame(
       layout::eTransferSrcOptimal, {}, access::eTransferRead);
     Texture::copy(cb, *attachments.offscreenImage, swapchainImage);
     Texture::setLayout(
-      cb, swapchainImage, layout::eUndefined, layout::ePresentSrcKHR,
+      cb, swapchainImage, layout::eUndefined, swapchain->presentLayout(),
       access::eTransferWrite, access::eMemoryRead);
   } else
     Texture::setLayout(
-      cb, swapchainImage, layout::eUndefined, layout::ePresentSrcKHR,
+      cb, swapchainImage, layout::eUndefined, swapchain->presentLayout(),
       access::eTransferWrite, access::eMemoryRead);
 
-  vkDevice.getQueryPoolResults(
-    *queryPool, 0, 1, pipelineStats.size() * sizeof(uint64_t), pipelineStats.data(),
-    sizeof(uint64_t), vk::QueryResultFlagBits::e64);
-
   //  for(int i = 0; i < pipelineStats.size(); ++i) {
   //    println(pipelineStatNames[i], pipelineStats[i]);
   //  }
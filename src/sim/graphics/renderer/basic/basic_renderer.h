@@ -24,10 +24,13 @@ protected:
 
   void createRenderPass();
   void createPipelines();
-  void createOpaquePipeline(const vk::PipelineLayout &pipelineLayout);
+  void createOpaquePipeline(const vk::PipelineLayout &pipelineLayout, bool quantized);
   void createDeferredPipeline(const vk::PipelineLayout &pipelineLayout);
-  void createTranslucentPipeline(const vk::PipelineLayout &pipelineLayout);
-  void createTerrainPipeline(const vk::PipelineLayout &pipelineLayout);
+  void createTranslucentPipeline(
+    const vk::PipelineLayout &pipelineLayout, bool quantized);
+  void createTerrainPipeline(const vk::PipelineLayout &pipelineLayout, bool quantized);
+  /**the position, normal and uv streams of Vertex, or of QuantizedVertex.*/
+  static void vertexInput(GraphicsPipelineMaker &pipelineMaker, bool quantized);
 
   void recreateResources();
 
@@ -46,7 +49,6 @@ protected:
   float minSampleShading{1};
 
   uPtr<BasicSceneManager> mm{};
-  vk::UniquePipelineCache pipelineCache;
   vk::UniqueQueryPool queryPool;
   std::vector<uint64_t> pipelineStats;
   std::vector<std::string> pipelineStatNames;
@@ -59,12 +61,17 @@ protected:
     uint32_t gBuffer, deferred, translucent, combine,resolve;
   } Subpasses{};
 
-  struct {
+  struct GeometryPipelines {
     vk::UniquePipeline opaqueTri, opaqueLine, opaqueTriWireframe;
-    vk::UniquePipeline deferred, deferredIBL, deferredSky;
     vk::UniquePipeline transTri, transLine;
     vk::UniquePipeline terrainTess, terrainTessWireframe;
+  };
+
+  struct: GeometryPipelines {
+    vk::UniquePipeline deferred, deferredIBL, deferredSky;
   } Pipelines;
+  /**the geometry pipelines of static draws with ModelConfig::quantizeVertices.*/
+  GeometryPipelines QuantizedPipelines;
 
   struct {
     uPtr<Texture> offscreenImage;
@@ -1,6 +1,9 @@
 #include "basic_scene_manager.h"
+#include <algorithm>
+#include <filesystem>
 #include "basic_renderer.h"
 #include "sim/graphics/util/colors.h"
+#include "sim/util/hash.h"
 #include "loader/gltf_loader.h"
 #include "ibl/envmap_generator.h"
 #include "sim/graphics/base/pipeline/descriptor_pool_maker.h"
@@ -19,32 +22,45 @@ BasicSceneManager::BasicSceneManager(BasicRenderer &renderer)
     vkDevice{renderer.vkDevice} {
   {
     auto &allocator = renderer.device->allocator();
-    Buffer.position =
-      u<DeviceVertexBuffer<Vertex::Position>>(allocator, modelConfig_.maxNumVertex);
-    Buffer.normal =
-      u<DeviceVertexBuffer<Vertex::Normal>>(allocator, modelConfig_.maxNumVertex);
-    Buffer.uv = u<DeviceVertexBuffer<Vertex::UV>>(allocator, modelConfig_.maxNumVertex);
+    auto numVertex = modelConfig_.maxNumVertex;
+    if(modelConfig_.quantizeVertices) {
+      Buffer.quantizedPosition =
+        u<DeviceVertexBuffer<QuantizedVertex::Position>>(allocator, numVertex);
+      Buffer.quantizedNormal =
+        u<DeviceVertexBuffer<QuantizedVertex::Normal>>(allocator, numVertex);
+      Buffer.quantizedUV =
+        u<DeviceVertexBuffer<QuantizedVertex::UV>>(allocator, numVertex);
+      // only dynamic primitives and skinned meshes are left in the full streams.
+      numVertex = modelConfig_.maxNumDynamicVertex;
+    }
+    Buffer.position = u<DeviceVertexBuffer<Vertex::Position>>(allocator, numVertex);
+    Buffer.normal = u<DeviceVertexBuffer<Vertex::Normal>>(allocator, numVertex);
+    Buffer.uv = u<DeviceVertexBuffer<Vertex::UV>>(allocator, numVertex);
     Buffer.joint0 =
       u<DeviceVertexBuffer<Vertex::Joint>>(allocator, modelConfig_.maxNumVertex);
     Buffer.weight0 =
       u<DeviceVertexBuffer<Vertex::Weight>>(allocator, modelConfig_.maxNumVertex);
     Buffer.indices = u<DeviceIndexBuffer>(allocator, modelConfig_.maxNumVertex);
+    if(modelConfig_.clusterTriangles)
+      Buffer.clusters =
+        u<DeviceStorageBuffer<Cluster>>(allocator, modelConfig_.maxNumClusters);
 
-    Buffer.transforms =
-      u<HostManagedStorageUBOBuffer<glm::mat4>>(allocator, modelConfig_.maxNumTransform);
+    Buffer.transforms = u<HostManagedStorageUBOBuffer<glm::mat4>>(
+      device_, modelConfig_.maxNumTransform, config_.numFrame);
 
     Buffer.materials = u<HostManagedStorageUBOBuffer<Material::UBO>>(
-      allocator, modelConfig_.maxNumMaterial);
+      device_, modelConfig_.maxNumMaterial, config_.numFrame);
 
     Buffer.primitives = u<HostManagedStorageUBOBuffer<Primitive::UBO>>(
       allocator, modelConfig_.maxNumPrimitives);
 
-    Buffer.camera = u<HostUBOBuffer<PerspectiveCamera::UBO>>(allocator);
+    Buffer.camera =
+      u<HostDynamicUBOBuffer<PerspectiveCamera::UBO>>(device_, config_.numFrame);
 
-    Buffer.lighting = u<HostUBOBuffer<Lighting::UBO>>(allocator);
+    Buffer.lighting = u<HostDynamicUBOBuffer<Lighting::UBO>>(device_, config_.numFrame);
     Scene.lighting.setNumLights(modelConfig_.maxNumLights);
-    Buffer.lights =
-      u<HostManagedStorageUBOBuffer<Light::UBO>>(allocator, modelConfig_.maxNumLights);
+    Buffer.lights = u<HostManagedStorageUBOBuffer<Light::UBO>>(
+      device_, modelConfig_.maxNumLights, config_.numFrame);
 
     Buffer.drawQueue = u<DrawQueue>(
       allocator, modelConfig_.maxNumMeshes, modelConfig_.maxNumLineMeshes,
@@ -57,18 +73,35 @@ BasicSceneManager::BasicSceneManager(BasicRenderer &renderer)
                        modelConfig_.maxNumTransparentMeshes +
                        modelConfig_.maxNumTransparentLineMeshes +
                        modelConfig_.maxNumTerranMeshes;
-    Buffer.meshInstances =
-      u<HostManagedStorageUBOBuffer<MeshInstance::UBO>>(allocator, totalMeshes);
+    Buffer.meshInstances = u<HostManagedStorageUBOBuffer<MeshInstance::UBO>>(
+      device_, totalMeshes, config_.numFrame);
   }
 
   dynamicMeshManager_ = u<DynamicMeshManager>(*this);
   terrainManager_ = u<TerrainManager>(*this);
   skyManager_ = u<SkyManager>(*this);
-  oceanManager_ = u<OceanManager>(*this);
+  oceanManager_ = u<OceanManager>(*this, modelConfig_.numOceanThreads);
   shadowManager_ = u<ShadowManager>(*this);
+  cullingManager_ = u<CullingManager>(*this);
+  animationManager_ = u<AnimationManager>(*this, modelConfig_.numAnimationThreads);
+  skinningManager_ = u<SkinningManager>(*this);
+  if(modelConfig_.optimizeIndices)
+    meshOptimizer_ = u<MeshOptimizer>(modelConfig_.numLoaderThreads);
 
   {
-    basicSetDef.textures.descriptorCount() = uint32_t(modelConfig_.maxNumTexture);
+    auto &limits = device_.getDescriptorIndexingProperties();
+    auto deviceMax = std::min(
+      {limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+       limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+       limits.maxDescriptorSetUpdateAfterBindSamplers,
+       limits.maxDescriptorSetUpdateAfterBindSampledImages});
+    // the other sets of the layout keep a few samplers per stage for themselves.
+    constexpr uint32_t reserved = 64;
+    errorIf(deviceMax <= reserved, "too few update after bind samplers!");
+    Image.table = u<TextureTable>(
+      vkDevice, modelConfig_.maxNumTexture,
+      std::min(modelConfig_.maxNumTextureSlots, deviceMax - reserved), config_.numFrame);
+
     basicSetDef.init(vkDevice);
 
     deferredSetDef.init(vkDevice);
@@ -83,12 +116,15 @@ BasicSceneManager::BasicSceneManager(BasicRenderer &renderer)
     basicLayout.ibl(iblSetDef);
     basicLayout.sky(skyManager_->skySetDef);
     basicLayout.shadow(shadowManager_->shadowSetDef);
+    basicLayout.textures(Image.table->setDef);
     basicLayout.init(vkDevice);
 
     Sets.descriptorPool = DescriptorPoolMaker()
                             .pipelineLayout(basicLayout)
                             .pipelineLayout(computeMeshLayoutDef)
                             .pipelineLayout(oceanManager_->oceanLayoutDef)
+                            .pipelineLayout(cullingManager_->cullLayoutDef)
+                            .pipelineLayout(skinningManager_->skinLayoutDef)
                             .createUnique(vkDevice);
 
     Sets.basicSet = basicSetDef.createSet(*Sets.descriptorPool);
@@ -96,32 +132,28 @@ BasicSceneManager::BasicSceneManager(BasicRenderer &renderer)
     Sets.iblSet = iblSetDef.createSet(*Sets.descriptorPool);
     skyManager_->createDescriptorSets(*Sets.descriptorPool);
     oceanManager_->createDescriptorSets(*Sets.descriptorPool);
+    cullingManager_->createDescriptorSets(*Sets.descriptorPool);
+    skinningManager_->createDescriptorSets(*Sets.descriptorPool);
   }
 
   {
-    basicSetDef.cam(Buffer.camera->buffer());
+    basicSetDef.cam(Buffer.camera->buffer(), Buffer.camera->size());
     basicSetDef.primitives(Buffer.primitives->buffer());
-    basicSetDef.meshInstances(Buffer.meshInstances->buffer());
-    basicSetDef.transforms(Buffer.transforms->buffer());
-    basicSetDef.material(Buffer.materials->buffer());
-    basicSetDef.lighting(Buffer.lighting->buffer());
-    basicSetDef.lights(Buffer.lights->buffer());
+    basicSetDef.meshInstances(
+      Buffer.meshInstances->buffer(), Buffer.meshInstances->size());
+    basicSetDef.transforms(Buffer.transforms->buffer(), Buffer.transforms->size());
+    basicSetDef.material(Buffer.materials->buffer(), Buffer.materials->size());
+    basicSetDef.lighting(Buffer.lighting->buffer(), Buffer.lighting->size());
+    basicSetDef.lights(Buffer.lights->buffer(), Buffer.lights->size());
+    basicSetDef.instanceIDs(Buffer.drawQueue->instanceIDs());
 
     { // empty texture;
-      Image.textures.emplace_back(device_, 1, 1);
+      Texture2D empty{device_, 1, 1};
       glm::vec4 color{1.f, 1.f, 1.f, 1.f};
-      Image.textures.back().upload(
+      empty.upload(
         device_, reinterpret_cast<const unsigned char *>(&color), sizeof(color));
-      Image.textures.back().setSampler(SamplerMaker().createUnique(vkDevice));
-
-      // bind unused textures to empty texture;
-      Image.sampler2Ds.reserve(modelConfig_.maxNumTexture);
-      for(auto i = 0u; i < modelConfig_.maxNumTexture; ++i)
-        Image.sampler2Ds.emplace_back(
-          Image.textures.back().sampler(), Image.textures.back().imageView(),
-          vk::ImageLayout ::eShaderReadOnlyOptimal);
-      Image.lastImagesCount = 1;
-      basicSetDef.textures(0, uint32_t(Image.sampler2Ds.size()), Image.sampler2Ds.data());
+      empty.setSampler(SamplerMaker().createShared(device_));
+      addTexture(std::move(empty));
 
       newMaterial(); //empty material
     }
@@ -142,6 +174,12 @@ BasicSceneManager::BasicSceneManager(BasicRenderer &renderer)
     debugMarker_.name(Buffer.uv->buffer(), "uv buffer");
     debugMarker_.name(Buffer.joint0->buffer(), "joint0 buffer");
     debugMarker_.name(Buffer.weight0->buffer(), "weight0 buffer");
+    if(modelConfig_.quantizeVertices) {
+      debugMarker_.name(Buffer.quantizedPosition->buffer(), "quantized position buffer");
+      debugMarker_.name(Buffer.quantizedNormal->buffer(), "quantized normal buffer");
+      debugMarker_.name(Buffer.quantizedUV->buffer(), "quantized uv buffer");
+    }
+    if(Buffer.clusters) debugMarker_.name(Buffer.clusters->buffer(), "clusters buffer");
     debugMarker_.name(Buffer.transforms->buffer(), "transforms buffer");
     debugMarker_.name(Buffer.materials->buffer(), "materials buffer");
     debugMarker_.name(Buffer.primitives->buffer(), "primitives buffer");
@@ -162,16 +200,36 @@ Allocation<Light::UBO> BasicSceneManager::allocateLightUBO() {
 Allocation<glm::mat4> BasicSceneManager::allocateMatrixUBO() {
   return Buffer.transforms->allocate();
 }
+Allocation<glm::mat4> BasicSceneManager::allocateMatrixUBO(uint32_t num) {
+  return Buffer.transforms->allocate(num);
+}
 Allocation<Primitive::UBO> BasicSceneManager::allocatePrimitiveUBO() {
   return Buffer.primitives->allocate();
 }
 Allocation<MeshInstance::UBO> BasicSceneManager::allocateMeshInstanceUBO() {
   return Buffer.meshInstances->allocate();
 }
-auto BasicSceneManager::allocateDrawCMD(
-  const Ptr<Primitive> &primitive, const Ptr<Material> &material)
-  -> std::vector<Allocation<vk::DrawIndexedIndirectCommand>> {
-  return Buffer.drawQueue->allocate(primitive, material);
+uint32_t BasicSceneManager::allocateDrawCMD(
+  const Ptr<Primitive> &primitive, const Ptr<Material> &material,
+  const DynamicType &type, uint32_t meshInstance, bool visible) {
+  return Buffer.drawQueue->add(primitive, material, type, meshInstance, visible);
+}
+Range BasicSceneManager::allocateSkinnedVertices(uint32_t numVertices) {
+  auto positionRange = Buffer.position->add(device_, numVertices * config_.numFrame);
+  auto normalRange = Buffer.normal->add(device_, numVertices * config_.numFrame);
+  auto uvRange = Buffer.uv->add(device_, numVertices * config_.numFrame);
+  // skinning and the draws address all three streams by the position offset.
+  errorIf(
+    normalRange.offset != positionRange.offset || uvRange.offset != positionRange.offset,
+    "skinned vertex streams are out of step!");
+  return positionRange;
+}
+
+void BasicSceneManager::addPrimitiveUser(
+  const Ptr<Primitive> &primitive, const Ptr<ModelInstance> &instance, uint32_t mesh) {
+  auto &users = Scene.primitiveUsers;
+  if(users.size() <= primitive.index()) users.resize(primitive.index() + 1);
+  users[primitive.index()].push_back({instance, mesh});
 }
 
 void BasicSceneManager::resize(vk::Extent2D extent) {
@@ -184,6 +242,8 @@ void BasicSceneManager::resize(vk::Extent2D extent) {
   deferredSetDef.emissive(renderer.attachments.emissive->imageView());
   deferredSetDef.depth(renderer.attachments.depth->imageView());
   deferredSetDef.update(Sets.deferredSet);
+
+  cullingManager_->resize(extent, *renderer.attachments.depth);
 }
 
 PerspectiveCamera &BasicSceneManager::camera() { return Scene.camera; }
@@ -194,18 +254,104 @@ SkyManager &BasicSceneManager::skyManager() { return *skyManager_; }
 TerrainManager &BasicSceneManager::terrainManager() { return *terrainManager_; }
 OceanManager &BasicSceneManager::oceanManager() { return *oceanManager_; }
 ShadowManager &BasicSceneManager::shadowManager() { return *shadowManager_; }
+CullingManager &BasicSceneManager::cullingManager() { return *cullingManager_; }
+AnimationManager &BasicSceneManager::animationManager() { return *animationManager_; }
+SkinningManager &BasicSceneManager::skinningManager() { return *skinningManager_; }
 
 Ptr<Primitive> BasicSceneManager::newPrimitive(
   const Vertex::Position *positions, uint32_t numPositions, const Vertex::Normal *normals,
   uint32_t numNormals, const Vertex::UV *uvs, uint32_t numUVs, const uint32_t *indices,
   uint32_t numIndices, const AABB &aabb, const PrimitiveTopology &topology,
-  const DynamicType &type) {
+  const DynamicType &type, const LODChain *lods) {
+  auto staticTriangles =
+    type == DynamicType::Static && topology == PrimitiveTopology::Triangles;
+  LODChain chain;
+  if(!modelConfig_.generateLODs || !staticTriangles) lods = nullptr;
+  else if(!lods) {
+    chain = MeshSimplifier::buildLODs(
+      indices, numIndices, positions, numPositions, Primitive::maxNumLODs - 1);
+    lods = &chain;
+  }
+
+  std::vector<uint32_t> optimized;
+  std::vector<Vertex::Position> optimizedPositions;
+  std::vector<Vertex::Normal> optimizedNormals;
+  std::vector<Vertex::UV> optimizedUVs;
+  if(meshOptimizer_ && staticTriangles) {
+    optimized.assign(indices, indices + numIndices);
+    meshOptimizer_->optimizeTriangles(optimized, positions, numPositions);
+    std::vector<uint32_t> remap;
+    // streams of another length don't follow the positions, so the vertices stay put.
+    if(numNormals == numPositions && numUVs == numPositions) {
+      remap = MeshOptimizer::optimizeVertexFetch(optimized, numPositions);
+      optimizedPositions = MeshOptimizer::remap(positions, remap);
+      optimizedNormals = MeshOptimizer::remap(normals, remap);
+      optimizedUVs = MeshOptimizer::remap(uvs, remap);
+      positions = optimizedPositions.data();
+      normals = optimizedNormals.data();
+      uvs = optimizedUVs.data();
+    }
+    indices = optimized.data();
+    numIndices = uint32_t(optimized.size());
+
+    if(lods) {
+      if(lods != &chain) chain = *lods;
+      if(!remap.empty())
+        for(auto &index: chain.indices)
+          index = remap[index];
+      for(auto &level: chain.levels) {
+        auto first = chain.indices.begin() + level.offset;
+        std::vector<uint32_t> levelIndices(first, first + level.size);
+        meshOptimizer_->optimizeTriangles(levelIndices, positions, numPositions);
+        std::copy(levelIndices.begin(), levelIndices.end(), first);
+      }
+      lods = &chain;
+    }
+  }
+
+  std::vector<Cluster> clusters;
+  if(modelConfig_.clusterTriangles && staticTriangles) {
+    if(optimized.empty()) optimized.assign(indices, indices + numIndices);
+    clusters = ClusterBuilder::build(optimized, positions, numPositions);
+    indices = optimized.data();
+    numIndices = uint32_t(optimized.size());
+  }
+  return uploadPrimitive(
+    positions, numPositions, normals, numNormals, uvs, numUVs, indices, numIndices, aabb,
+    topology, type, lods, clusters);
+}
+
+Ptr<Primitive> BasicSceneManager::uploadPrimitive(
+  const Vertex::Position *positions, uint32_t numPositions, const Vertex::Normal *normals,
+  uint32_t numNormals, const Vertex::UV *uvs, uint32_t numUVs, const uint32_t *indices,
+  uint32_t numIndices, const AABB &aabb, const PrimitiveTopology &topology,
+  const DynamicType &type, const LODChain *lods, const std::vector<Cluster> &clusters) {
   Range positionRange, normalRange, uvRange, indexRange;
+  auto quantized = type == DynamicType::Static && modelConfig_.quantizeVertices;
+  AABB box;
   switch(type) {
     case DynamicType::Static:
-      positionRange = Buffer.position->add(device_, positions, numPositions);
-      normalRange = Buffer.normal->add(device_, normals, numNormals);
-      uvRange = Buffer.uv->add(device_, uvs, numUVs);
+      if(quantized) {
+        for(uint32_t i = 0; i < numPositions; ++i)
+          box.merge(positions[i]);
+        std::vector<QuantizedVertex::Position> qPositions(numPositions);
+        std::vector<QuantizedVertex::Normal> qNormals(numNormals);
+        std::vector<QuantizedVertex::UV> qUVs(numUVs);
+        for(uint32_t i = 0; i < numPositions; ++i)
+          qPositions[i] = QuantizedVertex::position(positions[i], box);
+        for(uint32_t i = 0; i < numNormals; ++i)
+          qNormals[i] = QuantizedVertex::normal(normals[i]);
+        for(uint32_t i = 0; i < numUVs; ++i)
+          qUVs[i] = QuantizedVertex::uv(uvs[i]);
+        positionRange =
+          Buffer.quantizedPosition->add(device_, qPositions.data(), numPositions);
+        normalRange = Buffer.quantizedNormal->add(device_, qNormals.data(), numNormals);
+        uvRange = Buffer.quantizedUV->add(device_, qUVs.data(), numUVs);
+      } else {
+        positionRange = Buffer.position->add(device_, positions, numPositions);
+        normalRange = Buffer.normal->add(device_, normals, numNormals);
+        uvRange = Buffer.uv->add(device_, uvs, numUVs);
+      }
       indexRange = Buffer.indices->add(device_, indices, numIndices);
       break;
     case DynamicType::Dynamic:
@@ -217,9 +363,72 @@ Ptr<Primitive> BasicSceneManager::newPrimitive(
       break;
   }
 
-  return Ptr<Primitive>::add(
+  auto primitive = Ptr<Primitive>::add(
     Scene.primitives,
     {*this, indexRange, positionRange, normalRange, uvRange, aabb, topology, type});
+  if(quantized) {
+    primitive->_quantized = true;
+    primitive->_quantization = box;
+    primitive->ubo.ptr->_quantization = box;
+  }
+  if(lods && !lods->levels.empty()) {
+    auto &p = *primitive;
+    auto numLevels = std::min(uint32_t(lods->levels.size()), Primitive::maxNumLODs - 1);
+    p._lodIndices = Buffer.indices->add(
+      device_, lods->indices.data(), lods->levels[numLevels - 1].endOffset());
+    p._numLODs = numLevels + 1;
+    for(uint32_t i = 0; i < numLevels; ++i) {
+      p._lods[i] = {p._lodIndices.offset + lods->levels[i].offset, lods->levels[i].size};
+      p._lodErrors[i] = lods->errors[i];
+      p.ubo.ptr->_lods[i] = p._lods[i];
+      p.ubo.ptr->_lodErrors[i] = p._lodErrors[i];
+    }
+    p.ubo.ptr->_numLODs = p._numLODs;
+  }
+  if(!clusters.empty()) {
+    auto &p = *primitive;
+    p._clusters =
+      Buffer.clusters->add(device_, clusters.data(), uint32_t(clusters.size()));
+    p.ubo.ptr->_clusters = p._clusters;
+  }
+  return primitive;
+}
+
+Ptr<Primitive> BasicSceneManager::newSkinnedPrimitive(
+  const Vertex::Position *positions, const Vertex::Normal *normals, const Vertex::UV *uvs,
+  const Vertex::Joint *joints, const Vertex::Weight *weights, uint32_t numVertices,
+  const uint32_t *indices, uint32_t numIndices, const AABB &aabb) {
+  std::vector<uint32_t> optimized;
+  std::vector<Vertex::Position> optimizedPositions;
+  std::vector<Vertex::Normal> optimizedNormals;
+  std::vector<Vertex::UV> optimizedUVs;
+  std::vector<Vertex::Joint> optimizedJoints;
+  std::vector<Vertex::Weight> optimizedWeights;
+  if(meshOptimizer_) {
+    optimized.assign(indices, indices + numIndices);
+    meshOptimizer_->optimizeTriangles(optimized, positions, numVertices);
+    auto remap = MeshOptimizer::optimizeVertexFetch(optimized, numVertices);
+    optimizedPositions = MeshOptimizer::remap(positions, remap);
+    optimizedNormals = MeshOptimizer::remap(normals, remap);
+    optimizedUVs = MeshOptimizer::remap(uvs, remap);
+    optimizedJoints = MeshOptimizer::remap(joints, remap);
+    optimizedWeights = MeshOptimizer::remap(weights, remap);
+    positions = optimizedPositions.data();
+    normals = optimizedNormals.data();
+    uvs = optimizedUVs.data();
+    joints = optimizedJoints.data();
+    weights = optimizedWeights.data();
+    indices = optimized.data();
+    numIndices = uint32_t(optimized.size());
+  }
+  auto primitive = uploadPrimitive(
+    positions, numVertices, normals, numVertices, uvs, numVertices, indices, numIndices,
+    aabb, PrimitiveTopology::Triangles, DynamicType::Static);
+  primitive->_joint0 = Buffer.joint0->add(device_, joints, numVertices);
+  primitive->_weight0 = Buffer.weight0->add(device_, weights, numVertices);
+  primitive->ubo.ptr->_joint0 = primitive->_joint0;
+  primitive->ubo.ptr->_weight0 = primitive->_weight0;
+  return primitive;
 }
 
 Ptr<Primitive> BasicSceneManager::newPrimitive(const PrimitiveBuilder &primitiveBuilder) {
@@ -254,44 +463,75 @@ Ptr<Primitive> BasicSceneManager::newDynamicPrimitive(
                        topology, DynamicType::Dynamic});
 }
 
+void BasicSceneManager::removePrimitive(Ptr<Primitive> primitive) {
+  errorIf(!primitive || primitive->_released, "primitive has been removed!");
+  auto index = primitive.index();
+  errorIf(
+    index < Scene.primitiveUsers.size() && !Scene.primitiveUsers[index].empty(),
+    "primitive is still drawn by mesh instances!");
+  for(auto &comp: computeMeshes)
+    errorIf(
+      comp.primitive.index() == index, "primitive is still used by a compute mesh!");
+
+  auto &p = *primitive;
+  Storage.retired.push_back({Storage.frame, p._index, p._position, p._normal, p._uv,
+                             p._joint0, p._weight0, p.ubo, p._quantized,
+                             p._lodIndices, p._clusters});
+  p._index = p._position = p._normal = p._uv = p._joint0 = p._weight0 = {};
+  p._lodIndices = p._clusters = {};
+  p._numLODs = 1;
+  p._released = true;
+}
+
 Ptr<Texture2D> BasicSceneManager::newTexture(
   const std::string &imagePath, const SamplerDef &samplerDef, bool generateMipmap) {
-  ensureTextures(1);
   auto t = Texture2D::loadFromFile(
     device_, imagePath, vk::Format::eR8G8B8A8Srgb, generateMipmap);
-  t.setSampler(SamplerMaker(samplerDef).createUnique(vkDevice));
-  return Ptr<Texture2D>::add(Image.textures, std::move(t));
+  t.setSampler(SamplerMaker(samplerDef).createShared(device_));
+  return addTexture(std::move(t));
 }
 
 Ptr<Texture2D> BasicSceneManager::newTexture(
   const unsigned char *bytes, size_t size, uint32_t width, uint32_t height,
   const SamplerDef &samplerDef, bool generateMipmap) {
-  ensureTextures(1);
   auto t = Texture2D::loadFromBytes(device_, bytes, size, width, height, generateMipmap);
-  t.setSampler(SamplerMaker(samplerDef).createUnique(vkDevice));
-  return Ptr<Texture2D>::add(Image.textures, std::move(t));
+  t.setSampler(SamplerMaker(samplerDef).createShared(device_));
+  return addTexture(std::move(t));
 }
 
 Ptr<TextureImageCube> BasicSceneManager::newCubeTexture(
   const std::string &imagePath, const SamplerDef &samplerDef, bool generateMipmap) {
-  ensureTextures(1);
-
   TextureImageCube texture =
     TextureImageCube::loadFromFile(device_, imagePath, generateMipmap);
   SamplerMaker maker{samplerDef};
   maker.maxLod(float(texture.getInfo().mipLevels));
-  texture.setSampler(maker.createUnique(device_.getDevice()));
+  texture.setSampler(maker.createShared(device_));
 
   return Ptr<TextureImageCube>::add(Image.cubeTextures, std::move(texture));
 }
 
 Ptr<Texture2D> BasicSceneManager::newGrayTexture(
   const std::string &imagePath, const SamplerDef &samplerDef, bool generateMipmap) {
-  ensureTextures(1);
   auto t = Texture2D::loadFromGrayScaleFile(
     device_, imagePath, vk::Format::eR16Unorm, generateMipmap);
-  t.setSampler(SamplerMaker(samplerDef).createUnique(vkDevice));
-  return Ptr<Texture2D>::add(Image.textures, std::move(t));
+  t.setSampler(SamplerMaker(samplerDef).createShared(device_));
+  return addTexture(std::move(t));
+}
+
+Ptr<Texture2D> BasicSceneManager::addTexture(Texture2D &&texture) {
+  auto slot = Image.table->allocate();
+  if(slot == Image.textures.size()) Image.textures.push_back(std::move(texture));
+  else
+    Image.textures[slot] = std::move(texture);
+  Image.table->set(slot, Image.textures[slot]);
+  return Ptr<Texture2D>{&Image.textures, slot};
+}
+
+void BasicSceneManager::removeTexture(Ptr<Texture2D> texture) {
+  errorIf(!texture || !texture->imageView(), "texture has been removed!");
+  errorIf(texture.index() == 0, "the empty texture can't be removed!");
+  Storage.retiredTextures.push_back(
+    {Storage.frame, texture.index(), std::move(*texture)});
 }
 
 Ptr<Material> BasicSceneManager::newMaterial(MaterialType type) {
@@ -304,9 +544,20 @@ Ptr<Mesh> BasicSceneManager::newMesh(Ptr<Primitive> primitive, Ptr<Material> mat
 
 Ptr<Node> BasicSceneManager::newNode(
   const Transform &transform, const std::string &name) {
+  Scene.nodeOrderStale = true;
   return Ptr<Node>::add(Scene.nodes, Node{*this, transform, name});
 }
 
+Ptr<Skin> BasicSceneManager::newSkin(
+  std::vector<Ptr<Node>> &&joints, std::vector<glm::mat4> &&inverseBindMatrices) {
+  errorIf(
+    joints.size() != inverseBindMatrices.size(),
+    "skin needs one inverse bind matrix per joint!");
+  auto ibmOffset = skinningManager_->addSkin(inverseBindMatrices);
+  return Ptr<Skin>::add(
+    Scene.skins, Skin{std::move(joints), std::move(inverseBindMatrices), ibmOffset});
+}
+
 Ptr<Model> BasicSceneManager::newModel(
   std::vector<Ptr<Node>> &&nodes, std::vector<Animation> &&animations) {
   return Ptr<Model>::add(
@@ -314,8 +565,21 @@ Ptr<Model> BasicSceneManager::newModel(
 }
 
 Ptr<Model> BasicSceneManager::loadModel(const std::string &file) {
-  GLTFLoader loader{*this};
-  return loader.load(file);
+  // models of the same name in different directories get their own cache files.
+  std::filesystem::path path{file};
+  auto absolute = std::filesystem::absolute(path).string();
+  auto key = sim::util::fnv1a(absolute.data(), absolute.size());
+  auto cacheFile =
+    cachePath(toString(path.filename().string(), ".", std::hex, key, ".simcache"));
+  if(cacheFile.empty()) {
+    GLTFLoader loader{*this, modelConfig_.numLoaderThreads};
+    return loader.load(file);
+  }
+  if(scene_cache::valid(cacheFile)) return scene_cache::load(*this, cacheFile);
+
+  SceneCacheWriter cache{cacheFile, file};
+  GLTFLoader loader{*this, modelConfig_.numLoaderThreads};
+  return loader.load(file, &cache);
 }
 
 Ptr<ModelInstance> BasicSceneManager::newModelInstance(
@@ -326,9 +590,41 @@ Ptr<ModelInstance> BasicSceneManager::newModelInstance(
   return instance;
 }
 
+void BasicSceneManager::removeModelInstance(Ptr<ModelInstance> instance) {
+  errorIf(!instance || instance->_removed, "model instance has been removed!");
+  animationManager_->remove(instance);
+
+  auto &model = instance->_model.get();
+  RetiredInstance retired{Storage.frame};
+  retired.transform = instance->_ubo;
+  retired.pose = instance->_pose;
+  retired.poseSize = uint32_t(model._hierarchy.size());
+  for(auto &meshInstance: instance->_meshInstances) {
+    Buffer.drawQueue->remove(meshInstance._batch, meshInstance._ubo.offset);
+    retired.meshInstances.push_back(meshInstance._ubo);
+    if(meshInstance._skinned) {
+      skinningManager_->remove(meshInstance._skinJob);
+      auto &vertices = meshInstance._skinnedVertices;
+      Storage.retired.push_back({Storage.frame, {}, vertices, vertices, vertices});
+    }
+    if(!meshInstance._primitive) continue;
+    auto &users = Scene.primitiveUsers[meshInstance._primitive.index()];
+    users.erase(
+      std::remove_if(
+        users.begin(), users.end(),
+        [&](const MeshInstanceRef &user) {
+          return user.instance.index() == instance.index();
+        }),
+      users.end());
+  }
+  Storage.retiredInstances.push_back(std::move(retired));
+  instance->_meshInstances.clear();
+  instance->_removed = true;
+}
+
 void BasicSceneManager::useEnvironmentMap(Ptr<TextureImageCube> envMap) {
   EnvMapGenerator envMapGenerator{device_, *this};
-  Image.brdfLUT = envMapGenerator.generateBRDFLUT();
+  if(!Image.brdfLUT) Image.brdfLUT = envMapGenerator.generateBRDFLUT();
   auto cubes = envMapGenerator.generateEnvMap(*envMap);
   Image.irradiance = std::move(cubes.irradiance);
   Image.preFiltered = std::move(cubes.preFiltered);
@@ -353,8 +649,8 @@ void BasicSceneManager::computeMesh(
   ComputePipelineMaker pipelineMaker{vkDevice};
   pipelineMaker.shader(shaderPath);
 
-  vk::UniquePipeline pipeline =
-    pipelineMaker.createUnique(nullptr, *computeMeshLayoutDef.pipelineLayout);
+  vk::UniquePipeline pipeline = pipelineMaker.createUnique(
+    device_.getPipelineCache(), *computeMeshLayoutDef.pipelineLayout);
   computeMeshes.push_back(
     {dispatchNumX, dispatchNumY, dispatchNumZ, primitive, std::move(pipeline)});
 }
@@ -367,27 +663,217 @@ Ptr<Light> BasicSceneManager::addLight(
 void BasicSceneManager::updateScene(
   vk::CommandBuffer transferCB, vk::CommandBuffer computeCB, uint32_t imageIndex,
   float elapsedDuration) {
-  if(Scene.camera.incoherent()) Buffer.camera->update(device_, Scene.camera.flush());
+  // frames in flight read their own copy, so the current one is written every frame.
+  if(Scene.camera.incoherent()) Buffer.cameraUBO = Scene.camera.flush();
+  Buffer.camera->update(device_, imageIndex, Buffer.cameraUBO);
 
-  if(Scene.lighting.incoherent())
-    Buffer.lighting->update(device_, Scene.lighting.flush());
+  if(Scene.lighting.incoherent()) Buffer.lightingUBO = Scene.lighting.flush();
+  Buffer.lighting->update(device_, imageIndex, Buffer.lightingUBO);
 
   updateTextures();
+  releaseRanges();
+  defragment(transferCB);
+  animationManager_->update(elapsedDuration);
+  updateTransforms();
 
   computeMesh(computeCB, imageIndex, elapsedDuration);
+  flushSlices(imageIndex);
+  ++Storage.frame;
 }
 
-void BasicSceneManager::updateTextures() {
-  if(Image.textures.size() > Image.lastImagesCount) {
-    for(int i = Image.lastImagesCount; i < Image.textures.size(); ++i)
-      Image.sampler2Ds[i] = {Image.textures[i].sampler(), Image.textures[i].imageView(),
-                             vk::ImageLayout ::eShaderReadOnlyOptimal};
-    basicSetDef.textures(
-      Image.lastImagesCount, uint32_t(Image.textures.size()) - Image.lastImagesCount,
-      Image.sampler2Ds.data() + Image.lastImagesCount);
-    Image.lastImagesCount = uint32_t(Image.textures.size());
-    basicSetDef.update(Sets.basicSet);
+void BasicSceneManager::flushSlices(uint32_t imageIndex) {
+  // the fence of imageIndex has signaled, so no frame in flight reads these slices.
+  Buffer.transforms->flush(imageIndex);
+  Buffer.materials->flush(imageIndex);
+  Buffer.meshInstances->flush(imageIndex);
+  Buffer.lights->flush(imageIndex);
+  Buffer.drawQueue->flush(imageIndex);
+}
+
+void BasicSceneManager::updateTextures() { Image.table->update(Storage.frame); }
+
+void BasicSceneManager::releaseRanges() {
+  auto &retired = Storage.retired;
+  // ranges retired at frame r were last read by frame r-1, which completed before this
+  // frame once r-1+numFrame frames are updated.
+  auto released = retired.begin();
+  for(; released != retired.end(); ++released) {
+    if(Storage.frame + 1 < released->frame + config_.numFrame) break;
+    Buffer.indices->remove(released->index);
+    Buffer.indices->remove(released->lodIndices);
+    if(Buffer.clusters) Buffer.clusters->remove(released->clusters);
+    if(released->quantized) {
+      Buffer.quantizedPosition->remove(released->position);
+      Buffer.quantizedNormal->remove(released->normal);
+      Buffer.quantizedUV->remove(released->uv);
+    } else {
+      Buffer.position->remove(released->position);
+      Buffer.normal->remove(released->normal);
+      Buffer.uv->remove(released->uv);
+    }
+    Buffer.joint0->remove(released->joint0);
+    Buffer.weight0->remove(released->weight0);
+    if(released->ubo.ptr) Buffer.primitives->deallocate(released->ubo);
+  }
+  retired.erase(retired.begin(), released);
+
+  auto &instances = Storage.retiredInstances;
+  auto releasedInstance = instances.begin();
+  for(; releasedInstance != instances.end(); ++releasedInstance) {
+    if(Storage.frame + 1 < releasedInstance->frame + config_.numFrame) break;
+    for(auto &ubo: releasedInstance->meshInstances)
+      Buffer.meshInstances->deallocate(ubo);
+    Buffer.transforms->deallocate(releasedInstance->transform);
+    if(releasedInstance->pose.ptr)
+      Buffer.transforms->deallocate(releasedInstance->pose, releasedInstance->poseSize);
+  }
+  instances.erase(instances.begin(), releasedInstance);
+
+  auto &textures = Storage.retiredTextures;
+  auto releasedTexture = textures.begin();
+  for(; releasedTexture != textures.end(); ++releasedTexture) {
+    if(Storage.frame + 1 < releasedTexture->frame + config_.numFrame) break;
+    Image.table->release(releasedTexture->slot);
+  }
+  textures.erase(textures.begin(), releasedTexture);
+}
+
+void BasicSceneManager::defragment(vk::CommandBuffer cb) {
+  auto budget = modelConfig_.defragmentBudget;
+  if(budget == 0) return;
+  auto &moves = Storage.moves;
+  if(!moves.empty()) {
+    // the copies are complete with the frame that recorded them. Frames still in flight
+    // read either the old or the new ranges, which hold the same data.
+    if(Storage.frame < Storage.movesFrame + config_.numFrame) return;
+    for(auto &move: moves) {
+      auto &p = *move.primitive;
+      if(p._released) {
+        RetiredRanges moved{Storage.frame, move.index, move.vertex, move.vertex,
+                            move.vertex};
+        moved.quantized = p._quantized;
+        Storage.retired.push_back(moved);
+        continue;
+      }
+      RetiredRanges old{Storage.frame};
+      old.quantized = p._quantized;
+      if(move.vertex.size) {
+        old.position = p._position;
+        old.normal = p._normal;
+        old.uv = p._uv;
+        p._position = p._normal = p._uv = move.vertex;
+      }
+      if(move.index.size) {
+        old.index = p._index;
+        p._index = move.index;
+      }
+      p.ubo.ptr->_index = p._index;
+      p.ubo.ptr->_position = p._position;
+      p.ubo.ptr->_normal = p._normal;
+      p.ubo.ptr->_uv = p._uv;
+      auto index = move.primitive.index();
+      if(index < Scene.primitiveUsers.size())
+        for(auto &user: Scene.primitiveUsers[index])
+          user.instance->_meshInstances[user.mesh].writeDrawCMDs();
+      Storage.retired.push_back(old);
+    }
+    moves.clear();
+    return;
+  }
+
+  // the static primitives that move all live in the quantized streams, or all in the
+  // full ones.
+  auto quantized = modelConfig_.quantizeVertices;
+  auto moveVertices = quantized ? Buffer.quantizedPosition->fragmented() :
+                                  Buffer.position->fragmented();
+  auto moveIndices = Buffer.indices->fragmented();
+  if(!moveVertices && !moveIndices) return;
+
+  auto moveStreams = [&](auto &positions, auto &normals, auto &uvs, const Primitive &p,
+                         Range &moved) {
+    Range position, normal, uv;
+    auto numVertices = p._position.size;
+    auto end = p._position.offset;
+    if(!positions.allocateBelow(numVertices, end, position)) return;
+    // the streams share their free blocks, so they find the same one.
+    if(
+      normals.allocateBelow(numVertices, end, normal) &&
+      uvs.allocateBelow(numVertices, end, uv) && normal.offset == position.offset &&
+      uv.offset == position.offset) {
+      positions.copy(cb, p._position, position.offset);
+      normals.copy(cb, p._normal, normal.offset);
+      uvs.copy(cb, p._uv, uv.offset);
+      moved = position;
+    } else {
+      positions.remove(position);
+      normals.remove(normal);
+      uvs.remove(uv);
+    }
+  };
+
+  debugMarker_.begin(cb, "defragment");
+  auto &primitives = Scene.primitives;
+  for(uint32_t i = 0; i < primitives.size() && budget > 0; ++i) {
+    auto &p = primitives[i];
+    // dynamic and skinned primitives are written by the gpu every frame; they stay put.
+    if(p._released || p._type != DynamicType::Static || p._joint0.size > 0) continue;
+    PrimitiveMove move{Ptr<Primitive>{&primitives, i}};
+
+    auto numVertices = p._position.size;
+    auto inLockstep = p._normal.offset == p._position.offset &&
+                      p._uv.offset == p._position.offset &&
+                      p._normal.size == numVertices && p._uv.size == numVertices;
+    if(moveVertices && inLockstep && numVertices > 0 && numVertices <= budget) {
+      if(quantized)
+        moveStreams(
+          *Buffer.quantizedPosition, *Buffer.quantizedNormal, *Buffer.quantizedUV, p,
+          move.vertex);
+      else
+        moveStreams(*Buffer.position, *Buffer.normal, *Buffer.uv, p, move.vertex);
+      budget -= move.vertex.size;
+    }
+
+    // only the full indices move; the coarser levels of detail stay where they are.
+    auto numIndices = p._index.size;
+    if(
+      moveIndices && numIndices > 0 && numIndices <= budget &&
+      Buffer.indices->allocateBelow(numIndices, p._index.offset, move.index)) {
+      Buffer.indices->copy(cb, p._index, move.index.offset);
+      budget -= numIndices;
+    }
+    if(move.vertex.size || move.index.size) moves.push_back(move);
   }
+  debugMarker_.end(cb);
+  Storage.movesFrame = Storage.frame;
+}
+
+void BasicSceneManager::updateTransforms() {
+  auto &nodes = Scene.nodes;
+  auto &order = Scene.nodeOrder;
+  if(Scene.nodeOrderStale) {
+    order.clear();
+    order.reserve(nodes.size());
+    std::vector<uint32_t> stack;
+    for(auto i = uint32_t(nodes.size()); i-- > 0;)
+      if(!nodes[i]._parent) stack.push_back(i);
+    while(!stack.empty()) {
+      auto i = stack.back();
+      stack.pop_back();
+      nodes[i]._order = uint32_t(order.size());
+      order.push_back(i);
+      auto &children = nodes[i]._children;
+      for(auto child = children.rbegin(); child != children.rend(); ++child)
+        stack.push_back(child->index());
+    }
+    Scene.nodeOrderStale = false;
+    Scene.firstDirtyNode = 0;
+  }
+
+  for(auto i = Scene.firstDirtyNode; i < order.size(); ++i) {
+    auto &node = nodes[order[i]];
+    if(node._dirty) node.updateMatrix();
+  }
+  Scene.firstDirtyNode = std::numeric_limits<uint32_t>::max();
 }
 
 void BasicSceneManager::computeMesh(
@@ -419,16 +905,38 @@ void BasicSceneManager::computeMesh(
       debugMarker_.end(cb);
     }
   }
+  skinningManager_->compute(cb, imageIndex);
   if(oceanManager_->enabled()) oceanManager_->compute(cb, imageIndex, elapsedDuration);
 }
 
+void BasicSceneManager::cullScene(vk::CommandBuffer cb, uint32_t imageIndex) {
+  cullingManager_->cull(cb, imageIndex);
+}
+
+void BasicSceneManager::buildDepthPyramid(vk::CommandBuffer cb, uint32_t imageIndex) {
+  cullingManager_->buildDepthPyramid(cb, imageIndex);
+}
+
 void BasicSceneManager::drawScene(vk::CommandBuffer cb, uint32_t imageIndex) {
   vk::DeviceSize zero{0};
   auto stride = sizeof(vk::DrawIndexedIndirectCommand);
 
+  // dynamic offsets follow binding order: cam, meshInstances, transforms, material,
+  // lighting, lights.
+  std::array<uint32_t, 6> offsets{
+    Buffer.camera->offset(imageIndex),
+    Buffer.meshInstances->offset(imageIndex),
+    Buffer.transforms->offset(imageIndex),
+    Buffer.materials->offset(imageIndex),
+    Buffer.lighting->offset(imageIndex),
+    Buffer.lights->offset(imageIndex),
+  };
   cb.bindDescriptorSets(
     bindpoint::eGraphics, *basicLayout.pipelineLayout, basicLayout.basic.set(),
-    Sets.basicSet, nullptr);
+    Sets.basicSet, offsets);
+  cb.bindDescriptorSets(
+    bindpoint::eGraphics, *basicLayout.pipelineLayout, basicLayout.textures.set(),
+    Image.table->descriptorSet(), nullptr);
   cb.bindDescriptorSets(
     bindpoint::eGraphics, *basicLayout.pipelineLayout, basicLayout.deferred.set(),
     Sets.deferredSet, nullptr);
@@ -441,52 +949,64 @@ void BasicSceneManager::drawScene(vk::CommandBuffer cb, uint32_t imageIndex) {
       bindpoint::eGraphics, *basicLayout.pipelineLayout, basicLayout.sky.set(),
       skyManager_->skySet, nullptr);
 
-  cb.bindVertexBuffers(0, Buffer.position->buffer(), zero);
-  cb.bindVertexBuffers(1, Buffer.normal->buffer(), zero);
-  cb.bindVertexBuffers(2, Buffer.uv->buffer(), zero);
+  bindVertexBuffers(cb, false);
   cb.bindIndexBuffer(Buffer.indices->buffer(), zero, vk::IndexType::eUint32);
 
+  // with quantized vertices, static draws switch to the quantized streams and pipelines
+  // and dynamic draws back to the full ones.
+  using Pipelines = BasicRenderer::GeometryPipelines;
+  using Pipeline = vk::UniquePipeline Pipelines::*;
+  auto quantized = modelConfig_.quantizeVertices;
+  Pipelines &staticPipelines =
+    quantized ? renderer.QuantizedPipelines : renderer.Pipelines;
+  auto bindStatic = [&](Pipeline pipeline) {
+    if(quantized) bindVertexBuffers(cb, true);
+    cb.bindPipeline(bindpoint::eGraphics, *(staticPipelines.*pipeline));
+  };
+  auto bindDynamic = [&](Pipeline pipeline) {
+    if(!quantized) return;
+    bindVertexBuffers(cb, false);
+    cb.bindPipeline(bindpoint::eGraphics, *(renderer.Pipelines.*pipeline));
+  };
+
   debugMarker_.begin(cb, "Subpass opaque tri");
-  if(RenderPass.wireframe)
-    cb.bindPipeline(bindpoint::eGraphics, *renderer.Pipelines.opaqueTriWireframe);
-  else
-    cb.bindPipeline(bindpoint::eGraphics, *renderer.Pipelines.opaqueTri);
-  cb.drawIndexedIndirect(
-    Buffer.drawQueue->buffer(DrawQueue::DrawType::OpaqueTriangles), 0,
-    Buffer.drawQueue->count(DrawQueue::DrawType::OpaqueTriangles), stride);
+  auto opaqueTri =
+    RenderPass.wireframe ? &Pipelines::opaqueTriWireframe : &Pipelines::opaqueTri;
+  bindStatic(opaqueTri);
+  cullingManager_->draw(cb, imageIndex, DrawQueue::DrawType::OpaqueTriangles);
   debugMarker_.end(cb);
 
   debugMarker_.begin(cb, "Subpass dynamic opaque tri");
+  bindDynamic(opaqueTri);
   cb.drawIndexedIndirect(
     Buffer.drawQueue->buffer(DrawQueue::DrawType::OpaqueTriangles, imageIndex), 0,
     Buffer.drawQueue->count(DrawQueue::DrawType::OpaqueTriangles, imageIndex), stride);
   debugMarker_.end(cb);
 
   debugMarker_.begin(cb, "Subpass terrain");
-  if(RenderPass.wireframe)
-    cb.bindPipeline(bindpoint::eGraphics, *renderer.Pipelines.terrainTessWireframe);
-  else
-    cb.bindPipeline(bindpoint::eGraphics, *renderer.Pipelines.terrainTess);
-
+  auto terrain =
+    RenderPass.wireframe ? &Pipelines::terrainTessWireframe : &Pipelines::terrainTess;
+  bindStatic(terrain);
   cb.drawIndexedIndirect(
-    Buffer.drawQueue->buffer(DrawQueue::DrawType::Terrain), 0,
+    Buffer.drawQueue->buffer(DrawQueue::DrawType::Terrain),
+    Buffer.drawQueue->offset(DrawQueue::DrawType::Terrain, imageIndex),
     Buffer.drawQueue->count(DrawQueue::DrawType::Terrain), stride);
   debugMarker_.end(cb);
 
   debugMarker_.begin(cb, "Subpass dynamic terrain");
+  bindDynamic(terrain);
   cb.drawIndexedIndirect(
     Buffer.drawQueue->buffer(DrawQueue::DrawType::Terrain, imageIndex), 0,
     Buffer.drawQueue->count(DrawQueue::DrawType::Terrain, imageIndex), stride);
   debugMarker_.end(cb);
 
   debugMarker_.begin(cb, "Subpass opaque line");
-  cb.bindPipeline(bindpoint::eGraphics, *renderer.Pipelines.opaqueLine);
-  cb.drawIndexedIndirect(
-    Buffer.drawQueue->buffer(DrawQueue::DrawType::OpaqueLines), 0,
-    Buffer.drawQueue->count(DrawQueue::DrawType::OpaqueLines), stride);
+  bindStatic(&Pipelines::opaqueLine);
+  cullingManager_->draw(cb, imageIndex, DrawQueue::DrawType::OpaqueLines);
   debugMarker_.end(cb);
 
   debugMarker_.begin(cb, "Subpass dynamic opaque line");
+  bindDynamic(&Pipelines::opaqueLine);
   cb.drawIndexedIndirect(
     Buffer.drawQueue->buffer(DrawQueue::DrawType::OpaqueLines, imageIndex), 0,
     Buffer.drawQueue->count(DrawQueue::DrawType::OpaqueLines, imageIndex), stride);
@@ -505,13 +1025,12 @@ void BasicSceneManager::drawScene(vk::CommandBuffer cb, uint32_t imageIndex) {
 
   debugMarker_.begin(cb, "Subpass translucent tri");
   cb.nextSubpass(vk::SubpassContents::eInline);
-  cb.bindPipeline(bindpoint::eGraphics, *renderer.Pipelines.transTri);
-  cb.drawIndexedIndirect(
-    Buffer.drawQueue->buffer(DrawQueue::DrawType::TransparentTriangles), 0,
-    Buffer.drawQueue->count(DrawQueue::DrawType::TransparentTriangles), stride);
+  bindStatic(&Pipelines::transTri);
+  cullingManager_->draw(cb, imageIndex, DrawQueue::DrawType::TransparentTriangles);
   debugMarker_.end(cb);
 
   debugMarker_.begin(cb, "Subpass dynamic translucent tri");
+  bindDynamic(&Pipelines::transTri);
   cb.drawIndexedIndirect(
     Buffer.drawQueue->buffer(DrawQueue::DrawType::TransparentTriangles, imageIndex), 0,
     Buffer.drawQueue->count(DrawQueue::DrawType::TransparentTriangles, imageIndex),
@@ -519,12 +1038,11 @@ void BasicSceneManager::drawScene(vk::CommandBuffer cb, uint32_t imageIndex) {
   debugMarker_.end(cb);
 
   debugMarker_.begin(cb, "Subpass translucent line");
-  cb.bindPipeline(bindpoint::eGraphics, *renderer.Pipelines.transLine);
-  cb.drawIndexedIndirect(
-    Buffer.drawQueue->buffer(DrawQueue::DrawType::TransparentLines), 0,
-    Buffer.drawQueue->count(DrawQueue::DrawType::TransparentLines), stride);
+  bindStatic(&Pipelines::transLine);
+  cullingManager_->draw(cb, imageIndex, DrawQueue::DrawType::TransparentLines);
 
   debugMarker_.begin(cb, "Subpass dynamic translucent line");
+  bindDynamic(&Pipelines::transLine);
   cb.drawIndexedIndirect(
     Buffer.drawQueue->buffer(DrawQueue::DrawType::TransparentLines, imageIndex), 0,
     Buffer.drawQueue->count(DrawQueue::DrawType::TransparentLines, imageIndex), stride);
@@ -536,28 +1054,41 @@ void BasicSceneManager::drawScene(vk::CommandBuffer cb, uint32_t imageIndex) {
   debugMarker_.end(cb);
 }
 
+void BasicSceneManager::bindVertexBuffers(vk::CommandBuffer cb, bool quantized) {
+  vk::DeviceSize zero{0};
+  if(quantized) {
+    cb.bindVertexBuffers(0, Buffer.quantizedPosition->buffer(), zero);
+    cb.bindVertexBuffers(1, Buffer.quantizedNormal->buffer(), zero);
+    cb.bindVertexBuffers(2, Buffer.quantizedUV->buffer(), zero);
+  } else {
+    cb.bindVertexBuffers(0, Buffer.position->buffer(), zero);
+    cb.bindVertexBuffers(1, Buffer.normal->buffer(), zero);
+    cb.bindVertexBuffers(2, Buffer.uv->buffer(), zero);
+  }
+}
+
 void BasicSceneManager::debugInfo() {
   auto totalMeshes = modelConfig_.maxNumMeshes + modelConfig_.maxNumLineMeshes +
                      modelConfig_.maxNumTransparentMeshes +
                      modelConfig_.maxNumTransparentLineMeshes;
+  auto numVertices = modelConfig_.quantizeVertices ? Buffer.quantizedPosition->count() :
+                                                     Buffer.position->count();
+  auto samplers = device_.samplers().stats();
   sim::debugLog(
-    "vertices: ", Buffer.position->count(), "/", modelConfig_.maxNumVertex,
+    "vertices: ", numVertices, "/", modelConfig_.maxNumVertex,
     ", indices: ", Buffer.indices->count(), "/", modelConfig_.maxNumIndex,
     ", transforms: ", Buffer.transforms->count(), "/", modelConfig_.maxNumTransform,
     ", meshes: ", Scene.meshes.size(), "/", totalMeshes,
     ", materials: ", Buffer.materials->count(), "/", modelConfig_.maxNumMaterial,
-    ", textures: ", Image.textures.size(), "/", modelConfig_.maxNumTexture,
+    ", textures: ", Image.table->count(), "/", Image.table->capacity(),
+    ", samplers: ", samplers.live, " (hits ", samplers.hits, ", misses ", samplers.misses,
+    ")",
     ", lights: ", Scene.lights.size(), "/", modelConfig_.maxNumLights);
 }
 
 DebugMarker &BasicSceneManager::debugMarker() { return debugMarker_; }
 Device &BasicSceneManager::device() { return device_; }
 
-void BasicSceneManager::ensureTextures(uint32_t toAdd) const {
-  errorIf(
-    Image.textures.size() + toAdd > modelConfig_.maxNumTexture,
-    "exceeding maximum number of textures!");
-}
 Ptr<Primitive> BasicSceneManager::primitive(uint32_t index) {
   assert(index < Scene.primitives.size());
   return Ptr<Primitive>{&Scene.primitives, index};
@@ -579,4 +1110,12 @@ void BasicSceneManager::setWireframe(bool wireframe) { RenderPass.wireframe = wi
 bool BasicSceneManager::wireframe() { return RenderPass.wireframe; }
 const Config &BasicSceneManager::config() const { return config_; }
 const ModelConfig &BasicSceneManager::modelConfig() const { return modelConfig_; }
+std::string BasicSceneManager::cachePath(const std::string &name) const {
+  auto &dir = modelConfig_.cacheDir;
+  if(dir.empty()) return {};
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if(ec) debugLog("failed to create cache directory", dir, ec.message());
+  return (std::filesystem::path{dir} / name).string();
+}
 }
\ No newline at end of file
@@ -13,14 +13,21 @@
 #include "model_config.h"
 #include "model/basic_model.h"
 #include "model/draw_queue.h"
+#include "model/texture_table.h"
 #include "model/light.h"
 #include "model/model_instance.h"
 #include "builder/primitive_builder.h"
+#include "builder/mesh_optimizer.h"
+#include "builder/mesh_simplifier.h"
+#include "builder/cluster_builder.h"
 #include "perspective_camera.h"
 #include "terrain/terrain_manager.h"
 #include "sim/graphics/renderer/basic/sky/sky_manager.h"
 #include "ocean/ocean_manager.h"
 #include "shadow/shadow_manager.h"
+#include "culling/culling_manager.h"
+#include "animation/animation_manager.h"
+#include "skinning/skinning_manager.h"
 #include "model/dynamic/dynamic_mesh_manager.h"
 
 namespace sim::graphics::renderer::basic {
@@ -28,19 +35,30 @@ namespace sim::graphics::renderer::basic {
 class BasicRenderer;
 
 class BasicSceneManager {
-  using flag = vk::DescriptorBindingFlagBitsEXT;
   using shader = vk::ShaderStageFlagBits;
   friend class BasicRenderer;
 
 public:
   explicit BasicSceneManager(BasicRenderer &renderer);
 
+  /**
+   * @param lods the coarser levels of detail of a static triangle primitive, built with
+   * MeshSimplifier::buildLODs. Without them they are built here when
+   * ModelConfig::generateLODs is set, which ignores them otherwise.
+   */
   Ptr<Primitive> newPrimitive(
     const Vertex::Position *positions, uint32_t numPositions,
     const Vertex::Normal *normals, uint32_t numNormals, const Vertex::UV *uvs,
     uint32_t numUVs, const uint32_t *indices, uint32_t numIndices, const AABB &aabb,
     const PrimitiveTopology &topology = PrimitiveTopology::Triangles,
-    const DynamicType &type = DynamicType::Static);
+    const DynamicType &type = DynamicType::Static, const LODChain *lods = nullptr);
+
+  /**a static primitive with the joint0/weight0 streams of a skinned mesh.*/
+  Ptr<Primitive> newSkinnedPrimitive(
+    const Vertex::Position *positions, const Vertex::Normal *normals,
+    const Vertex::UV *uvs, const Vertex::Joint *joints, const Vertex::Weight *weights,
+    uint32_t numVertices, const uint32_t *indices, uint32_t numIndices,
+    const AABB &aabb);
 
   Ptr<Primitive> newPrimitive(const PrimitiveBuilder &primitiveBuilder);
   std::vector<Ptr<Primitive>> newPrimitives(const PrimitiveBuilder &primitiveBuilder);
@@ -49,6 +67,12 @@ public:
     uint32_t numVertices, uint32_t numIndices, const AABB &aabb,
     const PrimitiveTopology &topology = PrimitiveTopology::Triangles);
 
+  /**
+   * release the vertex and index ranges of primitive once no frame in flight reads them.
+   * No mesh instance may draw primitive anymore, and it can't be used afterwards.
+   */
+  void removePrimitive(Ptr<Primitive> primitive);
+
   Ptr<Texture2D> newTexture(
     const std::string &imagePath, const SamplerDef &samplerDef = {},
     bool generateMipmap = true);
@@ -65,12 +89,21 @@ public:
     const std::string &imagePath, const SamplerDef &samplerDef = {},
     bool generateMipmap = true);
 
+  /**
+   * destroy texture and reuse its slot once no frame in flight reads it. No material may
+   * sample texture anymore, and it can't be used afterwards.
+   */
+  void removeTexture(Ptr<Texture2D> texture);
+
   Ptr<Material> newMaterial(MaterialType type = MaterialType::eNone);
 
   Ptr<Mesh> newMesh(Ptr<Primitive> primitive, Ptr<Material> material);
 
   Ptr<Node> newNode(const Transform &transform = {}, const std::string &name = "");
 
+  Ptr<Skin> newSkin(
+    std::vector<Ptr<Node>> &&joints, std::vector<glm::mat4> &&inverseBindMatrices);
+
   Ptr<Model> newModel(
     std::vector<Ptr<Node>> &&nodes, std::vector<Animation> &&animations = {});
 
@@ -78,6 +111,12 @@ public:
 
   Ptr<ModelInstance> newModelInstance(Ptr<Model> model, const Transform &transform = {});
 
+  /**
+   * stop drawing instance and animating it, and give its draw commands and buffer slots
+   * back. Slots are reused once no frame in flight reads them.
+   */
+  void removeModelInstance(Ptr<ModelInstance> instance);
+
   void useEnvironmentMap(Ptr<TextureImageCube> envMap);
 
   void computeMesh(
@@ -96,6 +135,9 @@ public:
   OceanManager &oceanManager();
 
   ShadowManager &shadowManager();
+  CullingManager &cullingManager();
+  AnimationManager &animationManager();
+  SkinningManager &skinningManager();
 
   Ptr<Primitive> primitive(uint32_t index);
   Ptr<Material> material(uint32_t index);
@@ -109,6 +151,9 @@ public:
   Device &device();
   const Config &config() const;
   const ModelConfig &modelConfig() const;
+  /**@return the path of the cache file name in ModelConfig::cacheDir, or empty if the
+   * caches are disabled.*/
+  std::string cachePath(const std::string &name) const;
 
 private:
   friend class Material;
@@ -118,27 +163,61 @@ private:
   friend class Light;
   friend class Primitive;
   friend class OceanManager;
+  friend class CullingManager;
+  friend class SkinningManager;
 
   Allocation<Material::UBO> allocateMaterialUBO();
   Allocation<Light::UBO> allocateLightUBO();
   Allocation<glm::mat4> allocateMatrixUBO();
+  Allocation<glm::mat4> allocateMatrixUBO(uint32_t num);
   Allocation<Primitive::UBO> allocatePrimitiveUBO();
   Allocation<MeshInstance::UBO> allocateMeshInstanceUBO();
-  auto allocateDrawCMD(const Ptr<Primitive> &primitive, const Ptr<Material> &material)
-    -> std::vector<Allocation<vk::DrawIndexedIndirectCommand>>;
+  /**@return the batch drawing the mesh instance whose UBO is at meshInstance.*/
+  uint32_t allocateDrawCMD(
+    const Ptr<Primitive> &primitive, const Ptr<Material> &material,
+    const DynamicType &type, uint32_t meshInstance, bool visible);
+  /**allocate numVertices positions, normals and uvs for each frame, in lockstep.*/
+  Range allocateSkinnedVertices(uint32_t numVertices);
+  void addPrimitiveUser(
+    const Ptr<Primitive> &primitive, const Ptr<ModelInstance> &instance, uint32_t mesh);
 
 private:
+  /**upload the streams of a new primitive as they are.*/
+  Ptr<Primitive> uploadPrimitive(
+    const Vertex::Position *positions, uint32_t numPositions,
+    const Vertex::Normal *normals, uint32_t numNormals, const Vertex::UV *uvs,
+    uint32_t numUVs, const uint32_t *indices, uint32_t numIndices, const AABB &aabb,
+    const PrimitiveTopology &topology, const DynamicType &type,
+    const LODChain *lods = nullptr, const std::vector<Cluster> &clusters = {});
   void resize(vk::Extent2D extent);
   void updateScene(
     vk::CommandBuffer transferCB, vk::CommandBuffer computeCB, uint32_t imageIndex,
     float elapsedDuration);
+  /**write the descriptors of new textures, growing the texture table as needed.*/
   void updateTextures();
+  /**free the retired ranges and slots that no frame in flight reads anymore.*/
+  void releaseRanges();
+  /**copy the host writes to the per-frame buffers into the slices of imageIndex.*/
+  void flushSlices(uint32_t imageIndex);
+  /**
+   * move static primitives down into free blocks of the vertex and index buffers, within
+   * the defragment budget. The copies are recorded in cb; primitives and draw commands
+   * switch to the new ranges once the frame that copies them completes.
+   */
+  void defragment(vk::CommandBuffer cb);
+  /**recompute the world matrices of dirty nodes and their descendants.*/
+  void updateTransforms();
   void computeMesh(
     vk::CommandBuffer computeCB, uint32_t imageIndex, float elapsedDuration);
 
+  void cullScene(vk::CommandBuffer cb, uint32_t imageIndex);
+  void buildDepthPyramid(vk::CommandBuffer cb, uint32_t imageIndex);
   void drawScene(vk::CommandBuffer cb, uint32_t imageIndex);
+  /**bind the quantized vertex streams of static primitives, or the full ones.*/
+  void bindVertexBuffers(vk::CommandBuffer cb, bool quantized);
 
-  void ensureTextures(uint32_t toAdd) const;
+  /**place texture in a slot of the texture table.*/
+  Ptr<Texture2D> addTexture(Texture2D &&texture);
 
 private:
   BasicRenderer &renderer;
@@ -153,6 +232,11 @@ private:
   uPtr<SkyManager> skyManager_;
   uPtr<OceanManager> oceanManager_;
   uPtr<ShadowManager> shadowManager_;
+  uPtr<CullingManager> cullingManager_;
+  uPtr<AnimationManager> animationManager_;
+  uPtr<SkinningManager> skinningManager_;
+  /**set with ModelConfig::optimizeIndices.*/
+  uPtr<MeshOptimizer> meshOptimizer_;
 
   struct {
     uPtr<DeviceVertexBuffer<Vertex::Position>> position;
@@ -161,40 +245,107 @@ private:
     uPtr<DeviceVertexBuffer<Vertex::UV>> uv;
     uPtr<DeviceVertexBuffer<Vertex::Joint>> joint0;
     uPtr<DeviceVertexBuffer<Vertex::Weight>> weight0;
+    /**vertex streams of static primitives with ModelConfig::quantizeVertices.*/
+    uPtr<DeviceVertexBuffer<QuantizedVertex::Position>> quantizedPosition;
+    uPtr<DeviceVertexBuffer<QuantizedVertex::Normal>> quantizedNormal;
+    uPtr<DeviceVertexBuffer<QuantizedVertex::UV>> quantizedUV;
     uPtr<DeviceIndexBuffer> indices;
+    /**clusters of static primitives with ModelConfig::clusterTriangles.*/
+    uPtr<DeviceStorageBuffer<Cluster>> clusters;
 
+    /**written on the host every frame, so they are sliced per frame like camera.*/
     uPtr<HostManagedStorageUBOBuffer<Material::UBO>> materials;
     uPtr<HostManagedStorageUBOBuffer<glm::mat4>> transforms;
     uPtr<HostManagedStorageUBOBuffer<Primitive::UBO>> primitives;
     uPtr<HostManagedStorageUBOBuffer<MeshInstance::UBO>> meshInstances;
     uPtr<DrawQueue> drawQueue;
 
-    uPtr<HostUBOBuffer<PerspectiveCamera::UBO>> camera;
+    uPtr<HostDynamicUBOBuffer<PerspectiveCamera::UBO>> camera;
+    PerspectiveCamera::UBO cameraUBO;
 
-    uPtr<HostUBOBuffer<Lighting::UBO>> lighting;
+    uPtr<HostDynamicUBOBuffer<Lighting::UBO>> lighting;
+    Lighting::UBO lightingUBO;
     uPtr<HostManagedStorageUBOBuffer<Light::UBO>> lights;
 
   } Buffer;
 
+  struct MeshInstanceRef {
+    Ptr<ModelInstance> instance;
+    uint32_t mesh;
+  };
+
   struct {
     std::vector<Primitive> primitives;
     std::vector<Primitive> dynamicPrimitives;
     std::vector<Material> materials;
     std::vector<Mesh> meshes;
     std::vector<Node> nodes;
+    std::vector<Skin> skins;
+    /**indices of nodes, parents before their children.*/
+    std::vector<uint32_t> nodeOrder;
+    bool nodeOrderStale{false};
+    uint32_t firstDirtyNode{std::numeric_limits<uint32_t>::max()};
     std::vector<Model> models;
     std::vector<ModelInstance> instances;
+    /**mesh instances drawing each primitive, by primitive index.*/
+    std::vector<std::vector<MeshInstanceRef>> primitiveUsers;
 
     PerspectiveCamera camera{{10, 10, 10}, {0, 0, 0}, {0, 1, 0}};
     Lighting lighting{};
     std::vector<Light> lights;
   } Scene;
 
+  /**ranges given back to the buffers once the frames up to frame are complete.*/
+  struct RetiredRanges {
+    uint64_t frame;
+    Range index, position, normal, uv, joint0, weight0;
+    Allocation<Primitive::UBO> ubo{0, nullptr};
+    /**position, normal and uv are in the quantized streams.*/
+    bool quantized{false};
+    Range lodIndices;
+    Range clusters;
+  };
+
+  /**buffer slots of a removed model instance, reused once the frames up to frame are
+   * complete.*/
+  struct RetiredInstance {
+    uint64_t frame;
+    std::vector<Allocation<MeshInstance::UBO>> meshInstances;
+    Allocation<glm::mat4> transform;
+    Allocation<glm::mat4> pose;
+    uint32_t poseSize;
+  };
+
+  /**a removed texture, destroyed and its slot reused once the frames up to frame are
+   * complete.*/
+  struct RetiredTexture {
+    uint64_t frame;
+    uint32_t slot;
+    Texture2D texture;
+  };
+
+  /**new ranges of a primitive, copied from its current ones.*/
+  struct PrimitiveMove {
+    Ptr<Primitive> primitive;
+    Range index, vertex;
+  };
+
+  struct {
+    /**number of frames updated so far.*/
+    uint64_t frame{0};
+    std::vector<RetiredRanges> retired;
+    std::vector<RetiredInstance> retiredInstances;
+    std::vector<RetiredTexture> retiredTextures;
+    std::vector<PrimitiveMove> moves;
+    /**the frame that recorded the copies of moves.*/
+    uint64_t movesFrame{0};
+  } Storage;
+
   struct {
-    std::vector<vk::DescriptorImageInfo> sampler2Ds;
+    /**the 2d textures, at the index of their slot in table.*/
     std::vector<Texture2D> textures;
+    uPtr<TextureTable> table;
     std::vector<TextureImageCube> cubeTextures;
-    uint32_t lastImagesCount{0};
 
     uPtr<Texture2D> brdfLUT;
     uPtr<TextureImageCube> irradiance, preFiltered;
@@ -212,20 +363,17 @@ private:
   } RenderPass;
 
   struct BasicSetDef: DescriptorSetDef {
-    __uniform__(
+    __uniformDynamic__(
       cam, shader::eVertex | shader::eFragment | shader::eTessellationControl |
              shader::eTessellationEvaluation);
     __buffer__(primitives, shader::eVertex | shader::eTessellationControl);
-    __buffer__(meshInstances, shader::eVertex | shader::eTessellationControl);
-    __buffer__(transforms, shader::eVertex | shader::eTessellationControl);
-    __buffer__(
+    __bufferDynamic__(meshInstances, shader::eVertex | shader::eTessellationControl);
+    __bufferDynamic__(transforms, shader::eVertex | shader::eTessellationControl);
+    __bufferDynamic__(
       material, shader::eVertex | shader::eFragment | shader::eTessellationControl);
-    __samplers__(
-      textures, flag{},
-      shader::eVertex | shader::eFragment | shader::eTessellationControl |
-        shader::eTessellationEvaluation);
-    __uniform__(lighting, shader::eFragment);
-    __buffer__(lights, shader::eFragment);
+    __uniformDynamic__(lighting, shader::eFragment);
+    __bufferDynamic__(lights, shader::eFragment);
+    __buffer__(instanceIDs, shader::eVertex);
   } basicSetDef;
 
   struct DeferredSetDef: DescriptorSetDef {
@@ -249,6 +397,7 @@ private:
     __set__(ibl, IBLSetDef);
     __set__(sky, SkyManager::SkySetDef);
     __set__(shadow, ShadowManager::ShadowMapDescriptorSet);
+    __set__(textures, TextureTable::TextureSetDef);
   } basicLayout;
 
   struct ComputeSetDef: DescriptorSetDef {
@@ -0,0 +1,170 @@
+#include "cluster_builder.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "sim/util/syntactic_sugar.h"
+
+namespace sim::graphics::renderer::basic {
+std::vector<Cluster> ClusterBuilder::build(
+  std::vector<uint32_t> &indices, const glm::vec3 *positions, uint32_t numVertices) {
+  auto numTriangles = uint32_t(indices.size() / 3);
+  if(numTriangles < minClusteredTriangles) return {};
+  indices.resize(numTriangles * 3);
+
+  std::vector<glm::vec3> normals(numTriangles);
+  for(uint32_t t = 0; t < numTriangles; ++t) {
+    auto &p0 = positions[indices[t * 3]];
+    auto normal =
+      glm::cross(positions[indices[t * 3 + 1]] - p0, positions[indices[t * 3 + 2]] - p0);
+    auto area = glm::length(normal);
+    normals[t] = area > 0 ? normal / area : glm::vec3{0};
+  }
+
+  // triangles around each vertex.
+  std::vector<uint32_t> offsets(numVertices + 1, 0), adjacency(indices.size());
+  for(auto v: indices)
+    ++offsets[v + 1];
+  for(uint32_t v = 0; v < numVertices; ++v)
+    offsets[v + 1] += offsets[v];
+  {
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for(uint32_t i = 0; i < indices.size(); ++i)
+      adjacency[fill[indices[i]]++] = i / 3;
+  }
+  auto centroid = [&](uint32_t t) {
+    return (positions[indices[t * 3]] + positions[indices[t * 3 + 1]] +
+            positions[indices[t * 3 + 2]]) /
+           3.f;
+  };
+
+  // clusterOf marks the triangles taken; the stamps mark what the current cluster holds.
+  std::vector<uint32_t> clusterOf(numTriangles, uint32max);
+  std::vector<uint32_t> vertexStamp(numVertices, uint32max);
+  std::vector<uint32_t> candidateStamp(numTriangles, uint32max);
+  std::vector<uint32_t> members, candidates, sorted;
+  std::vector<Cluster> clusters;
+  sorted.reserve(indices.size());
+  uint32_t cursor = 0;
+  while(true) {
+    while(cursor < numTriangles && clusterOf[cursor] != uint32max)
+      ++cursor;
+    if(cursor == numTriangles) break;
+
+    auto id = uint32_t(clusters.size());
+    glm::vec3 normalSum{0}, centroidSum{0};
+    members.clear();
+    candidates.clear();
+    auto add = [&](uint32_t t) {
+      clusterOf[t] = id;
+      members.push_back(t);
+      normalSum += normals[t];
+      centroidSum += centroid(t);
+      for(uint32_t k = 0; k < 3; ++k) {
+        auto v = indices[t * 3 + k];
+        vertexStamp[v] = id;
+        for(auto i = offsets[v]; i < offsets[v + 1]; ++i) {
+          auto n = adjacency[i];
+          if(clusterOf[n] != uint32max || candidateStamp[n] == id) continue;
+          candidateStamp[n] = id;
+          candidates.push_back(n);
+        }
+      }
+    };
+    add(cursor);
+
+    while(members.size() < maxClusterTriangles) {
+      auto axisLength = glm::length(normalSum);
+      auto axis = axisLength > 0 ? normalSum / axisLength : glm::vec3{0};
+      int64_t best = -1;
+      float bestScore = 0;
+      for(size_t i = 0; i < candidates.size();) {
+        auto t = candidates[i];
+        if(clusterOf[t] != uint32max) {
+          candidates[i] = candidates.back();
+          candidates.pop_back();
+          continue;
+        }
+        uint32_t newVertices = 0;
+        for(uint32_t k = 0; k < 3; ++k)
+          if(vertexStamp[indices[t * 3 + k]] != id) ++newVertices;
+        auto score = float(newVertices) + 1.f - glm::dot(normals[t], axis);
+        if(
+          best < 0 || score < bestScore ||
+          (score == bestScore && t < candidates[best])) {
+          best = int64_t(i);
+          bestScore = score;
+        }
+        ++i;
+      }
+
+      uint32_t next = uint32max;
+      if(best >= 0) {
+        next = candidates[best];
+        candidates[best] = candidates.back();
+        candidates.pop_back();
+      } else {
+        // a disconnected piece: take the nearest of the next untaken triangles, which
+        // tend to lie close by in a cache optimized order.
+        auto center = centroidSum / float(members.size());
+        auto nearest = std::numeric_limits<float>::max();
+        uint32_t looked = 0;
+        for(auto t = cursor; t < numTriangles && looked < lookAhead; ++t) {
+          if(clusterOf[t] != uint32max) continue;
+          ++looked;
+          auto d = centroid(t) - center;
+          auto distance = glm::dot(d, d);
+          if(distance < nearest) {
+            nearest = distance;
+            next = t;
+          }
+        }
+        if(next == uint32max) break;
+      }
+      add(next);
+    }
+
+    std::sort(members.begin(), members.end());
+    auto first = uint32_t(sorted.size());
+    for(auto t: members)
+      sorted.insert(sorted.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+    auto cluster = bounds(
+      sorted.data() + first, normals.data(), members.data(), uint32_t(members.size()),
+      positions);
+    cluster.index = {first, uint32_t(members.size() * 3)};
+    clusters.push_back(cluster);
+  }
+  indices.swap(sorted);
+  return clusters;
+}
+
+Cluster ClusterBuilder::bounds(
+  const uint32_t *indices, const glm::vec3 *normals, const uint32_t *triangles,
+  uint32_t numTriangles, const glm::vec3 *positions) {
+  glm::vec3 min{std::numeric_limits<float>::max()}, max{-min};
+  for(uint32_t i = 0; i < numTriangles * 3; ++i) {
+    min = glm::min(min, positions[indices[i]]);
+    max = glm::max(max, positions[indices[i]]);
+  }
+  auto center = (min + max) * 0.5f;
+  float radius = 0;
+  for(uint32_t i = 0; i < numTriangles * 3; ++i)
+    radius = std::max(radius, glm::length(positions[indices[i]] - center));
+
+  glm::vec3 axis{0};
+  for(uint32_t i = 0; i < numTriangles; ++i)
+    axis += normals[triangles[i]];
+  auto axisLength = glm::length(axis);
+  float cutoff = 1;
+  if(axisLength > 0) {
+    axis /= axisLength;
+    float minDot = 1;
+    for(uint32_t i = 0; i < numTriangles; ++i) {
+      auto &normal = normals[triangles[i]];
+      if(glm::dot(normal, normal) > 0) minDot = std::min(minDot, glm::dot(normal, axis));
+    }
+    // a cone wider than about 84 degrees hardly ever faces away; leave it unculled.
+    if(minDot > 0.1f) cutoff = std::sqrt(1 - minDot * minDot);
+  }
+  return {glm::vec4{center, radius}, glm::vec4{axis, cutoff}, {}};
+}
+}
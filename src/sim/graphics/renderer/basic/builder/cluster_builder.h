@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "sim/util/range.h"
+#include "sim/graphics/base/glm_common.h"
+
+namespace sim::graphics::renderer::basic {
+using namespace sim::util;
+
+// ref in shaders
+/**a spatially compact run of a primitive's triangles, culled as a whole.*/
+struct alignas(sizeof(glm::vec4)) Cluster {
+  /**bounding sphere: center and radius, in model space.*/
+  glm::vec4 sphere;
+  /**
+   * normal cone: axis and the sine of its half angle. The cluster faces away from any
+   * eye with dot(center - eye, axis) >= cutoff * |center - eye| + radius; a cutoff of 1
+   * never does.
+   */
+  glm::vec4 cone;
+  /**range of the cluster's indices, relative to the primitive's index range.*/
+  Range index;
+};
+
+/**
+ * Splits a triangle list into clusters of at most maxClusterTriangles triangles. A
+ * cluster grows from a seed over the triangles sharing its vertices, preferring the ones
+ * that add the fewest new vertices and bend its normals the least, so clusters are
+ * compact and their normal cones narrow.
+ */
+class ClusterBuilder {
+public:
+  static constexpr uint32_t maxClusterTriangles = 128;
+  /**primitives with fewer triangles are drawn whole.*/
+  static constexpr uint32_t minClusteredTriangles = 4 * maxClusterTriangles;
+
+  /**
+   * reorder indices so that the triangles of each cluster are contiguous; the triangles
+   * of a cluster keep their relative order, so a cache optimized order mostly survives.
+   * @return the clusters, empty if indices has fewer than minClusteredTriangles.
+   */
+  static std::vector<Cluster> build(
+    std::vector<uint32_t> &indices, const glm::vec3 *positions, uint32_t numVertices);
+
+private:
+  /**untaken triangles a cluster without neighbours left looks ahead for the nearest.*/
+  static constexpr uint32_t lookAhead = 64;
+
+  /**
+   * bounding sphere and normal cone of the numTriangles triangles of indices.
+   * @param normals the unit normal of every triangle, zero for degenerate ones.
+   * @param triangles the index of each triangle of indices in normals.
+   */
+  static Cluster bounds(
+    const uint32_t *indices, const glm::vec3 *normals, const uint32_t *triangles,
+    uint32_t numTriangles, const glm::vec3 *positions);
+};
+}
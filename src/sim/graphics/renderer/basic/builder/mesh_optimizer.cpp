@@ -0,0 +1,210 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <numeric>
+#include <limits>
+
+namespace sim::graphics::renderer::basic {
+namespace {
+/**spread the low 10 bits of x to every third bit.*/
+uint32_t spreadBits(uint32_t x) {
+  x &= 0x3ffu;
+  x = (x | (x << 16u)) & 0x030000ffu;
+  x = (x | (x << 8u)) & 0x0300f00fu;
+  x = (x | (x << 4u)) & 0x030c30c3u;
+  x = (x | (x << 2u)) & 0x09249249u;
+  return x;
+}
+}
+
+MeshOptimizer::MeshOptimizer(uint32_t numThreads) {
+  if(numThreads != 1) pool = u<ThreadPool>(numThreads);
+}
+
+void MeshOptimizer::optimizeTriangles(
+  std::vector<uint32_t> &indices, const glm::vec3 *positions, uint32_t numVertices) {
+  indices.resize(indices.size() / 3 * 3);
+  auto numTriangles = indices.size() / 3;
+  if(!pool || numTriangles <= chunkSize) {
+    optimizeChunk(indices.data(), indices.size(), positions);
+    return;
+  }
+
+  sortSpatially(indices, positions, numVertices);
+  auto numChunks = (numTriangles + chunkSize - 1) / chunkSize;
+  pool->parallelFor(numChunks, [&](size_t chunk) {
+    auto first = chunk * chunkSize * 3;
+    auto count = std::min<size_t>(chunkSize * 3, indices.size() - first);
+    optimizeChunk(indices.data() + first, count, positions);
+  });
+}
+
+void MeshOptimizer::sortSpatially(
+  std::vector<uint32_t> &indices, const glm::vec3 *positions, uint32_t numVertices) {
+  glm::vec3 min{std::numeric_limits<float>::max()}, max{-min};
+  for(uint32_t i = 0; i < numVertices; ++i) {
+    min = glm::min(min, positions[i]);
+    max = glm::max(max, positions[i]);
+  }
+  auto range = max - min;
+  auto scale = glm::vec3{
+    range.x > 0 ? 1023 / range.x : 0, range.y > 0 ? 1023 / range.y : 0,
+    range.z > 0 ? 1023 / range.z : 0};
+
+  auto numTriangles = uint32_t(indices.size() / 3);
+  std::vector<uint32_t> codes(numTriangles), order(numTriangles);
+  for(uint32_t t = 0; t < numTriangles; ++t) {
+    auto centroid = (positions[indices[t * 3]] + positions[indices[t * 3 + 1]] +
+                     positions[indices[t * 3 + 2]]) /
+                    3.f;
+    auto cell = glm::uvec3((centroid - min) * scale);
+    codes[t] =
+      spreadBits(cell.x) | spreadBits(cell.y) << 1u | spreadBits(cell.z) << 2u;
+  }
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return codes[a] < codes[b];
+  });
+
+  std::vector<uint32_t> sorted(indices.size());
+  for(uint32_t t = 0; t < numTriangles; ++t)
+    std::copy_n(indices.begin() + order[t] * 3, 3, sorted.begin() + t * 3);
+  indices.swap(sorted);
+}
+
+void MeshOptimizer::optimizeChunk(
+  uint32_t *indices, size_t numIndices, const glm::vec3 *positions) {
+  auto numTriangles = uint32_t(numIndices / 3);
+  if(numTriangles < 2) return;
+
+  // number the chunk's vertices locally, so its tables scale with the chunk.
+  std::vector<uint32_t> vertices(indices, indices + numIndices);
+  std::sort(vertices.begin(), vertices.end());
+  vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+  auto numVertices = uint32_t(vertices.size());
+  std::vector<uint32_t> local(numIndices);
+  for(size_t i = 0; i < numIndices; ++i)
+    local[i] = uint32_t(
+      std::lower_bound(vertices.begin(), vertices.end(), indices[i]) - vertices.begin());
+
+  // triangles around each vertex, and how many of them are not emitted yet.
+  std::vector<uint32_t> live(numVertices, 0), offsets(numVertices + 1, 0);
+  for(auto v: local)
+    ++live[v];
+  for(uint32_t v = 0; v < numVertices; ++v)
+    offsets[v + 1] = offsets[v] + live[v];
+  std::vector<uint32_t> adjacency(numIndices), fill(offsets.begin(), offsets.end() - 1);
+  for(uint32_t i = 0; i < numIndices; ++i)
+    adjacency[fill[local[i]]++] = i / 3;
+
+  // Tipsify: fan around a vertex, then move to the candidate that stays in the cache
+  // longest while its remaining triangles still fit, or to a dead end vertex.
+  std::vector<uint32_t> timestamps(numVertices, 0), deadEnds, candidates;
+  std::vector<bool> emitted(numTriangles, false);
+  std::vector<uint32_t> order, clusterStarts{0};
+  order.reserve(numTriangles);
+  uint32_t time = cacheSize + 1, cursor = 0;
+  int64_t fan = 0;
+  while(fan >= 0) {
+    candidates.clear();
+    for(auto i = offsets[fan]; i < offsets[fan + 1]; ++i) {
+      auto t = adjacency[i];
+      if(emitted[t]) continue;
+      emitted[t] = true;
+      order.push_back(t);
+      for(uint32_t k = 0; k < 3; ++k) {
+        auto v = local[t * 3 + k];
+        deadEnds.push_back(v);
+        candidates.push_back(v);
+        --live[v];
+        if(time - timestamps[v] > cacheSize) timestamps[v] = time++;
+      }
+    }
+
+    int64_t next = -1, best = -1;
+    for(auto v: candidates) {
+      if(live[v] == 0) continue;
+      int64_t priority = 0;
+      if(time - timestamps[v] + 2 * live[v] <= cacheSize) priority = time - timestamps[v];
+      if(priority > best) {
+        best = priority;
+        next = v;
+      }
+    }
+    if(next < 0) {
+      while(next < 0 && !deadEnds.empty()) {
+        auto v = deadEnds.back();
+        deadEnds.pop_back();
+        if(live[v] > 0) next = v;
+      }
+      for(; next < 0 && cursor < numVertices; ++cursor)
+        if(live[cursor] > 0) next = cursor;
+      // a dead end breaks the locality anyway, so clusters may be reordered there.
+      if(next >= 0) clusterStarts.push_back(uint32_t(order.size()));
+    }
+    fan = next;
+  }
+  clusterStarts.push_back(numTriangles);
+  auto numClusters = uint32_t(clusterStarts.size() - 1);
+
+  // draw the clusters facing away from the mesh's center first: they tend to occlude
+  // the others from most view directions.
+  std::vector<uint32_t> clusters(numClusters);
+  std::iota(clusters.begin(), clusters.end(), 0);
+  if(positions && numClusters > 1) {
+    glm::vec3 center{0};
+    for(auto v: vertices)
+      center += positions[v];
+    center /= float(numVertices);
+    std::vector<float> facing(numClusters);
+    for(uint32_t c = 0; c < numClusters; ++c) {
+      glm::vec3 centroid{0}, normal{0};
+      for(auto i = clusterStarts[c]; i < clusterStarts[c + 1]; ++i) {
+        auto t = order[i];
+        auto &p0 = positions[indices[t * 3]];
+        auto &p1 = positions[indices[t * 3 + 1]];
+        auto &p2 = positions[indices[t * 3 + 2]];
+        centroid += p0 + p1 + p2;
+        normal += glm::cross(p1 - p0, p2 - p0);
+      }
+      centroid /= float(3 * (clusterStarts[c + 1] - clusterStarts[c]));
+      facing[c] = glm::dot(centroid - center, normal);
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [&](uint32_t a, uint32_t b) {
+      return facing[a] > facing[b];
+    });
+  }
+
+  std::vector<uint32_t> source(indices, indices + numIndices);
+  auto dst = indices;
+  for(auto c: clusters)
+    for(auto i = clusterStarts[c]; i < clusterStarts[c + 1]; ++i)
+      dst = std::copy_n(source.begin() + order[i] * 3, 3, dst);
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(
+  std::vector<uint32_t> &indices, uint32_t numVertices) {
+  std::vector<uint32_t> remap(numVertices, uint32max);
+  uint32_t next = 0;
+  for(auto &index: indices) {
+    if(remap[index] == uint32max) remap[index] = next++;
+    index = remap[index];
+  }
+  for(auto &index: remap)
+    if(index == uint32max) index = next++;
+  return remap;
+}
+
+float MeshOptimizer::acmr(
+  const uint32_t *indices, size_t numIndices, uint32_t numVertices, uint32_t cacheSize) {
+  auto numTriangles = numIndices / 3;
+  if(numTriangles == 0) return 0;
+  // a vertex is cached while fewer than cacheSize misses happened since it was loaded.
+  std::vector<uint64_t> loadedAt(numVertices, 0);
+  uint64_t misses = cacheSize;
+  for(size_t i = 0; i < numTriangles * 3; ++i) {
+    auto &loaded = loadedAt[indices[i]];
+    if(misses - loaded >= cacheSize) loaded = misses++;
+  }
+  return float(misses - cacheSize) / float(numTriangles);
+}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "sim/util/thread_pool.h"
+#include "sim/util/syntactic_sugar.h"
+#include "sim/graphics/base/glm_common.h"
+
+namespace sim::graphics::renderer::basic {
+/**
+ * Reorders triangle lists for the gpu: triangles are ordered with Tipsify for the
+ * post-transform vertex cache and its clusters sorted so that outward facing ones draw
+ * first, which lowers overdraw; vertices are then renumbered in the order the triangles
+ * first use them, so the attribute streams are fetched linearly.
+ *
+ * Large meshes are sorted along a Morton curve and cut into chunks that are optimized on
+ * the worker threads; only the chunk borders lose cache reuse.
+ */
+class MeshOptimizer {
+public:
+  /**@param numThreads workers for large meshes; 1 optimizes on the calling thread.*/
+  explicit MeshOptimizer(uint32_t numThreads = 0);
+
+  /**
+   * reorder the triangles of indices in place.
+   * @param positions vertex positions, used to order the clusters for overdraw.
+   */
+  void optimizeTriangles(
+    std::vector<uint32_t> &indices, const glm::vec3 *positions, uint32_t numVertices);
+
+  /**
+   * renumber the vertices of indices in the order of first use; unused vertices go last.
+   * @return the new index of every old vertex, to be applied to each stream with remap.
+   */
+  static std::vector<uint32_t> optimizeVertexFetch(
+    std::vector<uint32_t> &indices, uint32_t numVertices);
+
+  /**@return the stream src with every vertex i moved to remap[i].*/
+  template<typename T>
+  static std::vector<T> remap(const T *src, const std::vector<uint32_t> &remap) {
+    std::vector<T> dst(remap.size());
+    for(size_t i = 0; i < remap.size(); ++i)
+      dst[remap[i]] = src[i];
+    return dst;
+  }
+
+  /**
+   * average cache miss ratio: vertex shader invocations per triangle with a FIFO
+   * post-transform cache of cacheSize vertices. 0.5 is ideal for large grids, 3 the
+   * worst.
+   */
+  static float acmr(
+    const uint32_t *indices, size_t numIndices, uint32_t numVertices,
+    uint32_t cacheSize = 16);
+
+private:
+  /**cache size Tipsify optimizes for.*/
+  static constexpr uint32_t cacheSize = 16;
+  /**triangles per chunk of a large mesh.*/
+  static constexpr uint32_t chunkSize = 1u << 16u;
+
+  /**Tipsify the triangles of indices, then order its clusters for overdraw.*/
+  static void optimizeChunk(
+    uint32_t *indices, size_t numIndices, const glm::vec3 *positions);
+  /**sort the triangles of indices along a Morton curve through their centroids.*/
+  static void sortSpatially(
+    std::vector<uint32_t> &indices, const glm::vec3 *positions, uint32_t numVertices);
+
+  uPtr<ThreadPool> pool;
+};
+}
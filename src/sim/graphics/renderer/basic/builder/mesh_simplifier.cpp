@@ -0,0 +1,191 @@
+#include "mesh_simplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace sim::graphics::renderer::basic {
+void MeshSimplifier::Quadric::addPlane(const glm::vec3 &n, float d, float weight) {
+  a2 += weight * n.x * n.x;
+  b2 += weight * n.y * n.y;
+  c2 += weight * n.z * n.z;
+  ab += weight * n.x * n.y;
+  ac += weight * n.x * n.z;
+  bc += weight * n.y * n.z;
+  ad += weight * n.x * d;
+  bd += weight * n.y * d;
+  cd += weight * n.z * d;
+  d2 += weight * d * d;
+  w += weight;
+}
+
+auto MeshSimplifier::Quadric::operator+=(const Quadric &q) -> Quadric & {
+  a2 += q.a2, b2 += q.b2, c2 += q.c2;
+  ab += q.ab, ac += q.ac, bc += q.bc;
+  ad += q.ad, bd += q.bd, cd += q.cd;
+  d2 += q.d2, w += q.w;
+  return *this;
+}
+
+double MeshSimplifier::Quadric::eval(const glm::vec3 &p) const {
+  double x = p.x, y = p.y, z = p.z;
+  return a2 * x * x + b2 * y * y + c2 * z * z +
+         2 * (ab * x * y + ac * x * z + bc * y * z) + 2 * (ad * x + bd * y + cd * z) + d2;
+}
+
+MeshSimplifier::MeshSimplifier(
+  const uint32_t *indices, size_t numIndices, const glm::vec3 *positions,
+  uint32_t numVertices)
+  : indices(indices, indices + numIndices / 3 * 3),
+    positions{positions},
+    quadrics(numVertices),
+    locked(numVertices, false) {
+  // planes weighted by area, so that slivers hardly hold their vertices in place.
+  std::vector<uint64_t> edges;
+  edges.reserve(this->indices.size());
+  auto edge = [](uint32_t a, uint32_t b) { return uint64_t(a) << 32u | b; };
+  for(size_t i = 0; i < this->indices.size(); i += 3) {
+    auto a = this->indices[i], b = this->indices[i + 1], c = this->indices[i + 2];
+    auto normal = glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
+    auto area = glm::length(normal);
+    if(area > 0) {
+      normal /= area;
+      auto d = -glm::dot(normal, positions[a]);
+      for(auto v: {a, b, c})
+        quadrics[v].addPlane(normal, d, area * 0.5f);
+    }
+    edges.push_back(edge(a, b));
+    edges.push_back(edge(b, c));
+    edges.push_back(edge(c, a));
+  }
+  // an edge without its twin lies on a border, or on a seam where vertices are split.
+  std::sort(edges.begin(), edges.end());
+  for(auto e: edges) {
+    auto a = uint32_t(e >> 32u), b = uint32_t(e);
+    if(!std::binary_search(edges.begin(), edges.end(), edge(b, a)))
+      locked[a] = locked[b] = true;
+  }
+}
+
+double MeshSimplifier::cost(uint32_t from, uint32_t to) const {
+  auto q = quadrics[from];
+  q += quadrics[to];
+  return q.w > 0 ? std::max(q.eval(positions[to]) / q.w, 0.0) : 0.0;
+}
+
+bool MeshSimplifier::flips(
+  uint32_t from, uint32_t to, const uint32_t *triangles, uint32_t count) const {
+  for(uint32_t i = 0; i < count; ++i) {
+    auto t = &indices[triangles[i] * 3];
+    if(t[0] == to || t[1] == to || t[2] == to) continue;
+    // rotate from to the front, keeping the winding.
+    auto k = t[0] == from ? 0 : t[1] == from ? 1 : 2;
+    auto &b = positions[t[(k + 1) % 3]], &c = positions[t[(k + 2) % 3]];
+    auto before = glm::cross(b - positions[from], c - positions[from]);
+    auto after = glm::cross(b - positions[to], c - positions[to]);
+    // reject near flips too: slivers would otherwise turn over a little every pass.
+    if(glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after))
+      return true;
+  }
+  return false;
+}
+
+const std::vector<uint32_t> &MeshSimplifier::simplify(size_t targetIndices) {
+  auto numVertices = uint32_t(quadrics.size());
+  std::vector<uint32_t> offsets, adjacency, collapseTo(numVertices);
+  std::vector<bool> touched;
+  std::vector<Collapse> collapses;
+  // a pass moves vertices whose triangles share no other moved vertex, so every flip test
+  // sees the triangles as they end up.
+  while(indices.size() > targetIndices) {
+    offsets.assign(numVertices + 1, 0);
+    for(auto v: indices)
+      ++offsets[v + 1];
+    for(uint32_t v = 0; v < numVertices; ++v)
+      offsets[v + 1] += offsets[v];
+    adjacency.resize(indices.size());
+    {
+      std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+      for(uint32_t i = 0; i < indices.size(); ++i)
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    collapses.clear();
+    for(size_t i = 0; i < indices.size(); ++i) {
+      auto a = indices[i], b = indices[i % 3 == 2 ? i - 2 : i + 1];
+      // interior edges show up once per direction; border edges have locked ends.
+      if(a > b) continue;
+      auto ab = locked[a] ? HUGE_VAL : cost(a, b);
+      auto ba = locked[b] ? HUGE_VAL : cost(b, a);
+      if(ab == HUGE_VAL && ba == HUGE_VAL) continue;
+      collapses.push_back(ab <= ba ? Collapse{a, b, ab} : Collapse{b, a, ba});
+    }
+    if(collapses.empty()) break;
+    // each collapse removes about two triangles; past the cheapest excess candidates,
+    // the cheaper edges of the next pass beat the expensive ones of this pass.
+    auto excess = (indices.size() - targetIndices) / 3;
+    auto window = std::min(collapses.size(), std::max<size_t>(excess, 1));
+    auto cheaper = [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; };
+    std::nth_element(
+      collapses.begin(), collapses.begin() + window - 1, collapses.end(), cheaper);
+    std::sort(collapses.begin(), collapses.begin() + window, cheaper);
+
+    touched.assign(numVertices, false);
+    std::iota(collapseTo.begin(), collapseTo.end(), 0);
+    size_t removed = 0;
+    for(size_t i = 0; i < window && removed < excess; ++i) {
+      auto &c = collapses[i];
+      if(touched[c.from]) continue;
+      auto triangles = adjacency.data() + offsets[c.from];
+      auto count = offsets[c.from + 1] - offsets[c.from];
+      if(flips(c.from, c.to, triangles, count)) continue;
+      for(uint32_t t = 0; t < count; ++t) {
+        auto tri = &indices[triangles[t] * 3];
+        if(tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) ++removed;
+        touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+      }
+      quadrics[c.to] += quadrics[c.from];
+      collapseTo[c.from] = c.to;
+      maxCost = std::max(maxCost, c.cost);
+    }
+    if(removed == 0) break;
+
+    size_t size = 0;
+    for(size_t i = 0; i < indices.size(); i += 3) {
+      auto a = collapseTo[indices[i]], b = collapseTo[indices[i + 1]],
+           c = collapseTo[indices[i + 2]];
+      if(a == b || b == c || c == a) continue;
+      indices[size++] = a;
+      indices[size++] = b;
+      indices[size++] = c;
+    }
+    indices.resize(size);
+  }
+  return indices;
+}
+
+float MeshSimplifier::error() const { return float(std::sqrt(maxCost)); }
+
+LODChain MeshSimplifier::buildLODs(
+  const uint32_t *indices, size_t numIndices, const glm::vec3 *positions,
+  uint32_t numVertices, uint32_t maxLevels) {
+  LODChain chain;
+  auto previous = numIndices / 3 * 3;
+  if(previous < minLevelTriangles * 6) return chain;
+
+  MeshSimplifier simplifier{indices, numIndices, positions, numVertices};
+  for(uint32_t level = 0; level < maxLevels; ++level) {
+    auto target = previous / 6 * 3;
+    if(target < minLevelTriangles * 3) break;
+    auto &simplified = simplifier.simplify(target);
+    // a level that barely shrinks costs memory and draws for nothing; locked borders and
+    // seams stall the simplification.
+    if(simplified.size() > previous / 4 * 3) break;
+    chain.levels.push_back(
+      {uint32_t(chain.indices.size()), uint32_t(simplified.size())});
+    chain.indices.insert(chain.indices.end(), simplified.begin(), simplified.end());
+    chain.errors.push_back(simplifier.error());
+    previous = simplified.size();
+  }
+  return chain;
+}
+}
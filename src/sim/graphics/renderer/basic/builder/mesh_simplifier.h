@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "sim/util/range.h"
+#include "sim/graphics/base/glm_common.h"
+
+namespace sim::graphics::renderer::basic {
+using namespace sim::util;
+
+/**the coarser levels of detail of a triangle list, over the same vertices.*/
+struct LODChain {
+  /**the indices of every level, one level after another.*/
+  std::vector<uint32_t> indices;
+  /**the range of each level in indices, finest first.*/
+  std::vector<Range> levels;
+  /**how far each level deviates from the full triangle list, in position units.*/
+  std::vector<float> errors;
+};
+
+/**
+ * Simplifies a triangle list by quadric error edge collapses (Garland and Heckbert):
+ * every collapse moves a vertex onto a neighbour, so the simplified triangles index the
+ * original vertices and need no new vertex data. Vertices on borders and uv seams, whose
+ * edges belong to a single triangle, never move.
+ */
+class MeshSimplifier {
+public:
+  MeshSimplifier(
+    const uint32_t *indices, size_t numIndices, const glm::vec3 *positions,
+    uint32_t numVertices);
+
+  /**
+   * collapse edges, cheapest first, until at most targetIndices are left or no edge can
+   * collapse without flipping a triangle.
+   * @return the simplified indices.
+   */
+  const std::vector<uint32_t> &simplify(size_t targetIndices);
+  /**the largest deviation of any collapse so far, in position units.*/
+  float error() const;
+
+  /**
+   * simplify indices into up to maxLevels levels, each with about half the triangles of
+   * the level before. The chain ends early once simplification stalls.
+   */
+  static LODChain buildLODs(
+    const uint32_t *indices, size_t numIndices, const glm::vec3 *positions,
+    uint32_t numVertices, uint32_t maxLevels);
+
+private:
+  /**symmetric 4x4 matrix summing the squared distances to weighted planes.*/
+  struct Quadric {
+    double a2{0}, b2{0}, c2{0}, ab{0}, ac{0}, bc{0}, ad{0}, bd{0}, cd{0}, d2{0}, w{0};
+
+    void addPlane(const glm::vec3 &n, float d, float weight);
+    Quadric &operator+=(const Quadric &q);
+    /**weighted squared distance of p to the planes.*/
+    double eval(const glm::vec3 &p) const;
+  };
+
+  struct Collapse {
+    uint32_t from, to;
+    double cost;
+  };
+
+  /**@return the squared error of collapsing from onto to.*/
+  double cost(uint32_t from, uint32_t to) const;
+  /**@return true if moving from to to turns a triangle of from over.*/
+  bool flips(uint32_t from, uint32_t to, const uint32_t *triangles, uint32_t count) const;
+
+  /**a level must have at least these triangles.*/
+  static constexpr size_t minLevelTriangles = 64;
+
+  std::vector<uint32_t> indices;
+  const glm::vec3 *positions;
+  std::vector<Quadric> quadrics;
+  std::vector<bool> locked;
+  double maxCost{0};
+};
+}
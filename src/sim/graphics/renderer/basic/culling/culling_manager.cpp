@@ -0,0 +1,421 @@
+#include "culling_manager.h"
+#include "../basic_scene_manager.h"
+#include "sim/graphics/base/pipeline/descriptor_pool_maker.h"
+#include "sim/graphics/compiledShaders/culling/frustum_cull_comp.h"
+#include "sim/graphics/compiledShaders/culling/occlusion_cull_comp.h"
+#include "sim/graphics/compiledShaders/culling/depth_pyramid_comp.h"
+#include "sim/graphics/compiledShaders/culling/cluster_cull_comp.h"
+
+namespace sim::graphics::renderer::basic {
+using bindpoint = vk::PipelineBindPoint;
+using stage = vk::PipelineStageFlagBits;
+using access = vk::AccessFlagBits;
+using layout = vk::ImageLayout;
+
+CullingManager::CullingManager(BasicSceneManager &mm)
+  : mm{mm},
+    device{mm.device()},
+    debugMarker{mm.debugMarker()},
+    numFrame{mm.config().numFrame},
+    maxGroupsX{device.getLimits().maxComputeWorkGroupCount[0]} {
+  compact = device.supportsDrawIndirectCount();
+  if(mm.modelConfig().generateLODs) lodSlots = Primitive::maxNumLODs;
+  // cluster commands are appended to the compacted ones, which need the counts.
+  if(compact && mm.modelConfig().clusterTriangles) {
+    maxClusterJobs = mm.modelConfig().maxNumClusteredInstances;
+    maxClusterDraws = mm.modelConfig().maxNumClusterDraws;
+    errorIf(
+      maxClusterJobs > maxGroupsX,
+      "maxNumClusteredInstances exceeds the compute work group count limit!");
+  }
+
+  auto &drawQueue = *mm.Buffer.drawQueue;
+  for(size_t i = 0; i < culledTypes.size(); ++i) {
+    regionOffsets[i] = regionSize;
+    regionSize += maxCulledCMDs(int32_t(i), drawQueue.capacity(culledTypes[i]));
+  }
+  culledCMDs = u<IndirectBuffer>(
+    device.allocator(),
+    vk::DeviceSize(numFrame) * regionSize * sizeof(vk::DrawIndexedIndirectCommand));
+  drawCounts = u<IndirectBuffer>(
+    device.allocator(), numFrame * culledTypes.size() * sizeof(uint32_t));
+  debugMarker.name(culledCMDs->buffer(), "culled draw CMDs buffer");
+  debugMarker.name(drawCounts->buffer(), "culled draw counts buffer");
+  // without clustering, the buffers are only bound.
+  clusterJobs = u<StorageBuffer>(
+    device.allocator(),
+    std::max(numFrame * maxClusterJobs, 1u) * sizeof(glm::uvec2));
+  clusterDispatch =
+    u<IndirectBuffer>(device.allocator(), numFrame * sizeof(glm::uvec4));
+  debugMarker.name(clusterJobs->buffer(), "cluster jobs buffer");
+  debugMarker.name(clusterDispatch->buffer(), "cluster dispatch buffer");
+
+  cullSetDef.drawCMDs.descriptorCount() = uint32_t(culledTypes.size());
+  cullSetDef.init(device.getDevice());
+  cullLayoutDef.set(cullSetDef);
+  cullLayoutDef.init(device.getDevice());
+
+  ComputePipelineMaker pipelineMaker{device.getDevice()};
+  pipelineMaker.shader(frustum_cull_comp, __ArraySize__(frustum_cull_comp));
+  frustumPipe =
+    pipelineMaker.createUnique(device.getPipelineCache(), *cullLayoutDef.pipelineLayout);
+  pipelineMaker.shader(occlusion_cull_comp, __ArraySize__(occlusion_cull_comp));
+  occlusionPipe =
+    pipelineMaker.createUnique(device.getPipelineCache(), *cullLayoutDef.pipelineLayout);
+  if(maxClusterJobs > 0) {
+    pipelineMaker.shader(cluster_cull_comp, __ArraySize__(cluster_cull_comp));
+    clusterPipe = pipelineMaker.createUnique(
+      device.getPipelineCache(), *cullLayoutDef.pipelineLayout);
+  }
+
+  pyramidSetDef.init(device.getDevice());
+  pyramidLayoutDef.set(pyramidSetDef);
+  pyramidLayoutDef.init(device.getDevice());
+  pipelineMaker.shader(depth_pyramid_comp, __ArraySize__(depth_pyramid_comp));
+  pyramidPipe = pipelineMaker.createUnique(
+    device.getPipelineCache(), *pyramidLayoutDef.pipelineLayout);
+
+  DescriptorPoolMaker poolMaker;
+  for(uint32_t i = 0; i < maxPyramidLevels; ++i)
+    poolMaker.setLayout(pyramidSetDef);
+  pyramidPool = poolMaker.set(maxPyramidLevels).createUnique(device.getDevice());
+  for(auto &set: pyramidSets)
+    set = pyramidSetDef.createSet(*pyramidPool);
+
+  SamplerMaker samplerMaker;
+  samplerMaker.minFilter(vk::Filter::eNearest)
+    .magFilter(vk::Filter::eNearest)
+    .mipmapMode(vk::SamplerMipmapMode::eNearest)
+    .maxLod(float(maxPyramidLevels));
+  pyramidSampler = samplerMaker.createUnique(device.getDevice());
+
+  if(mm.config().sampleCount > 1) occlusion_ = false;
+}
+
+void CullingManager::createDescriptorSets(vk::DescriptorPool descriptorPool) {
+  cullSet = cullSetDef.createSet(descriptorPool);
+
+  auto &drawQueue = *mm.Buffer.drawQueue;
+  std::array<vk::DescriptorBufferInfo, culledTypes.size()> queues;
+  for(size_t i = 0; i < culledTypes.size(); ++i)
+    queues[i] = {drawQueue.buffer(culledTypes[i]), 0, VK_WHOLE_SIZE};
+
+  cullSetDef.cam(mm.Buffer.camera->buffer(), mm.Buffer.camera->size());
+  cullSetDef.primitives(mm.Buffer.primitives->buffer());
+  cullSetDef.meshInstances(
+    mm.Buffer.meshInstances->buffer(), mm.Buffer.meshInstances->size());
+  cullSetDef.transforms(mm.Buffer.transforms->buffer(), mm.Buffer.transforms->size());
+  cullSetDef.drawCMDs(queues.data());
+  cullSetDef.culledCMDs(culledCMDs->buffer());
+  cullSetDef.drawCounts(drawCounts->buffer());
+  cullSetDef.instanceIDs(drawQueue.instanceIDs());
+  // primitives only have clusters with the cluster buffer.
+  auto &clusters = mm.Buffer.clusters;
+  cullSetDef.clusters(clusters ? clusters->buffer() : clusterJobs->buffer());
+  cullSetDef.clusterJobs(clusterJobs->buffer());
+  cullSetDef.clusterDispatch(clusterDispatch->buffer());
+  cullSetDef.update(cullSet);
+}
+
+void CullingManager::resize(vk::Extent2D extent, Texture &depth) {
+  pyramidValid = false;
+  if(mm.config().sampleCount > 1) return;
+
+  auto vkDevice = device.getDevice();
+  depthImage = depth.image();
+  depthExtent = extent;
+  depthView = depth.createImageView(
+    vkDevice, vk::ImageViewType::e2D, vk::ImageAspectFlagBits::eDepth, 0, 1);
+
+  // level 0 rounds the depth buffer down to a power of two so every level halves exactly.
+  auto prevPow2 = [](uint32_t v) {
+    uint32_t p = 1;
+    while(p * 2 <= v) p *= 2;
+    return p;
+  };
+  depthPyramid =
+    image::depthPyramidUnique(device, prevPow2(extent.width), prevPow2(extent.height));
+  debugMarker.name(depthPyramid->image(), "depth pyramid");
+  auto levels = std::min(depthPyramid->info().mipLevels, maxPyramidLevels);
+
+  pyramidLevelViews.clear();
+  for(uint32_t i = 0; i < levels; ++i)
+    pyramidLevelViews.push_back(vkDevice.createImageViewUnique(
+      {{},
+       depthPyramid->image(),
+       vk::ImageViewType::e2D,
+       vk::Format::eR32Sfloat,
+       {},
+       {vk::ImageAspectFlagBits::eColor, i, 1, 0, 1}}));
+
+  for(uint32_t i = 0; i < levels; ++i) {
+    vk::DescriptorImageInfo src{
+      *pyramidSampler, i == 0 ? *depthView : *pyramidLevelViews[i - 1],
+      i == 0 ? layout::eDepthStencilReadOnlyOptimal : layout::eGeneral};
+    pyramidSetDef.src(&src);
+    pyramidSetDef.dst(*pyramidLevelViews[i]);
+    pyramidSetDef.update(pyramidSets[i]);
+  }
+
+  vk::DescriptorImageInfo pyramid{
+    *pyramidSampler, depthPyramid->imageView(), layout::eGeneral};
+  cullSetDef.depthPyramid(&pyramid);
+  cullSetDef.update(cullSet);
+}
+
+void CullingManager::setEnabled(bool enabled) { enabled_ = enabled; }
+bool CullingManager::enabled() const { return enabled_; }
+void CullingManager::setOcclusionEnabled(bool enabled) {
+  occlusion_ = enabled && mm.config().sampleCount == 1;
+  if(!occlusion_) pyramidValid = false;
+}
+bool CullingManager::occlusionEnabled() const { return occlusion_; }
+void CullingManager::setLODError(float pixels) { lodError_ = pixels; }
+float CullingManager::lodError() const { return lodError_; }
+
+int32_t CullingManager::slot(DrawQueue::DrawType drawType) {
+  for(size_t i = 0; i < culledTypes.size(); ++i)
+    if(culledTypes[i] == drawType) return int32_t(i);
+  return -1;
+}
+
+uint32_t CullingManager::maxCulledCMDs(int32_t i, uint32_t numCMDs) const {
+  auto opaqueTriangles = slot(DrawQueue::DrawType::OpaqueTriangles);
+  return numCMDs * lodSlots + (i == opaqueTriangles ? maxClusterDraws : 0u);
+}
+
+void CullingManager::cull(vk::CommandBuffer cb, uint32_t imageIndex) {
+  if(!enabled_) return;
+  auto &drawQueue = *mm.Buffer.drawQueue;
+  auto numQueues = uint32_t(culledTypes.size());
+  vk::DeviceSize countOffset = imageIndex * numQueues * sizeof(uint32_t);
+  vk::DeviceSize countSize = numQueues * sizeof(uint32_t);
+
+  bool occlusion = occlusion_ && pyramidValid;
+  debugMarker.begin(cb, occlusion ? "occlusion culling" : "frustum culling");
+  if(compact) {
+    cb.fillBuffer(drawCounts->buffer(), countOffset, countSize, 0);
+    vk::BufferMemoryBarrier barrier{access::eTransferWrite,
+                                    access::eShaderRead | access::eShaderWrite,
+                                    VK_QUEUE_FAMILY_IGNORED,
+                                    VK_QUEUE_FAMILY_IGNORED,
+                                    drawCounts->buffer(),
+                                    countOffset,
+                                    countSize};
+    cb.pipelineBarrier(
+      stage::eTransfer, stage::eComputeShader, {}, nullptr, barrier, nullptr);
+  }
+  vk::DeviceSize dispatchOffset = imageIndex * sizeof(glm::uvec4);
+  if(maxClusterJobs > 0) {
+    cb.updateBuffer<glm::uvec4>(
+      clusterDispatch->buffer(), dispatchOffset, glm::uvec4{0, 1, 1, 0});
+    vk::BufferMemoryBarrier barrier{access::eTransferWrite,
+                                    access::eShaderRead | access::eShaderWrite,
+                                    VK_QUEUE_FAMILY_IGNORED,
+                                    VK_QUEUE_FAMILY_IGNORED,
+                                    clusterDispatch->buffer(),
+                                    dispatchOffset,
+                                    sizeof(glm::uvec4)};
+    cb.pipelineBarrier(
+      stage::eTransfer, stage::eComputeShader, {}, nullptr, barrier, nullptr);
+  }
+
+  // dynamic offsets follow binding order: cam, meshInstances, transforms.
+  std::array<uint32_t, 3> offsets{
+    mm.Buffer.camera->offset(imageIndex),
+    mm.Buffer.meshInstances->offset(imageIndex),
+    mm.Buffer.transforms->offset(imageIndex),
+  };
+  cb.bindPipeline(bindpoint::eCompute, occlusion ? *occlusionPipe : *frustumPipe);
+  cb.bindDescriptorSets(
+    bindpoint::eCompute, *cullLayoutDef.pipelineLayout, cullLayoutDef.set.set(), cullSet,
+    offsets);
+  for(uint32_t i = 0; i < numQueues; ++i) {
+    auto numCMDs = drawQueue.count(culledTypes[i]);
+    if(numCMDs == 0) continue;
+    CullConstant constant{pyramidProjView,
+                          i,
+                          numCMDs,
+                          imageIndex * regionSize + regionOffsets[i],
+                          imageIndex * numQueues + i,
+                          compact ? 1u : 0u,
+                          occlusion ? depthPyramid->extent().width : 0u,
+                          occlusion ? depthPyramid->extent().height : 0u,
+                          occlusion ? uint32_t(pyramidLevelViews.size()) : 0u,
+                          drawQueue.idRegionSize(),
+                          lodSlots,
+                          lodError_,
+                          imageIndex,
+                          maxClusterJobs,
+                          maxCulledCMDs(int32_t(i), numCMDs),
+                          imageIndex * drawQueue.capacity(culledTypes[i])};
+    cb.pushConstants<CullConstant>(
+      *cullLayoutDef.pipelineLayout, shader::eCompute, 0, constant);
+    // one workgroup per command, wrapped into y past the work group count limit.
+    auto groupsX = std::min(numCMDs, maxGroupsX);
+    cb.dispatch(groupsX, (numCMDs + groupsX - 1) / groupsX, 1);
+  }
+
+  auto opaqueTriangles = slot(DrawQueue::DrawType::OpaqueTriangles);
+  auto numOpaqueCMDs = drawQueue.count(DrawQueue::DrawType::OpaqueTriangles);
+  auto opaqueCapacity = drawQueue.capacity(DrawQueue::DrawType::OpaqueTriangles);
+  if(maxClusterJobs > 0 && numOpaqueCMDs > 0) {
+    auto jobStride = vk::DeviceSize(sizeof(glm::uvec2));
+    auto countIndex = imageIndex * numQueues + opaqueTriangles;
+    std::array<vk::BufferMemoryBarrier, 3> jobBarriers{
+      vk::BufferMemoryBarrier{access::eShaderWrite, access::eShaderRead,
+                              VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                              clusterJobs->buffer(),
+                              imageIndex * maxClusterJobs * jobStride,
+                              maxClusterJobs * jobStride},
+      vk::BufferMemoryBarrier{access::eShaderRead | access::eShaderWrite,
+                              access::eIndirectCommandRead, VK_QUEUE_FAMILY_IGNORED,
+                              VK_QUEUE_FAMILY_IGNORED, clusterDispatch->buffer(),
+                              dispatchOffset, sizeof(glm::uvec4)},
+      vk::BufferMemoryBarrier{access::eShaderRead | access::eShaderWrite,
+                              access::eShaderRead | access::eShaderWrite,
+                              VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                              drawCounts->buffer(), countIndex * sizeof(uint32_t),
+                              sizeof(uint32_t)}};
+    cb.pipelineBarrier(
+      stage::eComputeShader, stage::eComputeShader | stage::eDrawIndirect, {}, nullptr,
+      jobBarriers, nullptr);
+
+    CullConstant constant{pyramidProjView,
+                          uint32_t(opaqueTriangles),
+                          numOpaqueCMDs,
+                          imageIndex * regionSize + regionOffsets[opaqueTriangles],
+                          countIndex,
+                          1u,
+                          0u,
+                          0u,
+                          0u,
+                          drawQueue.idRegionSize(),
+                          lodSlots,
+                          lodError_,
+                          imageIndex,
+                          maxClusterJobs,
+                          maxCulledCMDs(opaqueTriangles, numOpaqueCMDs),
+                          imageIndex * opaqueCapacity};
+    cb.bindPipeline(bindpoint::eCompute, *clusterPipe);
+    cb.pushConstants<CullConstant>(
+      *cullLayoutDef.pipelineLayout, shader::eCompute, 0, constant);
+    cb.dispatchIndirect(clusterDispatch->buffer(), dispatchOffset);
+  }
+
+  auto cmdStride = vk::DeviceSize(sizeof(vk::DrawIndexedIndirectCommand));
+  std::array<vk::BufferMemoryBarrier, 2> barriers{
+    vk::BufferMemoryBarrier{access::eShaderWrite, access::eIndirectCommandRead,
+                            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                            culledCMDs->buffer(), imageIndex * regionSize * cmdStride,
+                            regionSize * cmdStride},
+    vk::BufferMemoryBarrier{access::eShaderRead | access::eShaderWrite,
+                            access::eIndirectCommandRead, VK_QUEUE_FAMILY_IGNORED,
+                            VK_QUEUE_FAMILY_IGNORED, drawCounts->buffer(), countOffset,
+                            countSize}};
+  cb.pipelineBarrier(
+    stage::eComputeShader, stage::eDrawIndirect, {}, nullptr, barriers, nullptr);
+  auto idStride = vk::DeviceSize(sizeof(uint32_t));
+  vk::BufferMemoryBarrier idBarrier{access::eShaderWrite,
+                                    access::eShaderRead,
+                                    VK_QUEUE_FAMILY_IGNORED,
+                                    VK_QUEUE_FAMILY_IGNORED,
+                                    drawQueue.instanceIDs(),
+                                    drawQueue.culledIDOffset(imageIndex) * idStride,
+                                    drawQueue.idRegionSize() * idStride};
+  cb.pipelineBarrier(
+    stage::eComputeShader, stage::eVertexShader, {}, nullptr, idBarrier, nullptr);
+  debugMarker.end(cb);
+}
+
+void CullingManager::draw(
+  vk::CommandBuffer cb, uint32_t imageIndex, DrawQueue::DrawType drawType) {
+  auto &drawQueue = *mm.Buffer.drawQueue;
+  auto stride = uint32_t(sizeof(vk::DrawIndexedIndirectCommand));
+  auto count = drawQueue.count(drawType);
+  auto i = slot(drawType);
+  if(!enabled_ || i < 0) {
+    cb.drawIndexedIndirect(
+      drawQueue.buffer(drawType), drawQueue.offset(drawType, imageIndex), count, stride);
+    return;
+  }
+
+  auto offset = vk::DeviceSize(imageIndex * regionSize + regionOffsets[i]) * stride;
+  auto maxCount = maxCulledCMDs(i, count);
+  if(compact) {
+    vk::DeviceSize countOffset = (imageIndex * culledTypes.size() + i) * sizeof(uint32_t);
+    cb.drawIndexedIndirectCountKHR(
+      culledCMDs->buffer(), offset, drawCounts->buffer(), countOffset, maxCount, stride);
+  } else
+    cb.drawIndexedIndirect(culledCMDs->buffer(), offset, maxCount, stride);
+}
+
+void CullingManager::buildDepthPyramid(vk::CommandBuffer cb, uint32_t imageIndex) {
+  if(!enabled_ || !occlusion_ || !depthPyramid) return;
+  debugMarker.begin(cb, "depth pyramid");
+
+  vk::ImageSubresourceRange depthRange{
+    vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil, 0, 1, 0, 1};
+  vk::ImageMemoryBarrier depthBarrier{access::eDepthStencilAttachmentWrite,
+                                      access::eShaderRead,
+                                      layout::eDepthStencilAttachmentOptimal,
+                                      layout::eDepthStencilReadOnlyOptimal,
+                                      VK_QUEUE_FAMILY_IGNORED,
+                                      VK_QUEUE_FAMILY_IGNORED,
+                                      depthImage,
+                                      depthRange};
+  vk::ImageMemoryBarrier pyramidBarrier{
+    pyramidValid ? access::eShaderRead : vk::AccessFlags{},
+    access::eShaderWrite,
+    pyramidValid ? layout::eGeneral : layout::eUndefined,
+    layout::eGeneral,
+    VK_QUEUE_FAMILY_IGNORED,
+    VK_QUEUE_FAMILY_IGNORED,
+    depthPyramid->image(),
+    depthPyramid->subresourceRange(vk::ImageAspectFlagBits::eColor)};
+  std::array<vk::ImageMemoryBarrier, 2> barriers{depthBarrier, pyramidBarrier};
+  cb.pipelineBarrier(
+    stage::eEarlyFragmentTests | stage::eLateFragmentTests | stage::eComputeShader,
+    stage::eComputeShader, {}, nullptr, nullptr, barriers);
+
+  cb.bindPipeline(bindpoint::eCompute, *pyramidPipe);
+  glm::uvec2 srcSize{depthExtent.width, depthExtent.height};
+  for(uint32_t i = 0; i < pyramidLevelViews.size(); ++i) {
+    glm::uvec2 dstSize = glm::max(
+      glm::uvec2{depthPyramid->extent().width, depthPyramid->extent().height} >> i, 1u);
+    cb.bindDescriptorSets(
+      bindpoint::eCompute, *pyramidLayoutDef.pipelineLayout, pyramidLayoutDef.set.set(),
+      pyramidSets[i], nullptr);
+    PyramidConstant constant{srcSize, dstSize};
+    cb.pushConstants<PyramidConstant>(
+      *pyramidLayoutDef.pipelineLayout, shader::eCompute, 0, constant);
+    cb.dispatch((dstSize.x + 15) / 16, (dstSize.y + 15) / 16, 1);
+
+    vk::ImageMemoryBarrier levelBarrier{
+      access::eShaderWrite,
+      access::eShaderRead,
+      layout::eGeneral,
+      layout::eGeneral,
+      VK_QUEUE_FAMILY_IGNORED,
+      VK_QUEUE_FAMILY_IGNORED,
+      depthPyramid->image(),
+      {vk::ImageAspectFlagBits::eColor, i, 1, 0, 1}};
+    cb.pipelineBarrier(
+      stage::eComputeShader, stage::eComputeShader, {}, nullptr, nullptr, levelBarrier);
+    srcSize = dstSize;
+  }
+
+  // hand the depth buffer back before the next render pass overwrites it.
+  std::swap(depthBarrier.oldLayout, depthBarrier.newLayout);
+  depthBarrier.srcAccessMask = access::eShaderRead;
+  depthBarrier.dstAccessMask = access::eDepthStencilAttachmentRead |
+                               access::eDepthStencilAttachmentWrite;
+  cb.pipelineBarrier(
+    stage::eComputeShader, stage::eEarlyFragmentTests, {}, nullptr, nullptr,
+    depthBarrier);
+  debugMarker.end(cb);
+
+  pyramidProjView = mm.Buffer.cameraUBO.projView;
+  pyramidValid = true;
+}
+}
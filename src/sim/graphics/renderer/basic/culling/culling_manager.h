@@ -0,0 +1,172 @@
+#pragma once
+#include "sim/graphics/base/device.h"
+#include "sim/graphics/base/debug_marker.h"
+#include "sim/graphics/base/resource/buffers.h"
+#include "sim/graphics/base/resource/images.h"
+#include "sim/graphics/base/pipeline/pipeline.h"
+#include "sim/graphics/base/pipeline/descriptors.h"
+#include "../model/draw_queue.h"
+
+namespace sim::graphics::renderer::basic {
+class BasicSceneManager;
+
+/**
+ * Culls the static draw queues against the camera frustum on the gpu before the
+ * G-buffer subpass. Each frame in flight owns one output region per culled queue; the
+ * surviving commands are compacted into it and counted for drawIndexedIndirectCount.
+ * A workgroup culls the instances of one command and compacts the visible instance IDs
+ * into the frame's culled region of the draw queue's instance ID buffer.
+ * Without VK_KHR_draw_indirect_count the commands keep their slots and culled ones draw
+ * zero instances.
+ *
+ * Occlusion culling tests the survivors against a max-depth pyramid built from the
+ * previous frame's depth buffer and reprojected with that frame's camera, so a mesh that
+ * becomes disoccluded shows up one frame late. It is skipped with multisampled depth.
+ *
+ * With ModelConfig::generateLODs every command emits one output command per level of
+ * detail, each drawing the visible instances that picked that level.
+ *
+ * With ModelConfig::clusterTriangles and compacting, the visible opaque triangle
+ * instances of clustered primitives at their full level become cluster jobs. A second
+ * pass, dispatched indirectly with one workgroup per job, culls each job's clusters
+ * against the frustum and by their normal cones and appends one command per visible
+ * cluster to the opaque triangle commands.
+ */
+class CullingManager {
+public:
+  explicit CullingManager(BasicSceneManager &mm);
+
+  void setEnabled(bool enabled);
+  bool enabled() const;
+  void setOcclusionEnabled(bool enabled);
+  bool occlusionEnabled() const;
+  /**@param pixels the screen space error a level of detail may show, 1 by default.*/
+  void setLODError(float pixels);
+  float lodError() const;
+
+private:
+  friend class BasicSceneManager;
+
+  void createDescriptorSets(vk::DescriptorPool descriptorPool);
+  /**recreate the depth pyramid for the new depth attachment.*/
+  void resize(vk::Extent2D extent, Texture &depth);
+  /**record the culling dispatches; must be outside of a render pass.*/
+  void cull(vk::CommandBuffer cb, uint32_t imageIndex);
+  /**draw the static commands of drawType, culled if the queue is culled.*/
+  void draw(vk::CommandBuffer cb, uint32_t imageIndex, DrawQueue::DrawType drawType);
+  /**downsample this frame's depth into the pyramid; must follow the render pass.*/
+  void buildDepthPyramid(vk::CommandBuffer cb, uint32_t imageIndex);
+
+  /**@return the culled queue slot of drawType, or -1 if drawType isn't culled.*/
+  static int32_t slot(DrawQueue::DrawType drawType);
+  /**@return the most commands culling outputs for the numCMDs commands of slot i.*/
+  uint32_t maxCulledCMDs(int32_t i, uint32_t numCMDs) const;
+
+  // ref in shaders
+  static constexpr std::array<DrawQueue::DrawType, 4> culledTypes{
+    DrawQueue::DrawType::OpaqueTriangles, DrawQueue::DrawType::OpaqueLines,
+    DrawQueue::DrawType::TransparentTriangles, DrawQueue::DrawType::TransparentLines};
+
+  using shader = vk::ShaderStageFlagBits;
+  struct CullSetDef: DescriptorSetDef {
+    __uniformDynamic__(cam, shader::eCompute);
+    __buffer__(primitives, shader::eCompute);
+    __bufferDynamic__(meshInstances, shader::eCompute);
+    __bufferDynamic__(transforms, shader::eCompute);
+    __buffer__(drawCMDs, shader::eCompute);
+    __buffer__(culledCMDs, shader::eCompute);
+    __buffer__(drawCounts, shader::eCompute);
+    __sampler__(depthPyramid, shader::eCompute);
+    __buffer__(instanceIDs, shader::eCompute);
+    __buffer__(clusters, shader::eCompute);
+    __buffer__(clusterJobs, shader::eCompute);
+    __buffer__(clusterDispatch, shader::eCompute);
+  } cullSetDef;
+
+  // ref in shaders
+  struct CullConstant {
+    glm::mat4 prevProjView;
+    uint32_t queue;
+    uint32_t numCMDs;
+    uint32_t outOffset;
+    uint32_t countIndex;
+    uint32_t compact;
+    uint32_t pyramidWidth, pyramidHeight, pyramidLevels;
+    /**distance from an instance ID slot to its culled copy.*/
+    uint32_t culledIDOffset;
+    uint32_t lodSlots;
+    float lodError;
+    uint32_t frame;
+    uint32_t maxClusterJobs;
+    uint32_t maxDraws;
+    /**first command of this frame's slice of the queue.*/
+    uint32_t cmdOffset;
+  };
+
+  struct CullLayoutDef: PipelineLayoutDef {
+    __push_constant__(constant, shader::eCompute, CullConstant);
+    __set__(set, CullSetDef);
+  } cullLayoutDef;
+
+  static constexpr uint32_t maxPyramidLevels = 16;
+
+  struct PyramidSetDef: DescriptorSetDef {
+    __sampler__(src, shader::eCompute);
+    __storageImage__(dst, shader::eCompute);
+  } pyramidSetDef;
+
+  // ref in shaders
+  struct PyramidConstant {
+    glm::uvec2 srcSize;
+    glm::uvec2 dstSize;
+  };
+
+  struct PyramidLayoutDef: PipelineLayoutDef {
+    __push_constant__(constant, shader::eCompute, PyramidConstant);
+    __set__(set, PyramidSetDef);
+  } pyramidLayoutDef;
+
+  BasicSceneManager &mm;
+  Device &device;
+  DebugMarker &debugMarker;
+
+  bool enabled_{true};
+  bool occlusion_{true};
+  bool compact{false};
+  uint32_t numFrame;
+  uint32_t maxGroupsX;
+  /**output commands per command: one per level of detail.*/
+  uint32_t lodSlots{1};
+  float lodError_{1.f};
+  /**cluster jobs per frame and cluster commands per frame, 0 without clustering.*/
+  uint32_t maxClusterJobs{0};
+  uint32_t maxClusterDraws{0};
+  /**first command of each culled queue in a frame's output region.*/
+  std::array<uint32_t, culledTypes.size()> regionOffsets{};
+  uint32_t regionSize{0};
+
+  vk::DescriptorSet cullSet;
+  vk::UniquePipeline frustumPipe;
+  vk::UniquePipeline occlusionPipe;
+  vk::UniquePipeline clusterPipe;
+  vk::UniquePipeline pyramidPipe;
+
+  vk::UniqueDescriptorPool pyramidPool;
+  std::array<vk::DescriptorSet, maxPyramidLevels> pyramidSets;
+  vk::UniqueSampler pyramidSampler;
+  uPtr<Texture> depthPyramid;
+  std::vector<vk::UniqueImageView> pyramidLevelViews;
+  vk::UniqueImageView depthView;
+  vk::Image depthImage;
+  vk::Extent2D depthExtent;
+  /**projView of the frame the pyramid was built from.*/
+  glm::mat4 pyramidProjView{1};
+  bool pyramidValid{false};
+
+  uPtr<IndirectBuffer> culledCMDs;
+  uPtr<IndirectBuffer> drawCounts;
+  uPtr<StorageBuffer> clusterJobs;
+  /**the cluster pass's dispatch of each frame, as uvec4.*/
+  uPtr<IndirectBuffer> clusterDispatch;
+};
+}
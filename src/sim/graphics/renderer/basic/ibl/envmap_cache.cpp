@@ -0,0 +1,123 @@
+#include "envmap_generator.h"
+#include "sim/util/mapped_file.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+namespace sim::graphics::renderer::basic {
+using layout = vk::ImageLayout;
+using aspect = vk::ImageAspectFlagBits;
+
+namespace {
+constexpr uint32_t cacheMagic = 0x4c425353; // "SSBL"
+/**bump whenever the baking shaders or the baked sizes and formats change.*/
+constexpr uint32_t cacheVersion = 1;
+
+struct CacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+};
+
+uint32_t texelSize(vk::Format format) {
+  switch(format) {
+    case vk::Format::eR16G16Sfloat: return 4;
+    case vk::Format::eR16G16B16A16Sfloat: return 8;
+    case vk::Format::eR32G32B32A32Sfloat: return 16;
+    default: error("not supported format!"); return 0;
+  }
+}
+
+/**the regions of every level of texture, one after another, all layers of a level at
+ * once.*/
+std::vector<vk::BufferImageCopy> regions(const Texture &texture, vk::DeviceSize &size) {
+  auto &info = texture.getInfo();
+  std::vector<vk::BufferImageCopy> result;
+  size = 0;
+  for(uint32_t level = 0; level < info.mipLevels; ++level) {
+    vk::Extent3D extent{
+      std::max(info.extent.width >> level, 1u), std::max(info.extent.height >> level, 1u),
+      1};
+    result.push_back(
+      {size, 0, 0, {aspect::eColor, level, 0, info.arrayLayers}, {}, extent});
+    size += vk::DeviceSize(extent.width) * extent.height * info.arrayLayers *
+            texelSize(info.format);
+  }
+  return result;
+}
+}
+
+std::string EnvMapGenerator::cacheFile(const std::string &name) const {
+  return mm.cachePath("ibl." + name + ".simcache");
+}
+
+bool EnvMapGenerator::loadCache(
+  const std::string &cacheFile, uint64_t key, const std::vector<Texture *> &textures) {
+  if(cacheFile.empty()) return false;
+  std::vector<std::vector<vk::BufferImageCopy>> copies(textures.size());
+  std::vector<vk::DeviceSize> sizes(textures.size());
+  size_t size = sizeof(CacheHeader);
+  for(size_t i = 0; i < textures.size(); ++i) {
+    copies[i] = regions(*textures[i], sizes[i]);
+    size += sizes[i];
+  }
+
+  MappedFile file{cacheFile};
+  if(!file.valid() || file.size() != size) return false;
+  CacheHeader header{};
+  std::memcpy(&header, file.data(), sizeof(header));
+  if(header.magic != cacheMagic || header.version != cacheVersion || header.key != key)
+    return false;
+
+  auto data = file.data() + sizeof(header);
+  device.staging().upload(
+    data, size - sizeof(header), 16,
+    [&](vk::CommandBuffer cb, vk::Buffer buf, vk::DeviceSize stagingOffset) {
+      auto offset = stagingOffset;
+      for(size_t i = 0; i < textures.size(); ++i) {
+        auto &texture = *textures[i];
+        texture.setLayoutByGuess(cb, layout::eTransferDstOptimal);
+        for(auto region: copies[i]) {
+          region.bufferOffset += offset;
+          cb.copyBufferToImage(buf, texture.image(), layout::eTransferDstOptimal, region);
+        }
+        texture.setLayoutByGuess(cb, layout::eShaderReadOnlyOptimal);
+        offset += sizes[i];
+      }
+    });
+  debugLog("loaded baked environment lighting", cacheFile);
+  return true;
+}
+
+void EnvMapGenerator::saveCache(
+  const std::string &cacheFile, uint64_t key, const std::vector<Texture *> &textures) {
+  if(cacheFile.empty()) return;
+  // write to a temporary file first so that a crash never leaves a torn cache behind.
+  auto tmpFile = cacheFile + ".tmp";
+  std::ofstream out{tmpFile, std::ios::binary | std::ios::trunc};
+  CacheHeader header{cacheMagic, cacheVersion, key};
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  for(auto texture: textures) {
+    vk::DeviceSize size;
+    auto copies = regions(*texture, size);
+    ReadBackBuffer buffer{
+      device.allocator(), vk::BufferUsageFlagBits::eTransferDst, size};
+    device.graphicsImmediately([&](vk::CommandBuffer cb) {
+      texture->setLayoutByGuess(cb, layout::eTransferSrcOptimal);
+      cb.copyImageToBuffer(
+        texture->image(), layout::eTransferSrcOptimal, buffer.buffer(), copies);
+      texture->setLayoutByGuess(cb, layout::eShaderReadOnlyOptimal);
+    });
+    out.write(buffer.ptr<char>(), std::streamsize(size));
+  }
+  out.close();
+  if(!out) {
+    debugLog("failed to write baked environment lighting", cacheFile);
+    std::remove(tmpFile.c_str());
+    return;
+  }
+  std::remove(cacheFile.c_str());
+  if(std::rename(tmpFile.c_str(), cacheFile.c_str()) != 0) std::remove(tmpFile.c_str());
+}
+}
@@ -20,7 +20,12 @@ public:
   explicit EnvMapGenerator(Device &device, BasicSceneManager &mm)
     : device{device}, mm{mm} {}
 
+  /**render the BRDF LUT, or load it from ModelConfig::cacheDir.*/
   uPtr<Texture2D> generateBRDFLUT();
+  /**
+   * render the irradiance and prefiltered cubes of envCube, or load them from
+   * ModelConfig::cacheDir if envCube was loaded from a file baked before.
+   */
   EnvMaps generateEnvMap(TextureImageCube &envCube);
 
 private:
@@ -28,6 +33,15 @@ private:
     EnvMap envMap, TextureImageCube &cubeMap, TextureImageCube &envCube,
     HostVertexBuffer &vbo, HostIndexBuffer &ibo, const Primitive::UBO &primitive);
 
+  /**@return the file name is cached in, empty if the cache is disabled.*/
+  std::string cacheFile(const std::string &name) const;
+  /**upload every level and layer of textures from cacheFile if it was saved with key.*/
+  bool loadCache(
+    const std::string &cacheFile, uint64_t key, const std::vector<Texture *> &textures);
+  /**read every level and layer of the shader readable textures back into cacheFile.*/
+  void saveCache(
+    const std::string &cacheFile, uint64_t key, const std::vector<Texture *> &textures);
+
 private:
   Device &device;
   BasicSceneManager &mm;
@@ -35,6 +35,9 @@ uPtr<Texture2D> EnvMapGenerator::generateBRDFLUT() {
       .borderColor(vk::BorderColor::eFloatOpaqueWhite);
     brdfLUT->setSampler(maker.createUnique(device.getDevice()));
   }
+  // the LUT only depends on the shaders, which the cache version covers.
+  auto lutFile = cacheFile("brdflut");
+  if(loadCache(lutFile, 0, {brdfLUT.get()})) return brdfLUT;
 
   vk::Format format = brdfLUT->getInfo().format;
   uint32_t dim = brdfLUT->getInfo().extent.width;
@@ -93,7 +96,8 @@ uPtr<Texture2D> EnvMapGenerator::generateBRDFLUT() {
 
     pipelineMaker.shader(shader::eVertex, genbrdflut_vert, __ArraySize__(genbrdflut_vert))
       .shader(shader::eFragment, genbrdflut_frag, __ArraySize__(genbrdflut_frag));
-    pipeline = pipelineMaker.createUnique(nullptr, *pipelineLayout, *renderPass);
+    pipeline = pipelineMaker.createUnique(
+      device.getPipelineCache(), *pipelineLayout, *renderPass);
   }
 
   // Render
@@ -112,6 +116,9 @@ uPtr<Texture2D> EnvMapGenerator::generateBRDFLUT() {
     cb.draw(3, 1, 0, 0);
     cb.endRenderPass();
   });
+  brdfLUT->setCurrentState(
+    layout::eShaderReadOnlyOptimal, access::eShaderRead, stage::eFragmentShader);
+  saveCache(lutFile, 0, {brdfLUT.get()});
 
   auto tEnd = std::chrono::high_resolution_clock::now();
   auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
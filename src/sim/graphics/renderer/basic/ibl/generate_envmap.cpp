@@ -6,6 +6,7 @@
 #include "sim/graphics/compiledShaders/envmap/filtercube_vert.h"
 #include "sim/graphics/compiledShaders/envmap/irradiancecube_frag.h"
 #include "sim/graphics/compiledShaders/envmap/prefilterenvmap_frag.h"
+#include <sstream>
 
 namespace sim::graphics::renderer::basic {
 using loadOp = vk::AttachmentLoadOp;
@@ -46,6 +47,17 @@ EnvMaps EnvMapGenerator::generateEnvMap(TextureImageCube &envCube) {
     prefiltered->setSampler(maker.createUnique(device.getDevice()));
   }
 
+  std::string bakedFile;
+  if(auto key = envCube.contentHash()) {
+    std::ostringstream name;
+    name << std::hex << key;
+    bakedFile = cacheFile(name.str());
+    if(loadCache(bakedFile, key, {irradiance.get(), prefiltered.get()}))
+      return {std::move(irradiance), std::move(prefiltered)};
+  }
+  // envCube may still wait in the staging ring.
+  device.staging().wait(device.staging().flush());
+
   PrimitiveBuilder builder{mm};
   builder.box({}, {0.5f, 0, 0}, {0, 0.5f, 0}, 0.5f);
   builder.newPrimitive();
@@ -55,6 +67,9 @@ EnvMaps EnvMapGenerator::generateEnvMap(TextureImageCube &envCube) {
   auto primitive = builder.primitives()[0];
   generateEnvMap(EnvMap::Irradiance, *irradiance, envCube, *vbo, *ibo, primitive);
   generateEnvMap(EnvMap::PreFiltered, *prefiltered, envCube, *vbo, *ibo, primitive);
+  if(!bakedFile.empty())
+    saveCache(
+      bakedFile, envCube.contentHash(), {irradiance.get(), prefiltered.get()});
   return {std::move(irradiance), std::move(prefiltered)};
 }
 
@@ -175,7 +190,8 @@ void EnvMapGenerator::generateEnvMap(
           shader::eFragment, prefilterenvmap_frag, __ArraySize__(prefilterenvmap_frag));
         break;
     }
-    pipeline = pipelineMaker.createUnique(nullptr, *pipelineLayout, *renderPass);
+    pipeline = pipelineMaker.createUnique(
+      device.getPipelineCache(), *pipelineLayout, *renderPass);
   }
 
   // Render cubemap
@@ -201,13 +217,13 @@ void EnvMapGenerator::generateEnvMap(
   vk::Viewport viewport{0, 0, float(dim), float(dim), 0.0f, 1.0f};
   vk::Rect2D scissor{{0, 0}, {dim, dim}};
 
+  // every face of every level in one submission; the barriers around the copy keep the
+  // offscreen image from being overwritten before it is copied.
   device.graphicsImmediately([&](vk::CommandBuffer cb) {
     offscreen.setLayoutByGuess(cb, layout::eColorAttachmentOptimal);
     cubeMap.setLayoutByGuess(cb, layout::eTransferDstOptimal);
-  });
-  for(auto m = 0u; m < mipLevels; m++)
-    for(auto f = 0u; f < 6; f++) {
-      device.graphicsImmediately([&](vk::CommandBuffer cb) {
+    for(auto m = 0u; m < mipLevels; m++)
+      for(auto f = 0u; f < 6; f++) {
         // Render scene from cube face's point of view
         cb.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
         viewport.width = static_cast<float>(dim * std::pow(0.5f, m));
@@ -256,9 +272,7 @@ void EnvMapGenerator::generateEnvMap(
 
         offscreen.setLayout(
           cb, layout::eTransferSrcOptimal, layout::eColorAttachmentOptimal);
-      });
-    }
-  device.graphicsImmediately([&](vk::CommandBuffer cb) {
+      }
     cubeMap.setLayout(cb, layout::eTransferDstOptimal, layout::eShaderReadOnlyOptimal);
   });
 
@@ -5,28 +5,81 @@
 namespace sim::graphics::renderer::basic {
 using namespace glm;
 
-GLTFLoader::GLTFLoader(BasicSceneManager &mm): mm(mm) {}
-Ptr<Model> GLTFLoader::load(const std::string &file) {
+namespace {
+/**keep images encoded while parsing, so that they can be decoded in parallel later.*/
+bool keepEncoded(
+  tinygltf::Image *image, const int imageIndex, std::string *err, std::string *warn,
+  int reqWidth, int reqHeight, const unsigned char *bytes, int size, void *userData) {
+  int w, h, comp;
+  if(!stbi_info_from_memory(bytes, size, &w, &h, &comp)) {
+    if(err) *err += "unknown image format of image " + std::to_string(imageIndex) + "\n";
+    return false;
+  }
+  image->width = w;
+  image->height = h;
+  image->component = comp;
+  image->bits = 8;
+  image->image.assign(bytes, bytes + size);
+  return true;
+}
+}
+
+GLTFLoader::GLTFLoader(BasicSceneManager &mm, uint32_t numThreads): mm(mm) {
+  if(numThreads != 1) pool = u<ThreadPool>(numThreads);
+}
+
+void GLTFLoader::parallelFor(size_t count, const std::function<void(size_t)> &func) {
+  if(pool) pool->parallelFor(count, func);
+  else
+    for(size_t i = 0; i < count; ++i)
+      func(i);
+}
+
+Ptr<Model> GLTFLoader::load(const std::string &file, SceneCacheWriter *cache) {
+  this->cache = cache;
   tinygltf::Model model;
   tinygltf::TinyGLTF loader;
+  loader.SetImageLoader(keepEncoded, nullptr);
   std::string err, warn;
 
   auto result = endWith(file, ".gltf") ?
                   loader.LoadASCIIFromFile(&model, &err, &warn, file) :
                   loader.LoadBinaryFromFile(&model, &err, &warn, file);
   errorIf(!result, "failed to load glTF ", file);
+  if(cache) {
+    // embedded data uris change with the model file, which is keyed already.
+    auto dir = file.substr(0, file.find_last_of("/\\") + 1);
+    auto source = [&](const std::string &uri) {
+      if(!uri.empty() && uri.compare(0, 5, "data:") != 0) cache->source(dir + uri);
+    };
+    for(auto &buffer: model.buffers)
+      source(buffer.uri);
+    for(auto &image: model.images)
+      source(image.uri);
+  }
 
   loadTextureSamplers(model);
   loadTextures(model);
   loadMaterials(model);
+  loadPrimitives(model);
 
   std::vector<Ptr<Node>> nodes;
   const auto &_scene = model.scenes[std::max(model.defaultScene, 0)];
   _nodes.resize(model.nodes.size());
-  for(int i: _scene.nodes)
+  for(int i: _scene.nodes) {
     nodes.push_back(loadNode(i, model));
+    if(cache) cache->root(nodes.back());
+  }
+
+  primitives.clear();
 
+  loadSkins(model);
   loadAnimations(model);
+  if(cache) {
+    for(auto &animation: animations)
+      cache->animation(animation);
+    cache->finish();
+  }
   return mm.newModel(std::move(nodes), std::move(animations));
 }
 
@@ -64,23 +117,27 @@ void GLTFLoader::loadTextureSamplers(const tinygltf::Model &model) {
 }
 
 void GLTFLoader::loadTextures(const tinygltf::Model &model) {
+  std::vector<UniqueBytes> pixels(model.images.size());
+  parallelFor(model.images.size(), [&](size_t i) {
+    auto &image = model.images[i];
+    int w, h, channel;
+    pixels[i] = UniqueBytes(
+      stbi_load_from_memory(
+        image.image.data(), int(image.image.size()), &w, &h, &channel, STBI_rgb_alpha),
+      [](unsigned char *ptr) { stbi_image_free(ptr); });
+    errorIf(pixels[i] == nullptr, "failed to decode image", i, image.name);
+  });
+
   for(auto &tex: model.textures) {
     auto &image = model.images[tex.source];
     auto size = image.width * image.height * 4;
     auto samplerDef = tex.sampler == -1 ? SamplerDef{} : samplerDefs[tex.sampler];
-    auto dataPtr = UniqueConstBytes(image.image.data(), [](const unsigned char *ptr) {});
-    auto channel = image.component;
-    if(channel != 4) {
-      int w, h;
-      dataPtr = UniqueConstBytes(
-        stbi_load_from_memory(
-          image.image.data(), image.image.size(), &w, &h, &channel, STBI_rgb_alpha),
-        [](const unsigned char *ptr) {
-          stbi_image_free(const_cast<unsigned char *>(ptr));
-        });
-    }
-    textures.push_back(
-      mm.newTexture(dataPtr.get(), size, image.width, image.height, samplerDef, true));
+    textures.push_back(mm.newTexture(
+      pixels[tex.source].get(), size, image.width, image.height, samplerDef, true));
+    if(cache)
+      cache->texture(
+        textures.back(), pixels[tex.source].get(), image.width, image.height,
+        samplerDef);
   }
 }
 
@@ -173,9 +230,34 @@ void GLTFLoader::loadMaterials(const tinygltf::Model &model) {
     }
 
     materials.push_back(material);
+    if(cache) cache->material(material);
   }
 }
 
+void GLTFLoader::loadPrimitives(const tinygltf::Model &model) {
+  std::vector<std::pair<size_t, size_t>> jobs;
+  primitives.resize(model.meshes.size());
+  for(size_t m = 0; m < model.meshes.size(); ++m) {
+    primitives[m].resize(model.meshes[m].primitives.size());
+    for(size_t p = 0; p < model.meshes[m].primitives.size(); ++p)
+      jobs.emplace_back(m, p);
+  }
+  auto generateLODs = mm.modelConfig().generateLODs;
+  parallelFor(jobs.size(), [&](size_t i) {
+    auto [m, p] = jobs[i];
+    auto &primitive = model.meshes[m].primitives[p];
+    // unsupported modes are rejected only if a node actually uses the primitive.
+    if(primitive.mode != 4) return;
+    auto &data = primitives[m][p];
+    loadVertices(model, primitive, data);
+    loadIndices(model, primitive, data);
+    if(generateLODs && data.joints.empty())
+      data.lods = MeshSimplifier::buildLODs(
+        data.indices.data(), data.indices.size(), data.positions.data(),
+        uint32_t(data.positions.size()), Primitive::maxNumLODs - 1);
+  });
+}
+
 Ptr<Node> GLTFLoader::loadNode(int thisID, const tinygltf::Model &model) {
   auto &node = model.nodes[thisID];
   Transform t;
@@ -191,45 +273,65 @@ Ptr<Node> GLTFLoader::loadNode(int thisID, const tinygltf::Model &model) {
   }
   auto _node = mm.newNode(t, node.name);
   _nodes[thisID] = _node;
+  if(cache) cache->node(_node);
 
   if(node.mesh > -1) {
     auto &mesh = model.meshes[node.mesh];
-    for(auto &primitive: mesh.primitives)
-      Node::addMesh(_node, loadPrimitive(model, primitive));
+    for(size_t p = 0; p < mesh.primitives.size(); ++p) {
+      auto _mesh = loadPrimitive(mesh.primitives[p], primitives[node.mesh][p]);
+      Node::addMesh(_node, _mesh);
+      if(cache) cache->addMesh(_node, _mesh);
+    }
   }
   if(!node.children.empty())
-    for(auto childID: node.children)
-      Node::addChild(_node, loadNode(childID, model));
+    for(auto childID: node.children) {
+      auto child = loadNode(childID, model);
+      Node::addChild(_node, child);
+      if(cache) cache->addChild(_node, child);
+    }
   return _node;
 }
 
 Ptr<Mesh> GLTFLoader::loadPrimitive(
-  const tinygltf::Model &model, const tinygltf::Primitive &primitive) {
+  const tinygltf::Primitive &primitive, const PrimitiveData &data) {
   errorIf(primitive.mode != 4, "model primitive mode isn't triangles!");
 
-  auto aabb = loadVertices(model, primitive);
-  loadIndices(model, primitive);
-  auto _primitive = mm.newPrimitive(
-    positions.data(), positions.size(), normals.data(), normals.size(), uvs.data(),
-    uvs.size(), indices.data(), indices.size(), aabb);
+  auto _primitive =
+    data.joints.empty() ?
+      mm.newPrimitive(
+        data.positions.data(), data.positions.size(), data.normals.data(),
+        data.normals.size(), data.uvs.data(), data.uvs.size(), data.indices.data(),
+        data.indices.size(), data.aabb, PrimitiveTopology::Triangles, DynamicType::Static,
+        &data.lods) :
+      mm.newSkinnedPrimitive(
+        data.positions.data(), data.normals.data(), data.uvs.data(), data.joints.data(),
+        data.weights.data(), data.positions.size(), data.indices.data(),
+        data.indices.size(), data.aabb);
 
   auto material = primitive.material < 0 ? mm.material(0) :
                                            materials.at(primitive.material);
-  return mm.newMesh(_primitive, material);
+  auto mesh = mm.newMesh(_primitive, material);
+  if(cache)
+    cache->mesh(
+      mesh, data.positions.data(), data.normals.data(), data.uvs.data(),
+      uint32_t(data.positions.size()), data.indices.data(),
+      uint32_t(data.indices.size()), data.aabb,
+      data.joints.empty() ? nullptr : data.joints.data(),
+      data.joints.empty() ? nullptr : data.weights.data());
+  return mesh;
 }
 
-AABB GLTFLoader::loadVertices(
-  const tinygltf::Model &model, const tinygltf::Primitive &primitive) {
+void GLTFLoader::loadVertices(
+  const tinygltf::Model &model, const tinygltf::Primitive &primitive,
+  PrimitiveData &data) {
   errorIf(!contains(primitive.attributes, "POSITION"), "missing required POSITION data!");
 
-  positions.clear();
-  normals.clear();
-  uvs.clear();
+  auto &positions = data.positions;
+  auto &normals = data.normals;
+  auto &uvs = data.uvs;
 
   auto verticesID = primitive.attributes.at("POSITION");
 
-  glm::vec3 posMin{};
-  glm::vec3 posMax{};
   const float *bufferPos = nullptr;
   const float *bufferNormals = nullptr;
   const float *bufferTexCoords = nullptr;
@@ -238,19 +340,15 @@ AABB GLTFLoader::loadVertices(
   uint32_t normByteStride{-1u};
   uint32_t uv0ByteStride{-1u};
 
-  auto posAccessor = model.accessors[verticesID];
+  auto &posAccessor = model.accessors[verticesID];
 
-  positions.reserve(posAccessor.count);
-  normals.reserve(posAccessor.count);
-  uvs.reserve(posAccessor.count);
+  positions.resize(posAccessor.count);
+  normals.resize(posAccessor.count);
+  uvs.resize(posAccessor.count);
 
   auto &posView = model.bufferViews[posAccessor.bufferView];
   bufferPos = (const float *)(&(
     model.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]));
-  posMin =
-    vec3(posAccessor.minValues[0], posAccessor.minValues[1], posAccessor.minValues[2]);
-  posMax =
-    vec3(posAccessor.maxValues[0], posAccessor.maxValues[1], posAccessor.maxValues[2]);
   posByteStride = posAccessor.ByteStride(posView) ?
                     (posAccessor.ByteStride(posView) / uint32_t(sizeof(float))) :
                     tinygltf::GetTypeSizeInBytes(TINYGLTF_TYPE_VEC3);
@@ -278,22 +376,42 @@ AABB GLTFLoader::loadVertices(
 
   //vertices
   for(size_t v = 0; v < posAccessor.count; v++) {
-    positions.push_back(make_vec3(&bufferPos[v * posByteStride]));
-    normals.push_back(
-      bufferNormals ? make_vec3(&bufferNormals[v * normByteStride]) : glm::vec3{});
-    uvs.push_back(
-      bufferTexCoords ? make_vec2(&bufferTexCoords[v * uv0ByteStride]) : glm::vec2{});
+    positions[v] = make_vec3(&bufferPos[v * posByteStride]);
+    normals[v] =
+      bufferNormals ? make_vec3(&bufferNormals[v * normByteStride]) : glm::vec3{};
+    uvs[v] =
+      bufferTexCoords ? make_vec2(&bufferTexCoords[v * uv0ByteStride]) : glm::vec2{};
+  }
+
+  if(
+    contains(primitive.attributes, "JOINTS_0") &&
+    contains(primitive.attributes, "WEIGHTS_0")) {
+    loadVec4s(model, primitive.attributes.at("JOINTS_0"), data.joints);
+    loadVec4s(model, primitive.attributes.at("WEIGHTS_0"), data.weights);
+    errorIf(
+      data.joints.size() != positions.size() || data.weights.size() != positions.size(),
+      "joints or weights don't match the positions!");
   }
-  return {posMin, posMax};
+
+  if(posAccessor.minValues.size() == 3 && posAccessor.maxValues.size() == 3) {
+    data.aabb.min =
+      vec3(posAccessor.minValues[0], posAccessor.minValues[1], posAccessor.minValues[2]);
+    data.aabb.max =
+      vec3(posAccessor.maxValues[0], posAccessor.maxValues[1], posAccessor.maxValues[2]);
+  } else
+    for(auto &position: positions)
+      data.aabb.merge(position);
 }
 
 void GLTFLoader::loadIndices(
-  const tinygltf::Model &model, const tinygltf::Primitive &primitive) {
-  indices.clear();
+  const tinygltf::Model &model, const tinygltf::Primitive &primitive,
+  PrimitiveData &data) {
+  auto &indices = data.indices;
 
   if(primitive.indices < 0) {
-    for(int i = 0; i < positions.size(); ++i)
-      indices.push_back(i);
+    indices.resize(data.positions.size());
+    for(uint32_t i = 0; i < indices.size(); ++i)
+      indices[i] = i;
     return;
   }
 
@@ -304,24 +422,21 @@ void GLTFLoader::loadIndices(
   auto &buffer = model.buffers[indicesView.buffer];
   auto buf = &buffer.data[indicesAccessor.byteOffset + indicesView.byteOffset];
 
-  indices.reserve(indicesAccessor.count);
+  indices.resize(indicesAccessor.count);
   switch(indicesAccessor.componentType) {
     case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
       auto _buf = (const uint32_t *)buf;
-      for(size_t index = 0; index < indicesAccessor.count; index++)
-        indices.push_back(_buf[index]);
+      std::copy(_buf, _buf + indicesAccessor.count, indices.begin());
       break;
     }
     case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
       auto _buf = (const uint16_t *)buf;
-      for(size_t index = 0; index < indicesAccessor.count; index++)
-        indices.push_back(_buf[index]);
+      std::copy(_buf, _buf + indicesAccessor.count, indices.begin());
       break;
     }
     case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
       auto _buf = (const uint8_t *)buf;
-      for(size_t index = 0; index < indicesAccessor.count; index++)
-        indices.push_back(_buf[index]);
+      std::copy(_buf, _buf + indicesAccessor.count, indices.begin());
       break;
     }
     default:
@@ -329,6 +444,69 @@ void GLTFLoader::loadIndices(
   }
 }
 
+void GLTFLoader::loadVec4s(
+  const tinygltf::Model &model, int accessorID, std::vector<glm::vec4> &values) {
+  auto &accessor = model.accessors[accessorID];
+  auto &view = model.bufferViews[accessor.bufferView];
+  auto buf = &model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset];
+  auto stride = accessor.ByteStride(view);
+  errorIf(accessor.type != TINYGLTF_TYPE_VEC4 || stride <= 0, "vec4 accessor expected!");
+
+  values.resize(accessor.count);
+  for(size_t i = 0; i < accessor.count; ++i) {
+    auto element = buf + i * stride;
+    switch(accessor.componentType) {
+      case TINYGLTF_COMPONENT_TYPE_FLOAT:
+        values[i] = make_vec4((const float *)element);
+        break;
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+        auto c = (const uint16_t *)element;
+        values[i] = vec4(c[0], c[1], c[2], c[3]);
+        if(accessor.normalized) values[i] /= 65535.f;
+        break;
+      }
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
+        auto c = (const uint8_t *)element;
+        values[i] = vec4(c[0], c[1], c[2], c[3]);
+        if(accessor.normalized) values[i] /= 255.f;
+        break;
+      }
+      default: error("vec4 component type", accessor.componentType, "not supported!");
+    }
+  }
+}
+
+void GLTFLoader::loadSkins(const tinygltf::Model &model) {
+  std::vector<Ptr<Skin>> skins;
+  for(auto &skin: model.skins) {
+    std::vector<Ptr<Node>> joints;
+    for(auto joint: skin.joints) {
+      errorIf(!_nodes[joint], "skin joint isn't a node of the scene!");
+      joints.push_back(_nodes[joint]);
+    }
+    std::vector<glm::mat4> inverseBindMatrices(joints.size(), glm::mat4{1});
+    if(skin.inverseBindMatrices > -1) {
+      auto &accessor = model.accessors[skin.inverseBindMatrices];
+      auto &view = model.bufferViews[accessor.bufferView];
+      auto buf = (const float *)(&(
+        model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
+      errorIf(
+        accessor.count != joints.size(), "skin needs one inverse bind matrix per joint!");
+      for(size_t i = 0; i < accessor.count; ++i)
+        inverseBindMatrices[i] = make_mat4(buf + i * 16);
+    }
+    skins.push_back(mm.newSkin(std::move(joints), std::move(inverseBindMatrices)));
+    if(cache) cache->skin(skins.back());
+  }
+
+  for(size_t i = 0; i < model.nodes.size(); ++i) {
+    auto skin = model.nodes[i].skin;
+    if(skin < 0 || !_nodes[i]) continue;
+    _nodes[i]->setSkin(skins.at(skin));
+    if(cache) cache->setSkin(_nodes[i], skins.at(skin));
+  }
+}
+
 void GLTFLoader::loadAnimations(const tinygltf::Model &model) {
   using Path = Animation::AnimationChannel::PathType;
   using Interpolation = Animation::AnimationSampler::InterpolationType;
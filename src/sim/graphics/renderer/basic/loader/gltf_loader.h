@@ -1,34 +1,67 @@
 #pragma once
 #include "sim/graphics/renderer/basic/basic_scene_manager.h"
+#include "sim/util/thread_pool.h"
+#include "scene_cache.h"
 #include <tinygltf/tiny_gltf.h>
 
 namespace sim::graphics::renderer::basic {
 class GLTFLoader {
 public:
-  explicit GLTFLoader(BasicSceneManager &mm);
+  /**
+   * @param numThreads workers that decode images and convert vertex data; 1 loads
+   * everything on the calling thread, 0 uses the hardware concurrency. Resources are
+   * always created on the calling thread.
+   */
+  explicit GLTFLoader(BasicSceneManager &mm, uint32_t numThreads = 1);
 
-  Ptr<Model> load(const std::string &file);
+  /**@param cache if not null, receives everything the loader creates, in order.*/
+  Ptr<Model> load(const std::string &file, SceneCacheWriter *cache = nullptr);
 
 private:
+  /**cpu side vertex data of a primitive, ready to be uploaded.*/
+  struct PrimitiveData {
+    std::vector<Vertex::Position> positions;
+    std::vector<Vertex::Normal> normals;
+    std::vector<Vertex::UV> uvs;
+    /**empty unless the primitive is skinned.*/
+    std::vector<Vertex::Joint> joints;
+    std::vector<Vertex::Weight> weights;
+    std::vector<uint32_t> indices;
+    AABB aabb;
+    /**built with ModelConfig::generateLODs for primitives that aren't skinned.*/
+    LODChain lods;
+  };
+
+  void parallelFor(size_t count, const std::function<void(size_t)> &func);
+
   void loadTextureSamplers(const tinygltf::Model &model);
   void loadTextures(const tinygltf::Model &model);
   void loadMaterials(const tinygltf::Model &model);
+  void loadPrimitives(const tinygltf::Model &model);
   Ptr<Node> loadNode(int thisID, const tinygltf::Model &model);
   Ptr<Mesh> loadPrimitive(
-    const tinygltf::Model &model, const tinygltf::Primitive &primitive);
-  AABB loadVertices(const tinygltf::Model &model, const tinygltf::Primitive &primitive);
-  void loadIndices(const tinygltf::Model &model, const tinygltf::Primitive &primitive);
+    const tinygltf::Primitive &primitive, const PrimitiveData &data);
+  static void loadVertices(
+    const tinygltf::Model &model, const tinygltf::Primitive &primitive,
+    PrimitiveData &data);
+  static void loadIndices(
+    const tinygltf::Model &model, const tinygltf::Primitive &primitive,
+    PrimitiveData &data);
+  /**read a vec4 accessor of any component type as floats.*/
+  static void loadVec4s(
+    const tinygltf::Model &model, int accessorID, std::vector<glm::vec4> &values);
+
+  /**create the skins and hand them to the nodes that use them.*/
+  void loadSkins(const tinygltf::Model &model);
 
   void loadAnimations(const tinygltf::Model &model);
 
   BasicSceneManager &mm;
+  uPtr<ThreadPool> pool;
+  SceneCacheWriter *cache{nullptr};
 
-  std::vector<uint32_t> indices;
-  std::vector<Vertex::Position> positions;
-  std::vector<Vertex::Normal> normals;
-  std::vector<Vertex::UV> uvs;
-  std::vector<Vertex::Joint> joint0s;
-  std::vector<Vertex::Weight> weight0s;
+  /**converted primitives, indexed by [mesh][primitive].*/
+  std::vector<std::vector<PrimitiveData>> primitives;
   std::vector<Ptr<Node>> _nodes;
   std::vector<Animation> animations;
 
@@ -0,0 +1,465 @@
+#include "scene_cache.h"
+#include "sim/util/mapped_file.h"
+#include <sys/stat.h>
+#include <cstring>
+#include <algorithm>
+#include <cstdio>
+
+namespace sim::graphics::renderer::basic {
+namespace {
+constexpr uint32_t cacheMagic = 0x43535353; // "SSSC"
+constexpr uint32_t cacheVersion = 3;
+/**arrays in the file start at this alignment, so that they can be read in place.*/
+constexpr size_t cacheAlignment = 16;
+
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  /**where the list of source files the scene was cooked from starts.*/
+  uint64_t sourcesOffset;
+};
+
+enum class Tag : uint32_t {
+  Texture,
+  Material,
+  Mesh,
+  Node,
+  AddMesh,
+  AddChild,
+  Root,
+  Animation,
+  Skin,
+  SetSkin,
+  /**the source files, after the records the loader replays.*/
+  Sources,
+  End
+};
+
+struct TextureRecord {
+  uint32_t width, height;
+  SamplerDef samplerDef;
+};
+
+struct MaterialRecord {
+  MaterialType type;
+  float alphaCutoff, occlusionStrength;
+  glm::vec4 colorFactor, pbrFactor, emissiveFactor;
+  int32_t colorTex, pbrTex, normalTex, occlusionTex, emissiveTex, heightTex;
+};
+
+struct MeshRecord {
+  AABB aabb;
+  uint32_t numVertices, numIndices;
+  int32_t material;
+  uint32_t skinned;
+};
+
+struct NodeRecord {
+  Transform transform;
+  uint32_t nameLength;
+};
+
+struct AnimationRecord {
+  uint32_t nameLength, numSamplers, numChannels;
+};
+
+struct SamplerRecord {
+  Animation::AnimationSampler::InterpolationType interpolation;
+  uint32_t numKeys;
+};
+
+struct ChannelRecord {
+  Animation::AnimationChannel::PathType path;
+  uint32_t samplerIdx, node;
+};
+
+struct SourceRecord {
+  uint64_t size;
+  int64_t mtime;
+  uint32_t pathLength;
+};
+
+bool sourceStat(const std::string &file, uint64_t &size, int64_t &mtime) {
+  struct stat st {};
+  if(stat(file.c_str(), &st) != 0) return false;
+  size = uint64_t(st.st_size);
+  mtime = int64_t(st.st_mtime);
+  return true;
+}
+
+/**bounds checked cursor over the mapped file.*/
+class Reader {
+public:
+  explicit Reader(const MappedFile &file): begin{file.data()}, size{file.size()} {}
+
+  template<typename T>
+  T pod() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  template<typename T>
+  const T *array(size_t count) {
+    align();
+    return reinterpret_cast<const T *>(take(count * sizeof(T)));
+  }
+
+  std::string string(size_t length) {
+    auto ptr = reinterpret_cast<const char *>(take(length));
+    return {ptr, ptr + length};
+  }
+
+  Tag record() {
+    align();
+    return pod<Tag>();
+  }
+
+  void seek(size_t to) {
+    errorIf(to > size, "scene cache is truncated");
+    offset = to;
+  }
+
+private:
+  const std::byte *take(size_t n) {
+    errorIf(n > size - offset, "scene cache is truncated");
+    auto ptr = begin + offset;
+    offset += n;
+    return ptr;
+  }
+  void align() {
+    offset = std::min((offset + cacheAlignment - 1) & ~(cacheAlignment - 1), size);
+  }
+
+  const std::byte *begin;
+  size_t size;
+  size_t offset{0};
+};
+}
+
+bool scene_cache::valid(const std::string &cacheFile) {
+  MappedFile file{cacheFile};
+  if(!file.valid() || file.size() < sizeof(Header) + sizeof(Tag)) return false;
+
+  Header header{};
+  std::memcpy(&header, file.data(), sizeof(header));
+  Tag end{};
+  std::memcpy(&end, file.data() + file.size() - sizeof(Tag), sizeof(Tag));
+  // the end tag is written last, so a file without it was never finished.
+  if(header.magic != cacheMagic || header.version != cacheVersion || end != Tag::End)
+    return false;
+
+  Reader in{file};
+  in.seek(header.sourcesOffset);
+  auto numSources = in.pod<uint32_t>();
+  for(uint32_t i = 0; i < numSources; ++i) {
+    auto r = in.pod<SourceRecord>();
+    uint64_t size;
+    int64_t mtime;
+    if(!sourceStat(in.string(r.pathLength), size, mtime)) return false;
+    if(size != r.size || mtime != r.mtime) return false;
+  }
+  return true;
+}
+
+Ptr<Model> scene_cache::load(BasicSceneManager &mm, const std::string &cacheFile) {
+  MappedFile file{cacheFile};
+  errorIf(!file.valid(), "failed to map scene cache", cacheFile);
+  Reader in{file};
+  in.pod<Header>();
+
+  std::vector<Ptr<Texture2D>> textures;
+  std::vector<Ptr<Material>> materials;
+  std::vector<Ptr<Mesh>> meshes;
+  std::vector<Ptr<Node>> nodes, roots;
+  std::vector<Ptr<Skin>> skins;
+  std::vector<Animation> animations;
+
+  auto texture = [&](int32_t index) {
+    return index < 0 ? Ptr<Texture2D>{} : textures.at(index);
+  };
+
+  for(auto tag = in.record(); tag != Tag::Sources; tag = in.record()) {
+    switch(tag) {
+      case Tag::Texture: {
+        auto r = in.pod<TextureRecord>();
+        size_t size = size_t(r.width) * r.height * 4;
+        auto pixels = in.array<unsigned char>(size);
+        textures.push_back(
+          mm.newTexture(pixels, size, r.width, r.height, r.samplerDef, true));
+        break;
+      }
+      case Tag::Material: {
+        auto r = in.pod<MaterialRecord>();
+        auto material = mm.newMaterial(r.type);
+        material->setAlphaCutoff(r.alphaCutoff)
+          .setOcclusionStrength(r.occlusionStrength)
+          .setColorFactor(r.colorFactor)
+          .setPbrFactor(r.pbrFactor)
+          .setEmissiveFactor(r.emissiveFactor);
+        if(r.colorTex >= 0) material->setColorTex(texture(r.colorTex));
+        if(r.pbrTex >= 0) material->setPbrTex(texture(r.pbrTex));
+        if(r.normalTex >= 0) material->setNormalTex(texture(r.normalTex));
+        if(r.occlusionTex >= 0) material->setOcclusionTex(texture(r.occlusionTex));
+        if(r.emissiveTex >= 0) material->setEmissiveTex(texture(r.emissiveTex));
+        if(r.heightTex >= 0) material->setHeightTex(texture(r.heightTex));
+        materials.push_back(material);
+        break;
+      }
+      case Tag::Mesh: {
+        auto r = in.pod<MeshRecord>();
+        auto positions = in.array<Vertex::Position>(r.numVertices);
+        auto normals = in.array<Vertex::Normal>(r.numVertices);
+        auto uvs = in.array<Vertex::UV>(r.numVertices);
+        const Vertex::Joint *joints = nullptr;
+        const Vertex::Weight *weights = nullptr;
+        if(r.skinned) {
+          joints = in.array<Vertex::Joint>(r.numVertices);
+          weights = in.array<Vertex::Weight>(r.numVertices);
+        }
+        auto indices = in.array<uint32_t>(r.numIndices);
+        auto primitive =
+          r.skinned ? mm.newSkinnedPrimitive(
+                        positions, normals, uvs, joints, weights, r.numVertices, indices,
+                        r.numIndices, r.aabb) :
+                      mm.newPrimitive(
+                        positions, r.numVertices, normals, r.numVertices, uvs,
+                        r.numVertices, indices, r.numIndices, r.aabb);
+        auto material = r.material < 0 ? mm.material(0) : materials.at(r.material);
+        meshes.push_back(mm.newMesh(primitive, material));
+        break;
+      }
+      case Tag::Node: {
+        auto r = in.pod<NodeRecord>();
+        nodes.push_back(mm.newNode(r.transform, in.string(r.nameLength)));
+        break;
+      }
+      case Tag::AddMesh: {
+        auto node = in.pod<uint32_t>();
+        auto mesh = in.pod<uint32_t>();
+        Node::addMesh(nodes.at(node), meshes.at(mesh));
+        break;
+      }
+      case Tag::AddChild: {
+        auto parent = in.pod<uint32_t>();
+        auto child = in.pod<uint32_t>();
+        Node::addChild(nodes.at(parent), nodes.at(child));
+        break;
+      }
+      case Tag::Root: roots.push_back(nodes.at(in.pod<uint32_t>())); break;
+      case Tag::Skin: {
+        auto numJoints = in.pod<uint32_t>();
+        auto jointIndices = in.array<uint32_t>(numJoints);
+        auto ibms = in.array<glm::mat4>(numJoints);
+        std::vector<Ptr<Node>> joints;
+        for(uint32_t i = 0; i < numJoints; ++i)
+          joints.push_back(nodes.at(jointIndices[i]));
+        skins.push_back(
+          mm.newSkin(std::move(joints), std::vector<glm::mat4>(ibms, ibms + numJoints)));
+        break;
+      }
+      case Tag::SetSkin: {
+        auto node = in.pod<uint32_t>();
+        auto skin = in.pod<uint32_t>();
+        nodes.at(node)->setSkin(skins.at(skin));
+        break;
+      }
+      case Tag::Animation: {
+        auto r = in.pod<AnimationRecord>();
+        Animation animation{};
+        animation.name = in.string(r.nameLength);
+        animation.samplers.resize(r.numSamplers);
+        for(auto &sampler: animation.samplers) {
+          auto s = in.pod<SamplerRecord>();
+          sampler.interpolation = s.interpolation;
+          auto keyTimings = in.array<float>(s.numKeys);
+          sampler.keyTimings.assign(keyTimings, keyTimings + s.numKeys);
+          auto numFrames = in.pod<uint32_t>();
+          auto keyFrames = in.array<glm::vec4>(numFrames);
+          sampler.keyFrames.assign(keyFrames, keyFrames + numFrames);
+        }
+        animation.channels.resize(r.numChannels);
+        for(auto &channel: animation.channels) {
+          auto c = in.pod<ChannelRecord>();
+          channel.path = c.path;
+          channel.samplerIdx = c.samplerIdx;
+          channel.node = nodes.at(c.node);
+        }
+        animations.push_back(std::move(animation));
+        break;
+      }
+      default: error("unknown scene cache record", uint32_t(tag));
+    }
+  }
+  debugLog("loaded scene cache", cacheFile, file.size(), "bytes");
+  return mm.newModel(std::move(roots), std::move(animations));
+}
+
+SceneCacheWriter::SceneCacheWriter(
+  const std::string &cacheFile, const std::string &sourceFile)
+  : cacheFile{cacheFile}, tmpFile{cacheFile + ".tmp"}, sources{sourceFile} {
+  out.open(tmpFile, std::ios::binary | std::ios::trunc);
+  pod(Header{cacheMagic, cacheVersion, 0});
+}
+
+void SceneCacheWriter::source(const std::string &file) {
+  if(std::find(sources.begin(), sources.end(), file) == sources.end())
+    sources.push_back(file);
+}
+
+SceneCacheWriter::~SceneCacheWriter() {
+  if(finished) return;
+  out.close();
+  std::remove(tmpFile.c_str());
+}
+
+void SceneCacheWriter::align() {
+  static const char zeros[cacheAlignment]{};
+  auto pos = size_t(out.tellp());
+  auto padding = (cacheAlignment - pos % cacheAlignment) % cacheAlignment;
+  out.write(zeros, padding);
+}
+
+void SceneCacheWriter::record(uint32_t tag) {
+  align();
+  pod(tag);
+}
+
+void SceneCacheWriter::array(const void *data, size_t sizeInBytes) {
+  align();
+  out.write(static_cast<const char *>(data), sizeInBytes);
+}
+
+int32_t SceneCacheWriter::indexOf(
+  const std::unordered_map<uint32_t, uint32_t> &indices, uint32_t key) {
+  auto it = indices.find(key);
+  return it == indices.end() ? -1 : int32_t(it->second);
+}
+
+void SceneCacheWriter::texture(
+  const Ptr<Texture2D> &texture, const unsigned char *pixels, uint32_t width,
+  uint32_t height, const SamplerDef &samplerDef) {
+  textures[texture.index()] = uint32_t(textures.size());
+  record(uint32_t(Tag::Texture));
+  pod(TextureRecord{width, height, samplerDef});
+  array(pixels, size_t(width) * height * 4);
+}
+
+void SceneCacheWriter::material(Ptr<Material> material) {
+  materials[material.index()] = uint32_t(materials.size());
+  auto tex = [&](const Ptr<Texture2D> &texture) {
+    return texture.isNull() ? -1 : indexOf(textures, texture.index());
+  };
+  record(uint32_t(Tag::Material));
+  pod(MaterialRecord{
+    material->type(), material->alphaCutoff(), material->occlusionStrength(),
+    material->colorFactor(), material->pbrFactor(), material->emissiveFactor(),
+    tex(material->colorTex()), tex(material->pbrTex()), tex(material->normalTex()),
+    tex(material->occlusionTex()), tex(material->emissiveTex()),
+    tex(material->heightTex())});
+}
+
+void SceneCacheWriter::mesh(
+  const Ptr<Mesh> &mesh, const Vertex::Position *positions,
+  const Vertex::Normal *normals, const Vertex::UV *uvs, uint32_t numVertices,
+  const uint32_t *indices, uint32_t numIndices, const AABB &aabb,
+  const Vertex::Joint *joints, const Vertex::Weight *weights) {
+  meshes[mesh.index()] = uint32_t(meshes.size());
+  bool skinned = joints && weights;
+  record(uint32_t(Tag::Mesh));
+  pod(MeshRecord{aabb, numVertices, numIndices,
+                 indexOf(materials, mesh.get().material().index()), skinned ? 1u : 0u});
+  array(positions, numVertices * sizeof(Vertex::Position));
+  array(normals, numVertices * sizeof(Vertex::Normal));
+  array(uvs, numVertices * sizeof(Vertex::UV));
+  if(skinned) {
+    array(joints, numVertices * sizeof(Vertex::Joint));
+    array(weights, numVertices * sizeof(Vertex::Weight));
+  }
+  array(indices, numIndices * sizeof(uint32_t));
+}
+
+void SceneCacheWriter::node(Ptr<Node> node) {
+  nodes[node.index()] = uint32_t(nodes.size());
+  auto &name = node->name();
+  record(uint32_t(Tag::Node));
+  pod(NodeRecord{node->transform(), uint32_t(name.size())});
+  out.write(name.data(), name.size());
+}
+
+void SceneCacheWriter::addMesh(const Ptr<Node> &node, const Ptr<Mesh> &mesh) {
+  record(uint32_t(Tag::AddMesh));
+  pod(nodes.at(node.index()));
+  pod(meshes.at(mesh.index()));
+}
+
+void SceneCacheWriter::addChild(const Ptr<Node> &parent, const Ptr<Node> &child) {
+  record(uint32_t(Tag::AddChild));
+  pod(nodes.at(parent.index()));
+  pod(nodes.at(child.index()));
+}
+
+void SceneCacheWriter::root(const Ptr<Node> &node) {
+  record(uint32_t(Tag::Root));
+  pod(nodes.at(node.index()));
+}
+
+void SceneCacheWriter::skin(const Ptr<Skin> &skin) {
+  skins[skin.index()] = uint32_t(skins.size());
+  auto &joints = skin.get().joints();
+  std::vector<uint32_t> jointIndices;
+  for(auto &joint: joints)
+    jointIndices.push_back(nodes.at(joint.index()));
+  record(uint32_t(Tag::Skin));
+  pod(uint32_t(joints.size()));
+  array(jointIndices.data(), jointIndices.size() * sizeof(uint32_t));
+  array(skin.get().inverseBindMatrices().data(), joints.size() * sizeof(glm::mat4));
+}
+
+void SceneCacheWriter::setSkin(const Ptr<Node> &node, const Ptr<Skin> &skin) {
+  record(uint32_t(Tag::SetSkin));
+  pod(nodes.at(node.index()));
+  pod(skins.at(skin.index()));
+}
+
+void SceneCacheWriter::animation(const Animation &animation) {
+  record(uint32_t(Tag::Animation));
+  pod(AnimationRecord{
+    uint32_t(animation.name.size()), uint32_t(animation.samplers.size()),
+    uint32_t(animation.channels.size())});
+  out.write(animation.name.data(), animation.name.size());
+  for(auto &sampler: animation.samplers) {
+    pod(SamplerRecord{sampler.interpolation, uint32_t(sampler.keyTimings.size())});
+    array(sampler.keyTimings.data(), sampler.keyTimings.size() * sizeof(float));
+    pod(uint32_t(sampler.keyFrames.size()));
+    array(sampler.keyFrames.data(), sampler.keyFrames.size() * sizeof(glm::vec4));
+  }
+  for(auto &channel: animation.channels)
+    pod(ChannelRecord{channel.path, channel.samplerIdx, nodes.at(channel.node.index())});
+}
+
+void SceneCacheWriter::finish() {
+  record(uint32_t(Tag::Sources));
+  auto sourcesOffset = uint64_t(out.tellp());
+  pod(uint32_t(sources.size()));
+  for(auto &file: sources) {
+    SourceRecord r{0, 0, uint32_t(file.size())};
+    if(!sourceStat(file, r.size, r.mtime)) {
+      debugLog("failed to stat scene source", file);
+      return;
+    }
+    pod(r);
+    out.write(file.data(), file.size());
+  }
+  record(uint32_t(Tag::End));
+  out.seekp(0);
+  pod(Header{cacheMagic, cacheVersion, sourcesOffset});
+  out.close();
+  if(!out) {
+    debugLog("failed to write scene cache", cacheFile);
+    return;
+  }
+  std::remove(cacheFile.c_str());
+  finished = std::rename(tmpFile.c_str(), cacheFile.c_str()) == 0;
+}
+}
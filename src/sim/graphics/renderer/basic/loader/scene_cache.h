@@ -0,0 +1,69 @@
+#pragma once
+#include "sim/graphics/renderer/basic/basic_scene_manager.h"
+#include <fstream>
+#include <unordered_map>
+
+namespace sim::graphics::renderer::basic {
+/**
+ * Cooked binary form of a loaded scene. The file is a stream of records that replays,
+ * in order, the texture/material/primitive/node calls the glTF loader made, with the
+ * vertex, index and pixel arrays stored in the exact element layout of the device
+ * buffers. Loading maps the file and hands those arrays straight to the staging ring.
+ */
+namespace scene_cache {
+/**@return true if cacheFile was cooked from its source files as they are now.*/
+bool valid(const std::string &cacheFile);
+
+/**replay the cached scene into mm. The file must have passed valid().*/
+Ptr<Model> load(BasicSceneManager &mm, const std::string &cacheFile);
+}
+
+class SceneCacheWriter {
+public:
+  SceneCacheWriter(const std::string &cacheFile, const std::string &sourceFile);
+  ~SceneCacheWriter();
+  SceneCacheWriter(const SceneCacheWriter &) = delete;
+  SceneCacheWriter &operator=(const SceneCacheWriter &) = delete;
+
+  void texture(
+    const Ptr<Texture2D> &texture, const unsigned char *pixels, uint32_t width,
+    uint32_t height, const SamplerDef &samplerDef);
+  void material(Ptr<Material> material);
+  /**@param joints, weights null unless the mesh is skinned.*/
+  void mesh(
+    const Ptr<Mesh> &mesh, const Vertex::Position *positions,
+    const Vertex::Normal *normals, const Vertex::UV *uvs, uint32_t numVertices,
+    const uint32_t *indices, uint32_t numIndices, const AABB &aabb,
+    const Vertex::Joint *joints = nullptr, const Vertex::Weight *weights = nullptr);
+  void node(Ptr<Node> node);
+  void skin(const Ptr<Skin> &skin);
+  void setSkin(const Ptr<Node> &node, const Ptr<Skin> &skin);
+  void addMesh(const Ptr<Node> &node, const Ptr<Mesh> &mesh);
+  void addChild(const Ptr<Node> &parent, const Ptr<Node> &child);
+  void root(const Ptr<Node> &node);
+  void animation(const Animation &animation);
+  /**key the cache on file too, besides the model file; for buffers and images.*/
+  void source(const std::string &file);
+
+  /**close the file and move it into place; an unfinished cache is discarded.*/
+  void finish();
+
+private:
+  template<typename T>
+  void pod(const T &value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+  void array(const void *data, size_t sizeInBytes);
+  void record(uint32_t tag);
+  void align();
+  static int32_t indexOf(
+    const std::unordered_map<uint32_t, uint32_t> &indices, uint32_t key);
+
+  std::string cacheFile, tmpFile;
+  std::vector<std::string> sources;
+  std::ofstream out;
+  bool finished{false};
+
+  std::unordered_map<uint32_t, uint32_t> textures, materials, meshes, nodes, skins;
+};
+}
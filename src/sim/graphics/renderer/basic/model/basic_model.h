@@ -6,5 +6,6 @@
 #include "transform.h"
 #include "mesh.h"
 #include "node.h"
+#include "skin.h"
 #include "model.h"
 #include "model_instance.h"
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "draw_queue.h"
+#include <algorithm>
 namespace sim::graphics::renderer::basic {
 
 DrawQueue::DrawQueue(
@@ -7,36 +8,160 @@ DrawQueue::DrawQueue(
   uint32_t maxNumTerrainMeshes, uint32_t maxNumFrames, uint32_t maxNumDynamicMeshes,
   uint32_t maxNumDynamicLineMeshes, uint32_t maxNumDynamicTransparentMeshes,
   uint32_t maxNumDynamicTransparentLineMeshes, uint32_t maxNumDynamicTerrainMeshes)
-  : numFrame{maxNumFrames} {
-  staticDrawQueues = {u<HostIndirectUBOBuffer>(allocator, maxNumMeshes),
-                      u<HostIndirectUBOBuffer>(allocator, maxNumLineMeshes),
-                      u<HostIndirectUBOBuffer>(allocator, maxNumTransparentMeshes),
-                      u<HostIndirectUBOBuffer>(allocator, maxNumTransparentLineMeshes),
-                      u<HostIndirectUBOBuffer>(allocator, maxNumTerrainMeshes)};
+  : numFrame{maxNumFrames},
+    // room for batches to double their ranges as they grow.
+    _idRegionSize{
+      2 * (maxNumMeshes + maxNumLineMeshes + maxNumTransparentMeshes +
+           maxNumTransparentLineMeshes + maxNumTerrainMeshes + maxNumDynamicMeshes +
+           maxNumDynamicLineMeshes + maxNumDynamicTransparentMeshes +
+           maxNumDynamicTransparentLineMeshes + maxNumDynamicTerrainMeshes)},
+    idRanges{_idRegionSize},
+    ids(_idRegionSize),
+    idLog{maxNumFrames} {
+  idBuffer = u<HostStorageBuffer>(
+    allocator, vk::DeviceSize(2 * numFrame) * _idRegionSize * sizeof(uint32_t));
+  // static commands are read by every frame, so they get a slice per frame; each frame
+  // reads only its own dynamic queues.
+  staticDrawQueues = {
+    u<HostIndirectUBOBuffer>(allocator, maxNumMeshes, numFrame),
+    u<HostIndirectUBOBuffer>(allocator, maxNumLineMeshes, numFrame),
+    u<HostIndirectUBOBuffer>(allocator, maxNumTransparentMeshes, numFrame),
+    u<HostIndirectUBOBuffer>(allocator, maxNumTransparentLineMeshes, numFrame),
+    u<HostIndirectUBOBuffer>(allocator, maxNumTerrainMeshes, numFrame)};
   dynamicDrawQueues.reserve(numFrame);
   for(int i = 0; i < numFrame; ++i) {
     dynamicDrawQueues.push_back(
-      {u<HostIndirectUBOBuffer>(allocator, maxNumDynamicMeshes),
-       u<HostIndirectUBOBuffer>(allocator, maxNumDynamicLineMeshes),
-       u<HostIndirectUBOBuffer>(allocator, maxNumDynamicTransparentMeshes),
-       u<HostIndirectUBOBuffer>(allocator, maxNumDynamicTransparentLineMeshes),
-       u<HostIndirectUBOBuffer>(allocator, maxNumDynamicTerrainMeshes)});
+      {u<HostIndirectUBOBuffer>(allocator, maxNumDynamicMeshes, 1),
+       u<HostIndirectUBOBuffer>(allocator, maxNumDynamicLineMeshes, 1),
+       u<HostIndirectUBOBuffer>(allocator, maxNumDynamicTransparentMeshes, 1),
+       u<HostIndirectUBOBuffer>(allocator, maxNumDynamicTransparentLineMeshes, 1),
+       u<HostIndirectUBOBuffer>(allocator, maxNumDynamicTerrainMeshes, 1)});
   }
 }
 
-auto DrawQueue::allocate(const Ptr<Primitive> &primitive, const Ptr<Material> &material)
-  -> std::vector<Allocation<vk::DrawIndexedIndirectCommand>> {
+uint32_t DrawQueue::add(
+  const Ptr<Primitive> &primitive, const Ptr<Material> &material,
+  const DynamicType &type, uint32_t meshInstance, bool visible) {
   auto idx = index(primitive, material);
-  std::vector<Allocation<vk::DrawIndexedIndirectCommand>> results;
-  switch(primitive.get().type()) {
-    case DynamicType::Static: results.push_back(staticDrawQueues[idx]->allocate()); break;
+  auto key = -1ull;
+  if(type == DynamicType::Static) {
+    key = uint64_t(primitive.index()) << 32u | uint64_t(material.index()) << 3u | idx;
+    auto it = sharedBatches.find(key);
+    if(it != sharedBatches.end()) {
+      auto &batch = batches[it->second];
+      batch.numMembers++;
+      if(visible) show(batch, meshInstance);
+      return it->second;
+    }
+  }
+
+  uint32_t b;
+  if(!freeBatches.empty()) {
+    b = freeBatches.back();
+    freeBatches.pop_back();
+  } else {
+    b = uint32_t(batches.size());
+    batches.emplace_back();
+  }
+  auto &batch = batches[b];
+  batch = {};
+  batch.key = key;
+  switch(type) {
+    case DynamicType::Static: {
+      auto &queue = *staticDrawQueues[idx];
+      batch.cmds.push_back({&queue, queue.allocate()});
+    } break;
     case DynamicType::Dynamic:
-      results.reserve(numFrame);
-      for(int i = 0; i < numFrame; ++i)
-        results.push_back(dynamicDrawQueues[i][idx]->allocate());
+      batch.cmds.reserve(numFrame);
+      for(int i = 0; i < numFrame; ++i) {
+        auto &queue = *dynamicDrawQueues[i][idx];
+        batch.cmds.push_back({&queue, queue.allocate()});
+      }
       break;
   }
-  return std::move(results);
+  for(auto &cmd: batch.cmds)
+    cmd.write() = {};
+  if(key != -1ull) sharedBatches[key] = b;
+  batch.numMembers = 1;
+  if(visible) show(batch, meshInstance);
+  return b;
+}
+
+void DrawQueue::remove(uint32_t b, uint32_t meshInstance) {
+  auto &batch = batches[b];
+  if(idPositions.count(meshInstance)) hide(batch, meshInstance);
+  if(--batch.numMembers > 0) return;
+
+  for(auto &cmd: batch.cmds)
+    cmd.queue->deallocate(cmd.handle);
+  idRanges.free(batch.ids);
+  if(batch.key != -1ull) sharedBatches.erase(batch.key);
+  batch = {};
+  freeBatches.push_back(b);
+}
+
+void DrawQueue::setVisible(uint32_t b, uint32_t meshInstance, bool visible) {
+  auto &batch = batches[b];
+  auto shown = idPositions.count(meshInstance) > 0;
+  if(visible && !shown) show(batch, meshInstance);
+  if(!visible && shown) hide(batch, meshInstance);
+}
+
+const std::vector<DrawCMDHandle> &DrawQueue::drawCMDs(uint32_t batch) const {
+  return batches[batch].cmds;
+}
+
+void DrawQueue::show(Batch &batch, uint32_t meshInstance) {
+  auto ptr = ids.data();
+  if(batch.count == batch.ids.size) {
+    // frames in flight read their own slices, so the old range is free at once.
+    Range grown;
+    errorIf(
+      !idRanges.allocate(std::max(2 * batch.ids.size, 1u), grown),
+      "exceeding max number of instance IDs");
+    std::copy(ptr + batch.ids.offset, ptr + batch.ids.endOffset(), ptr + grown.offset);
+    idLog.add(grown.offset, batch.count);
+    idRanges.free(batch.ids);
+    batch.ids = grown;
+  }
+  ptr[batch.ids.offset + batch.count] = meshInstance;
+  idLog.add(batch.ids.offset + batch.count, 1);
+  idPositions[meshInstance] = batch.count++;
+  updateCMDs(batch);
+}
+
+void DrawQueue::hide(Batch &batch, uint32_t meshInstance) {
+  auto ptr = ids.data() + batch.ids.offset;
+  auto it = idPositions.find(meshInstance);
+  auto position = it->second;
+  idPositions.erase(it);
+  auto last = --batch.count;
+  if(position != last) {
+    ptr[position] = ptr[last];
+    idLog.add(batch.ids.offset + position, 1);
+    idPositions[ptr[position]] = position;
+  }
+  updateCMDs(batch);
+}
+
+void DrawQueue::updateCMDs(Batch &batch) {
+  for(auto &handle: batch.cmds) {
+    auto &cmd = handle.write();
+    cmd.instanceCount = batch.count;
+    cmd.firstInstance = batch.ids.offset;
+  }
+}
+
+void DrawQueue::flush(uint32_t frame) {
+  auto slice = idBuffer->ptr<uint32_t>() + idSliceOffset(frame);
+  for(auto &range: idLog.catchUp(frame))
+    std::copy(
+      ids.begin() + range.offset, ids.begin() + range.endOffset(), slice + range.offset);
+  // the commands address the IDs of the frame's slice.
+  for(auto &queue: staticDrawQueues)
+    queue->flush(frame, idSliceOffset(frame));
+  for(auto &queue: dynamicDrawQueues[frame])
+    queue->flush(0, idSliceOffset(frame));
 }
 
 uint32_t DrawQueue::index(Ptr<Primitive> primitive, Ptr<Material> material) {
@@ -60,6 +185,7 @@ uint32_t DrawQueue::index(Ptr<Primitive> primitive, Ptr<Material> material) {
 }
 
 void DrawQueue::mark(DebugMarker &debugMarker) {
+  debugMarker.name(idBuffer->buffer(), "instance IDs buffer");
   debugMarker.name(staticDrawQueues[0]->buffer(), "drawOpaqueCMDs buffer");
   debugMarker.name(staticDrawQueues[1]->buffer(), "drawLineCMDs buffer");
   debugMarker.name(staticDrawQueues[2]->buffer(), "drawTransparentCMDs buffer");
@@ -86,9 +212,15 @@ void DrawQueue::mark(DebugMarker &debugMarker) {
 vk::Buffer DrawQueue::buffer(DrawType drawType) {
   return staticDrawQueues[static_cast<uint32_t>(drawType)]->buffer();
 }
+vk::DeviceSize DrawQueue::offset(DrawType drawType, uint32_t frame) {
+  return staticDrawQueues[static_cast<uint32_t>(drawType)]->offset(frame);
+}
 uint32_t DrawQueue::count(DrawType drawType) {
   return staticDrawQueues[static_cast<uint32_t>(drawType)]->count();
 }
+uint32_t DrawQueue::capacity(DrawType drawType) {
+  return staticDrawQueues[static_cast<uint32_t>(drawType)]->maxNum;
+}
 
 vk::Buffer DrawQueue::buffer(DrawType drawType, uint32_t frame) {
   return dynamicDrawQueues[frame][static_cast<uint32_t>(drawType)]->buffer();
@@ -96,4 +228,13 @@ vk::Buffer DrawQueue::buffer(DrawType drawType, uint32_t frame) {
 uint32_t DrawQueue::count(DrawType drawType, uint32_t frame) {
   return dynamicDrawQueues[frame][static_cast<uint32_t>(drawType)]->count();
 }
+
+vk::Buffer DrawQueue::instanceIDs() { return idBuffer->buffer(); }
+uint32_t DrawQueue::idSliceOffset(uint32_t frame) const {
+  return 2 * frame * _idRegionSize;
+}
+uint32_t DrawQueue::culledIDOffset(uint32_t frame) const {
+  return idSliceOffset(frame) + _idRegionSize;
+}
+uint32_t DrawQueue::idRegionSize() const { return _idRegionSize; }
 }
\ No newline at end of file
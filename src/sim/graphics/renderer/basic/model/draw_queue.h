@@ -1,8 +1,24 @@
 #pragma once
+#include <unordered_map>
 #include "basic_model.h"
 #include "sim/graphics/base/debug_marker.h"
 
 namespace sim::graphics::renderer::basic {
+/**
+ * Indirect draw commands of the mesh instances, by draw type. Static mesh instances of
+ * the same primitive and material share one command that draws all of them as
+ * instances; every command reads its mesh instances from a contiguous range of the
+ * instance ID buffer, starting at firstInstance, so the vertex shader finds its mesh
+ * instance at instanceIDs[gl_InstanceIndex]. Hidden mesh instances are left out of the
+ * range. Dynamic mesh instances draw their own vertices and get a command each.
+ *
+ * Commands are edited on the host; frames draw from their own copies, which flush
+ * updates once the frame's previous submission has completed.
+ *
+ * The instance ID buffer holds, for each frame, a copy of the IDs written here followed
+ * by the region that culling compacts the visible IDs into, so a culled ID sits
+ * idRegionSize past its own.
+ */
 class DrawQueue {
 public:
   enum class DrawType : uint32_t {
@@ -20,25 +36,79 @@ public:
     uint32_t maxNumDynamicLineMeshes, uint32_t maxNumDynamicTransparentMeshes,
     uint32_t maxNumDynamicTransparentLineMeshes, uint32_t maxNumDynamicTerrainMeshes);
 
-  auto allocate(const Ptr<Primitive> &primitive, const Ptr<Material> &material)
-    -> std::vector<Allocation<vk::DrawIndexedIndirectCommand>>;
+  /**
+   * add the mesh instance whose UBO is at meshInstance to the command drawing primitive
+   * with material from the queues of type.
+   * @return the batch of the mesh instance.
+   */
+  uint32_t add(
+    const Ptr<Primitive> &primitive, const Ptr<Material> &material,
+    const DynamicType &type, uint32_t meshInstance, bool visible);
+  /**remove the mesh instance from batch, and the batch's commands once it is empty.*/
+  void remove(uint32_t batch, uint32_t meshInstance);
+  void setVisible(uint32_t batch, uint32_t meshInstance, bool visible);
+  /**the commands of batch, one for static ones and one per frame for dynamic ones.*/
+  const std::vector<DrawCMDHandle> &drawCMDs(uint32_t batch) const;
+
+  /**copy the command edits into frame's static slices and dynamic queues.*/
+  void flush(uint32_t frame);
 
   vk::Buffer buffer(DrawType drawType);
+  /**byte offset of frame's slice of the static commands of drawType.*/
+  vk::DeviceSize offset(DrawType drawType, uint32_t frame);
   uint32_t count(DrawType drawType);
+  /**max number of static commands of drawType.*/
+  uint32_t capacity(DrawType drawType);
 
   vk::Buffer buffer(DrawType drawType, uint32_t frame);
   uint32_t count(DrawType drawType, uint32_t frame);
 
+  vk::Buffer instanceIDs();
+  /**offset of the instance IDs of frame in the instance ID buffer.*/
+  uint32_t idSliceOffset(uint32_t frame) const;
+  /**offset of the culled instance IDs of frame in the instance ID buffer.*/
+  uint32_t culledIDOffset(uint32_t frame) const;
+  /**number of instance IDs in each region of the instance ID buffer.*/
+  uint32_t idRegionSize() const;
+
   void mark(DebugMarker &debugMarker);
 
 private:
   static uint32_t index(Ptr<Primitive> primitive, Ptr<Material> material);
 
+  struct Batch {
+    std::vector<DrawCMDHandle> cmds;
+    /**visible mesh instances are the first count IDs of the range.*/
+    Range ids;
+    uint32_t count{0};
+    uint32_t numMembers{0};
+    /**key in sharedBatches, or -1 for an unshared batch.*/
+    uint64_t key{-1ull};
+  };
+  /**write the instance range of batch to its commands.*/
+  void updateCMDs(Batch &batch);
+  void show(Batch &batch, uint32_t meshInstance);
+  void hide(Batch &batch, uint32_t meshInstance);
+
 private:
   using DrawQueues =
     std::array<uPtr<HostIndirectUBOBuffer>, static_cast<uint32_t>(DrawType::MAX)>;
   DrawQueues staticDrawQueues;
   std::vector<DrawQueues> dynamicDrawQueues;
   uint32_t numFrame;
+
+  std::vector<Batch> batches;
+  std::vector<uint32_t> freeBatches;
+  /**batch of each static draw type, primitive and material.*/
+  std::unordered_map<uint64_t, uint32_t> sharedBatches;
+  /**position of each visible mesh instance in its batch's range.*/
+  std::unordered_map<uint32_t, uint32_t> idPositions;
+
+  uPtr<HostStorageBuffer> idBuffer;
+  uint32_t _idRegionSize;
+  RangeAllocator idRanges;
+  /**host copy of the instance IDs, and the edits each frame's slice has yet to get.*/
+  std::vector<uint32_t> ids;
+  WriteLog idLog;
 };
-}
\ No newline at end of file
+}
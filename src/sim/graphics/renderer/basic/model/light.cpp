@@ -12,37 +12,43 @@ Light::Light(
     _color{color},
     _location{location},
     ubo{mm.allocateLightUBO()} {
-  *ubo.ptr = {_color,    _intensity,           _direction,           _range,
-              _location, _spot.innerConeAngle, _spot.outerConeAngle, uint32_t(_type)};
+  ubo.write() = {_color,
+                 _intensity,
+                 _direction,
+                 _range,
+                 _location,
+                 _spot.innerConeAngle,
+                 _spot.outerConeAngle,
+                 uint32_t(_type)};
 }
 LightType Light::type() const { return _type; }
 void Light::setType(LightType type) {
   _type = type;
-  ubo.ptr->type = static_cast<uint32_t>(type);
+  ubo.write().type = static_cast<uint32_t>(type);
 }
 const glm::vec3 &Light::color() const { return _color; }
 void Light::setColor(const glm::vec3 &color) {
   _color = color;
-  ubo.ptr->color = color;
+  ubo.write().color = color;
 }
 const glm::vec3 &Light::direction() const { return _direction; }
 void Light::setDirection(const glm::vec3 &direction) {
   _direction = direction;
-  ubo.ptr->direction = direction;
+  ubo.write().direction = direction;
 }
 const glm::vec3 &Light::location() const { return _location; }
 void Light::setLocation(const glm::vec3 &location) {
   _location = location;
-  ubo.ptr->location = location;
+  ubo.write().location = location;
 }
 float Light::intensity() const { return _intensity; }
 void Light::setIntensity(float intensity) {
   _intensity = intensity;
-  ubo.ptr->intensity = intensity;
+  ubo.write().intensity = intensity;
 }
 float Light::range() const { return _range; }
 void Light::setRange(float range) {
   _range = range;
-  ubo.ptr->range = range;
+  ubo.write().range = range;
 }
 }
\ No newline at end of file
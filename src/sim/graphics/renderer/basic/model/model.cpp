@@ -1,4 +1,5 @@
 #include "model.h"
+#include <algorithm>
 
 namespace sim::graphics::renderer::basic {
 using Path = Animation::AnimationChannel::PathType;
@@ -15,44 +16,52 @@ void Animation::resetAll() {
 }
 
 void Animation::animate(uint32_t index, float elapsed) {
+  apply(index, sample(index, elapsed));
+}
+
+glm::vec4 Animation::sample(uint32_t index, float elapsed) {
+  auto &channel = channels[index];
+  return sample(index, elapsed, channel.prevTime, channel.prevKey);
+}
+
+glm::vec4 Animation::sample(
+  uint32_t index, float elapsed, float &time, uint32_t &key) const {
   auto &channel = channels[index];
   auto &sampler = samplers[channel.samplerIdx];
 
-  auto transform = channel.node->transform();
   glm::vec4 result{};
   if(sampler.keyTimings.size() == 1) result = sampler.keyFrames[0];
   else {
-    auto t = channel.prevTime;
+    auto t = time;
     t += elapsed;
     t = std::max(std::fmod(t, sampler.keyTimings.back()), sampler.keyTimings.front());
-    if(channel.prevTime > t) channel.prevKey = 0;
-    channel.prevTime = t;
-    auto nextKey = 0;
-    for(int i = 0; i < sampler.keyTimings.size(); ++i)
-      if(t <= sampler.keyTimings[i]) {
-        nextKey = std::clamp(i, 1, int(sampler.keyTimings.size() - 1));
-        break;
-      }
-    channel.prevKey = std::clamp(nextKey - 1, 0, nextKey);
-    auto keyDelta = sampler.keyTimings[nextKey] - sampler.keyTimings[channel.prevKey];
-    auto tn = (t - sampler.keyTimings[channel.prevKey]) / keyDelta;
+    if(time > t) key = 0;
+    time = t;
+    auto nextKey = sampler.nextKey(t, key);
+    key = nextKey - 1;
+    auto keyDelta = sampler.keyTimings[nextKey] - sampler.keyTimings[key];
+    auto tn = (t - sampler.keyTimings[key]) / keyDelta;
     if(channel.path == Path::Rotation) {
       if(sampler.interpolation == Interpolation::CubicSpline)
-        result = sampler.cubicSpline(channel.prevKey, nextKey, keyDelta, tn);
+        result = sampler.cubicSpline(key, nextKey, keyDelta, tn);
       else
-        result = sampler.interpolateRotation(channel.prevKey, nextKey, tn);
+        result = sampler.interpolateRotation(key, nextKey, tn);
     } else {
       switch(sampler.interpolation) {
-        case Interpolation::Linear:
-          result = sampler.linear(channel.prevKey, nextKey, tn);
-          break;
-        case Interpolation::Step: result = sampler.keyFrames[channel.prevKey]; break;
+        case Interpolation::Linear: result = sampler.linear(key, nextKey, tn); break;
+        case Interpolation::Step: result = sampler.keyFrames[key]; break;
         case Interpolation::CubicSpline:
-          result = sampler.cubicSpline(channel.prevKey, nextKey, keyDelta, tn);
+          result = sampler.cubicSpline(key, nextKey, keyDelta, tn);
           break;
       }
     }
   }
+  return result;
+}
+
+void Animation::apply(uint32_t index, const glm::vec4 &result) {
+  auto &channel = channels[index];
+  auto transform = channel.node->transform();
   switch(channel.path) {
     case Path::Translation: transform.translation = result; break;
     case Path::Rotation:
@@ -96,6 +105,19 @@ glm::vec4 Animation::AnimationSampler::interpolateRotation(
   return {result.x, result.y, result.z, result.w};
 }
 
+uint32_t Animation::AnimationSampler::nextKey(float t, uint32_t prevKey) const {
+  auto last = uint32_t(keyTimings.size() - 1);
+  auto next = std::min(prevKey + 1, last);
+  if(t > keyTimings[next]) {
+    if(next < last && t <= keyTimings[next + 1]) ++next;
+    else
+      next = uint32_t(
+        std::lower_bound(keyTimings.begin() + next, keyTimings.end(), t) -
+        keyTimings.begin());
+  }
+  return std::clamp(next, 1u, last);
+}
+
 glm::vec4 Animation::AnimationSampler::linear(
   uint32_t key, uint32_t nextKey, float tn) const {
   return glm::mix(keyFrames[key], keyFrames[nextKey], tn);
@@ -105,9 +127,40 @@ Model::Model(std::vector<Ptr<Node>> &&nodes, std::vector<Animation> &&animations
   : _nodes{std::move(nodes)}, _animations{std::move(animations)} {
   for(auto &node: _nodes)
     node->fix();
+
+  std::vector<std::pair<Ptr<Node>, int32_t>> stack;
+  for(auto node = _nodes.rbegin(); node != _nodes.rend(); ++node)
+    stack.emplace_back(*node, -1);
+  while(!stack.empty()) {
+    auto [node, parent] = stack.back();
+    stack.pop_back();
+    auto index = int32_t(_hierarchy.size());
+    _hierarchyIndices[node.index()] = index;
+    _hierarchy.push_back(node);
+    _parents.push_back(parent);
+    auto &children = node->children();
+    for(auto child = children.rbegin(); child != children.rend(); ++child)
+      stack.emplace_back(*child, index);
+  }
+
+  _animated.resize(_hierarchy.size(), false);
+  for(auto &animation: _animations) {
+    auto &targets = _channelTargets.emplace_back();
+    for(auto &channel: animation.channels) {
+      auto target = hierarchyIndex(channel.node);
+      _animated[target] = true;
+      targets.push_back(target);
+    }
+  }
 }
 
 const std::vector<Ptr<Node>> &Model::nodes() const { return _nodes; }
+const std::vector<Ptr<Node>> &Model::hierarchy() const { return _hierarchy; }
+uint32_t Model::hierarchyIndex(const Ptr<Node> &node) const {
+  auto it = _hierarchyIndices.find(node.index());
+  errorIf(it == _hierarchyIndices.end(), "node doesn't belong to the model");
+  return it->second;
+}
 AABB Model::aabb() {
   _aabb = {};
   for(auto &node: _nodes)
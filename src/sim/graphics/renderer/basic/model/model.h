@@ -1,4 +1,5 @@
 #pragma once
+#include <unordered_map>
 #include "node.h"
 
 namespace sim::graphics::renderer::basic {
@@ -23,11 +24,26 @@ public:
     glm::vec4 cubicSpline(uint32_t key, uint32_t nextKey, float keyDelta, float t) const;
     glm::vec4 interpolateRotation(uint32_t key, uint32_t nextKey, float t) const;
     glm::vec4 linear(uint32_t key, uint32_t nextKey, float t) const;
+    /**
+     * @return the first key after t, starting from the cursor prevKey. Keys only move
+     * forward between wraps, so this is usually one step; far jumps binary search.
+     */
+    uint32_t nextKey(float t, uint32_t prevKey) const;
   };
   void reset(uint32_t index);
   void resetAll();
+  /**sample and apply channel index immediately.*/
   void animate(uint32_t index, float elapsed);
   void animateAll(float elapsed);
+  /**
+   * advance channel index by elapsed and return its value. Only the channel's own cursor
+   * is written, so distinct channels can be sampled concurrently.
+   */
+  glm::vec4 sample(uint32_t index, float elapsed);
+  /**sample channel index with an external cursor, e.g. one per model instance.*/
+  glm::vec4 sample(uint32_t index, float elapsed, float &time, uint32_t &key) const;
+  /**write a value sampled from channel index into its node's transform.*/
+  void apply(uint32_t index, const glm::vec4 &value);
 
   std::string name;
   std::vector<AnimationSampler> samplers;
@@ -37,20 +53,35 @@ public:
 class Model {
   friend class BasicSceneManager;
   friend class ModelInstance;
+  friend class AnimationManager;
 
 public:
   Model(std::vector<Ptr<Node>> &&nodes, std::vector<Animation> &&animations);
 
   const std::vector<Ptr<Node>> &nodes() const;
+  /**every node of the model, parents before their children.*/
+  const std::vector<Ptr<Node>> &hierarchy() const;
 
   AABB aabb();
 
   std::vector<Animation> &animations();
 
+private:
+  uint32_t hierarchyIndex(const Ptr<Node> &node) const;
+
 private:
   std::vector<Ptr<Node>> _nodes;
   std::vector<Animation> _animations;
 
+  std::vector<Ptr<Node>> _hierarchy;
+  /**hierarchy index of each node's parent, -1 for roots.*/
+  std::vector<int32_t> _parents;
+  /**whether any animation channel targets the node.*/
+  std::vector<bool> _animated;
+  /**hierarchy index of the node targeted by each channel of each animation.*/
+  std::vector<std::vector<uint32_t>> _channelTargets;
+  std::unordered_map<uint32_t, uint32_t> _hierarchyIndices;
+
   AABB _aabb;
 };
 }
\ No newline at end of file
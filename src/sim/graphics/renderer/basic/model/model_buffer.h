@@ -1,172 +1,368 @@
 #pragma once
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
 #include "sim/util/range.h"
+#include "sim/util/range_allocator.h"
 #include "sim/graphics/base/vkcommon.h"
 #include "sim/graphics/base/resource/buffers.h"
 
 namespace sim::graphics::renderer::basic {
 using namespace sim::util;
 
+/**element ranges written to a host copy that each per-frame slice has yet to receive.*/
+class WriteLog {
+public:
+  explicit WriteLog(uint32_t numSlice): pending(numSlice) {}
+
+  void add(uint32_t offset, uint32_t num) {
+    for(auto &ranges: pending)
+      if(!ranges.empty() && ranges.back().endOffset() == offset)
+        ranges.back().size += num;
+      else
+        ranges.push_back({offset, num});
+  }
+
+  /**@return the sorted and merged ranges written since slice last caught up.*/
+  std::vector<Range> catchUp(uint32_t slice) {
+    auto ranges = std::move(pending[slice]);
+    pending[slice].clear();
+    std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b) {
+      return a.offset < b.offset;
+    });
+    std::vector<Range> merged;
+    for(auto &range: ranges)
+      if(!merged.empty() && range.offset <= merged.back().endOffset())
+        merged.back().size =
+          std::max(merged.back().endOffset(), range.endOffset()) - merged.back().offset;
+      else merged.push_back(range);
+    return merged;
+  }
+
+private:
+  std::vector<std::vector<Range>> pending;
+};
+
 template<typename T>
 struct Allocation {
   uint32_t offset;
   T *ptr;
+  /**set by buffers with per-frame slices, whose writes must go through write/written.*/
+  WriteLog *log{nullptr};
+
+  /**@return element i for writing.*/
+  T &write(uint32_t i = 0) const {
+    written(1, i);
+    return ptr[i];
+  }
+  /**log num elements from first that were written through ptr.*/
+  void written(uint32_t num, uint32_t first = 0) const {
+    if(log) log->add(offset + first, num);
+  }
 };
 
-template<typename T>
-class DeviceVertexBuffer {
+/**
+ * Device buffer of T whose ranges are sub-allocated and can be released. Ranges are
+ * moved to lower free blocks by copying them within the buffer, see allocateBelow.
+ */
+template<typename T, typename B>
+class DeviceRangeBuffer {
 public:
-  explicit DeviceVertexBuffer(const VmaAllocator &allocator, uint32_t maxNum)
-    : maxNum{maxNum}, _count{0} {
-    data = u<VertexBuffer>(allocator, maxNum * sizeof(T));
+  DeviceRangeBuffer(const VmaAllocator &allocator, uint32_t maxNum)
+    : maxNum{maxNum}, ranges{maxNum} {
+    data = u<B>(allocator, maxNum * sizeof(T));
   }
 
   Range add(Device &device, const T *ubo, uint32_t num) {
-    errorIf(_count + num >= this->maxNum, "exceeding max number of data");
-    auto offset = _count;
-    data->upload(device, ubo, num * sizeof(T), offset * sizeof(T));
-    _count += num;
-    return {offset, num};
+    auto range = add(device, num);
+    data->upload(device, ubo, num * sizeof(T), range.offset * sizeof(T));
+    return range;
   }
 
   Range add(Device &device, uint32_t num) {
-    errorIf(_count + num >= this->maxNum, "exceeding max number of data");
-    auto offset = _count;
-    _count += num;
-    return {offset, num};
+    Range range;
+    errorIf(!ranges.allocate(num, range), "exceeding max number of data");
+    return range;
   }
 
+  /**numFrame consecutive copies of ubo in one range.*/
   Range add(Device &device, const T *ubo, uint32_t num, uint32_t numFrame) {
-    errorIf(_count + num * numFrame >= this->maxNum, "exceeding max number of data");
-    auto offset = _count;
-    for(int i = 0; i < numFrame; ++i) {
-      data->upload(device, ubo, num * sizeof(T), _count * sizeof(T));
-      _count += num;
-    }
-    return {offset, num * numFrame};
+    auto range = add(device, num * numFrame);
+    for(uint32_t i = 0; i < numFrame; ++i)
+      data->upload(device, ubo, num * sizeof(T), (range.offset + i * num) * sizeof(T));
+    return range;
+  }
+
+  /**release range, which must not be read by frames still in flight.*/
+  void remove(const Range &range) { ranges.free(range); }
+
+  /**@return false if there is no free block of num elements ending at or before end.*/
+  bool allocateBelow(uint32_t num, uint32_t end, Range &range) {
+    return ranges.allocateLowest(num, end, range);
   }
 
-  uint32_t count() const { return _count; }
+  /**record copying the elements of src to dstOffset of this buffer.*/
+  void copy(vk::CommandBuffer cb, const Range &src, uint32_t dstOffset) {
+    vk::BufferCopy region{src.offset * sizeof(T), dstOffset * sizeof(T),
+                          src.size * sizeof(T)};
+    cb.copyBuffer(data->buffer(), data->buffer(), region);
+  }
+
+  uint32_t count() const { return ranges.used(); }
+  bool fragmented() const { return ranges.fragmented(); }
   vk::Buffer buffer() { return data->buffer(); }
 
 private:
-  uPtr<VertexBuffer> data;
-  uint32_t maxNum, _count;
+  uPtr<B> data;
+  uint32_t maxNum;
+  RangeAllocator ranges;
 };
 
-class DeviceIndexBuffer {
+template<typename T>
+class DeviceVertexBuffer: public DeviceRangeBuffer<T, VertexBuffer> {
+public:
+  DeviceVertexBuffer(const VmaAllocator &allocator, uint32_t maxNum)
+    : DeviceRangeBuffer<T, VertexBuffer>{allocator, maxNum} {}
+};
 
+class DeviceIndexBuffer: public DeviceRangeBuffer<uint32_t, IndexBuffer> {
 public:
   DeviceIndexBuffer(const VmaAllocator &allocator, uint32_t maxNum)
-    : maxNum{maxNum}, _count{0} {
-    data = u<IndexBuffer>(allocator, maxNum * sizeof(uint32_t));
-  }
+    : DeviceRangeBuffer<uint32_t, IndexBuffer>{allocator, maxNum} {}
+};
 
-  Range add(Device &device, const uint32_t *ubo, uint32_t num) {
-    errorIf(_count + num >= this->maxNum, "exceeding max number of data");
-    auto offset = _count;
-    data->upload(device, ubo, num * sizeof(uint32_t), offset * sizeof(uint32_t));
-    _count += num;
-    return {offset, num};
-  }
+template<typename T>
+class DeviceStorageBuffer: public DeviceRangeBuffer<T, StorageBuffer> {
+public:
+  DeviceStorageBuffer(const VmaAllocator &allocator, uint32_t maxNum)
+    : DeviceRangeBuffer<T, StorageBuffer>{allocator, maxNum} {}
+};
 
-  Range add(Device &device, uint32_t num) {
-    errorIf(_count + num >= this->maxNum, "exceeding max number of data");
-    auto offset = _count;
-    _count += num;
-    return {offset, num};
-  }
+template<typename T>
+struct HostUBOBuffer {
+  uPtr<HostUniformBuffer> data;
 
-  Range add(Device &device, const uint32_t *ubo, uint32_t num, uint32_t numFrame) {
-    errorIf(_count + num * numFrame >= this->maxNum, "exceeding max number of data");
-    auto offset = _count;
-    for(int i = 0; i < numFrame; ++i) {
-      data->upload(device, ubo, num * sizeof(uint32_t), _count * sizeof(uint32_t));
-      _count += num;
-    }
-    return {offset, num * numFrame};
+  explicit HostUBOBuffer(const VmaAllocator &allocator) {
+    data = u<HostUniformBuffer>(allocator, sizeof(T));
   }
 
-  uint32_t count() const { return _count; }
+  void update(Device &device, T ubo) { data->updateSingle(ubo); }
   vk::Buffer buffer() { return data->buffer(); }
-
-private:
-  uPtr<IndexBuffer> data;
-  uint32_t maxNum{-1u}, _count;
 };
 
+/**
+ * one copy of T per frame in flight, each at a dynamic-offset aligned stride, so that
+ * the host can write frame i+1 while the gpu still reads frame i.
+ */
 template<typename T>
-struct HostUBOBuffer {
+struct HostDynamicUBOBuffer {
   uPtr<HostUniformBuffer> data;
+  uint32_t numFrame;
+  vk::DeviceSize stride;
 
-  explicit HostUBOBuffer(const VmaAllocator &allocator) {
-    data = u<HostUniformBuffer>(allocator, sizeof(T));
+  HostDynamicUBOBuffer(Device &device, uint32_t numFrame): numFrame{numFrame} {
+    auto alignment = device.getLimits().minUniformBufferOffsetAlignment;
+    stride = (sizeof(T) + alignment - 1) / alignment * alignment;
+    data = u<HostUniformBuffer>(device.allocator(), stride * numFrame);
   }
 
-  void update(Device &device, T ubo) { data->updateSingle(ubo); }
+  void update(Device &device, uint32_t frame, T ubo) {
+    errorIf(frame >= numFrame, "exceeding number of frames");
+    data->updateSingle(ubo, uint32_t(offset(frame)));
+  }
+  uint32_t offset(uint32_t frame) const { return uint32_t(frame * stride); }
+  vk::DeviceSize size() const { return sizeof(T); }
   vk::Buffer buffer() { return data->buffer(); }
 };
 
+/**
+ * Single slots grow from the bottom of the buffer and consecutive blocks from the top.
+ * Released slots and blocks are reused, blocks only by requests of the same size.
+ *
+ * With numFrame, allocations point into a host copy and the device buffer holds one
+ * slice per frame in flight; flush copies what was written since a slice was last
+ * flushed, so the host never writes a slice the gpu may still read.
+ */
 template<typename T>
 struct HostManagedStorageUBOBuffer {
   uPtr<HostStorageBuffer> data;
+  std::vector<T> host;
+  uPtr<WriteLog> log;
   std::vector<uint32_t> freeSlots;
-  uint32_t maxNum;
+  std::unordered_map<uint32_t, std::vector<uint32_t>> freeBlocks;
+  uint32_t maxNum, next{0}, blockTop, _count{0};
+  vk::DeviceSize stride{0};
   HostManagedStorageUBOBuffer(const VmaAllocator &allocator, uint32_t maxNum)
-    : maxNum{maxNum} {
+    : maxNum{maxNum}, blockTop{maxNum} {
     data = u<HostStorageBuffer>(allocator, maxNum * sizeof(T));
-    freeSlots.reserve(maxNum);
-    for(int32_t i = maxNum; i > 0; --i)
-      freeSlots.push_back(i - 1);
+  }
+
+  HostManagedStorageUBOBuffer(Device &device, uint32_t maxNum, uint32_t numFrame)
+    : host(maxNum), maxNum{maxNum}, blockTop{maxNum} {
+    auto alignment = device.getLimits().minStorageBufferOffsetAlignment;
+    stride = (maxNum * sizeof(T) + alignment - 1) / alignment * alignment;
+    data = u<HostStorageBuffer>(device.allocator(), stride * numFrame);
+    log = u<WriteLog>(numFrame);
   }
 
   Allocation<T> allocate() {
-    errorIf(freeSlots.empty(), "Buffer is full!");
-    auto offset = freeSlots.back();
-    freeSlots.pop_back();
-    return {offset, data->ptr<T>() + offset};
+    uint32_t offset;
+    if(!freeSlots.empty()) {
+      offset = freeSlots.back();
+      freeSlots.pop_back();
+    } else {
+      errorIf(next >= blockTop, "Buffer is full!");
+      offset = next++;
+    }
+    _count++;
+    return {offset, base() + offset, log.get()};
+  }
+
+  /**allocate num consecutive elements.*/
+  Allocation<T> allocate(uint32_t num) {
+    uint32_t offset;
+    auto &blocks = freeBlocks[num];
+    if(!blocks.empty()) {
+      offset = blocks.back();
+      blocks.pop_back();
+    } else {
+      errorIf(blockTop < next + num, "Buffer is full!");
+      blockTop -= num;
+      offset = blockTop;
+    }
+    _count += num;
+    return {offset, base() + offset, log.get()};
   }
 
   void deallocate(Allocation<T> allocation) {
-    errorIf(allocation.ptr != data->ptr<T>() + allocation.offset, "Invalid allocation!");
+    errorIf(allocation.ptr != base() + allocation.offset, "Invalid allocation!");
     freeSlots.push_back(allocation.offset);
+    _count--;
+  }
+
+  void deallocate(Allocation<T> allocation, uint32_t num) {
+    errorIf(allocation.ptr != base() + allocation.offset, "Invalid allocation!");
+    freeBlocks[num].push_back(allocation.offset);
+    _count -= num;
   }
 
   void update(Device &device, uint32_t offset, T ubo) {
     errorIf(offset >= this->maxNum, "exceeding max number of data");
-    data->updateSingle(ubo, offset * sizeof(T));
+    if(log) {
+      host[offset] = ubo;
+      log->add(offset, 1);
+    } else
+      data->updateSingle(ubo, offset * sizeof(T));
   }
+
+  /**bring the slice of frame up to date with the host copy.*/
+  void flush(uint32_t frame) {
+    if(!log) return;
+    auto slice = data->ptr<char>() + offset(frame);
+    for(auto &range: log->catchUp(frame))
+      std::memcpy(
+        slice + range.offset * sizeof(T), host.data() + range.offset,
+        range.size * sizeof(T));
+  }
+
+  /**dynamic offset of the slice of frame.*/
+  uint32_t offset(uint32_t frame) const { return uint32_t(frame * stride); }
+  vk::DeviceSize size() const { return maxNum * sizeof(T); }
   vk::Buffer buffer() { return data->buffer(); }
 
-  uint32_t count() { return maxNum - freeSlots.size(); }
+  uint32_t count() { return _count; }
+
+private:
+  T *base() { return log ? host.data() : data->ptr<T>(); }
 };
 
+/**
+ * Draw commands packed at the front of the buffer. Removing a command moves the last one
+ * into its slot, so commands are addressed by handles that follow them.
+ *
+ * Commands are edited in a host copy. The buffer holds numSlice slices, and flush brings
+ * one up to date once no frame in flight reads it.
+ */
 struct HostIndirectUBOBuffer {
   using CMDType = vk::DrawIndexedIndirectCommand;
   uPtr<HostIndirectBuffer> data;
+  std::vector<CMDType> host;
+  WriteLog log;
   uint32_t maxNum, _count{0};
-  HostIndirectUBOBuffer(const VmaAllocator &allocator, uint32_t maxNum): maxNum{maxNum} {
-    data = u<HostIndirectBuffer>(allocator, maxNum * sizeof(CMDType));
+  /**slot of each handle, and handle of each used slot.*/
+  std::vector<uint32_t> slots, handles;
+  std::vector<uint32_t> freeHandles;
+  HostIndirectUBOBuffer(const VmaAllocator &allocator, uint32_t maxNum, uint32_t numSlice)
+    : host(maxNum), log{numSlice}, maxNum{maxNum} {
+    data = u<HostIndirectBuffer>(allocator, numSlice * maxNum * sizeof(CMDType));
+    handles.resize(maxNum);
   }
 
-  auto allocate() -> Allocation<CMDType> {
+  /**@return the handle of a new command at the end of the buffer.*/
+  uint32_t allocate() {
     errorIf(_count >= this->maxNum, "exceeding max number of data");
-    auto offset = _count++;
-    return {offset, data->ptr<CMDType>() + offset};
+    uint32_t handle;
+    if(!freeHandles.empty()) {
+      handle = freeHandles.back();
+      freeHandles.pop_back();
+    } else {
+      handle = uint32_t(slots.size());
+      slots.push_back(0);
+    }
+    auto slot = _count++;
+    slots[handle] = slot;
+    handles[slot] = handle;
+    return handle;
+  }
+
+  /**remove the command of handle, moving the last command into its slot.*/
+  void deallocate(uint32_t handle) {
+    auto slot = slots[handle];
+    errorIf(slot >= _count || handles[slot] != handle, "Invalid allocation!");
+    auto last = --_count;
+    if(slot != last) {
+      host[slot] = host[last];
+      log.add(slot, 1);
+      auto moved = handles[last];
+      slots[moved] = slot;
+      handles[slot] = moved;
+    }
+    freeHandles.push_back(handle);
   }
 
-  auto deallocate(Allocation<CMDType> allocation) {
-    errorIf(
-      allocation.ptr != data->ptr<CMDType>() + allocation.offset, "Invalid allocation!");
-    error("Not implemented");
+  /**@return the command of handle for writing.*/
+  CMDType &write(uint32_t handle) {
+    auto slot = slots[handle];
+    log.add(slot, 1);
+    return host[slot];
   }
 
-  void update(Device &device, uint32_t offset, vk::DrawIndexedIndirectCommand ubo) {
-    errorIf(offset >= _count, "exceeding allocated number of data");
-    data->updateSingle(ubo, offset * sizeof(vk::DrawIndexedIndirectCommand));
+  /**
+   * copy the commands written since slice was last flushed into it, moving their
+   * firstInstance by firstInstanceBase.
+   */
+  void flush(uint32_t slice, uint32_t firstInstanceBase) {
+    auto cmds = data->ptr<CMDType>() + slice * maxNum;
+    for(auto &range: log.catchUp(slice))
+      for(auto i = range.offset; i < range.endOffset(); ++i) {
+        cmds[i] = host[i];
+        cmds[i].firstInstance += firstInstanceBase;
+      }
   }
+
+  /**byte offset of slice in the buffer.*/
+  vk::DeviceSize offset(uint32_t slice) const { return slice * maxNum * sizeof(CMDType); }
   vk::Buffer buffer() { return data->buffer(); }
 
   uint32_t count() { return _count; }
 };
 
+/**a draw command in one of the draw queues.*/
+struct DrawCMDHandle {
+  HostIndirectUBOBuffer *queue;
+  uint32_t handle;
+
+  vk::DrawIndexedIndirectCommand &write() const { return queue->write(handle); }
+};
+
 }
\ No newline at end of file
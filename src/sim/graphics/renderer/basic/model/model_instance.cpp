@@ -11,34 +11,56 @@ MeshInstance::MeshInstance(
     _material(material),
     _node(node),
     _instance(instance),
+    _skinned{skinned(primitive, node, instance)},
     _ubo{mm.allocateMeshInstanceUBO()},
-    _drawCMDs{mm.allocateDrawCMD(_primitive, _material)} {
-  *_ubo.ptr = {_primitive->ubo.offset, _material ? _material->ubo.offset : -1u,
-               _node ? _node->ubo.offset : -1u, _instance ? _instance->_ubo.offset : -1u};
+    _batch{mm.allocateDrawCMD(
+      _primitive, _material, _skinned ? DynamicType::Dynamic : primitive.get().type(),
+      _ubo.offset, bool(_instance))} {
+  errorIf(_primitive && _primitive.get()._released, "primitive has been removed!");
+  _ubo.write() = {
+    _primitive->ubo.offset, _material ? _material->ubo.offset : -1u,
+    _node ? _node->ubo.offset : -1u, _instance ? _instance->_ubo.offset : -1u};
 
+  if(_skinned) {
+    _skinnedVertices = mm.allocateSkinnedVertices(_primitive->position().size);
+    _skinJob =
+      mm.skinningManager_->add(_primitive, _node, _instance, _skinnedVertices.offset);
+  }
+  writeDrawCMDs();
+}
+
+void MeshInstance::writeDrawCMDs() {
   Range index, vertex;
   if(_primitive) {
     auto &p = _primitive.get();
-    vertex = p.position();
+    vertex = _skinned ? _skinnedVertices : p.position();
     index = p.index();
   }
-  uint32_t numFrame = _drawCMDs.size();
-  for(int i = 0; i < _drawCMDs.size(); ++i) {
-    *_drawCMDs[i].ptr = vk::DrawIndexedIndirectCommand{
-      index.size / numFrame,
-      _instance ? (_visible ? 1u : 0u) : 0u,
-      index.offset + i * index.size / numFrame,
-      int32_t(vertex.offset + i * vertex.size / numFrame),
-      _ubo.offset,
-    };
+  // instances of a batch share the primitive, so they write the same ranges.
+  auto &drawCMDs = _mm.Buffer.drawQueue->drawCMDs(_batch);
+  uint32_t numFrame = drawCMDs.size();
+  // skinned vertices change per frame, but the indices are the primitive's static ones.
+  uint32_t numIndices = _skinned ? index.size : index.size / numFrame;
+  uint32_t indexStride = _skinned ? 0 : numIndices;
+  for(int i = 0; i < numFrame; ++i) {
+    auto &cmd = drawCMDs[i].write();
+    cmd.indexCount = numIndices;
+    cmd.firstIndex = index.offset + i * indexStride;
+    cmd.vertexOffset = int32_t(vertex.offset + i * vertex.size / numFrame);
   }
 }
 
+bool MeshInstance::skinned(
+  const Ptr<Primitive> &primitive, const Ptr<Node> &node,
+  const Ptr<ModelInstance> &instance) {
+  return primitive && node && instance && !node.get()._skin.isNull() &&
+         primitive.get().joint0().size > 0;
+}
+
 void MeshInstance::setVisible(bool visible) {
   if(_visible != visible) {
     _visible = visible;
-    for(auto &drawCmd: _drawCMDs)
-      drawCmd.ptr->instanceCount = _instance ? (_visible ? 1u : 0u) : 0u;
+    _mm.Buffer.drawQueue->setVisible(_batch, _ubo.offset, _instance && _visible);
   }
 }
 
@@ -49,9 +71,14 @@ void ModelInstance::applyModel(Ptr<Model> model, Ptr<ModelInstance> instance) {
 }
 
 void ModelInstance::generateMeshInstances(Ptr<ModelInstance> instance, Ptr<Node> node) {
-  for(auto &mesh: node->_meshes)
+  auto &mm = instance->_mm;
+  for(auto &mesh: node->_meshes) {
+    auto primitive = mesh->primitive();
+    auto index = uint32_t(instance->_meshInstances.size());
     instance->_meshInstances.emplace_back(
-      instance->_mm, mesh->primitive(), mesh->material(), node, instance);
+      mm, primitive, mesh->material(), node, instance);
+    if(primitive) mm.addPrimitiveUser(primitive, instance, index);
+  }
   for(auto &child: node->_children)
     generateMeshInstances(instance, child);
 }
@@ -62,11 +89,30 @@ ModelInstance::ModelInstance(
   setTransform(transform);
 }
 
+void ModelInstance::ownPose() {
+  if(_pose.ptr) return;
+  auto &model = *_model;
+  _pose = _mm.allocateMatrixUBO(uint32_t(model._hierarchy.size()));
+  _mm.updateTransforms();
+  for(size_t i = 0; i < model._hierarchy.size(); ++i)
+    _pose.write(uint32_t(i)) = model._hierarchy[i]->_global;
+  for(auto &meshInstance: _meshInstances) {
+    meshInstance._ubo.write().node = nodeSlot(meshInstance._node);
+    if(meshInstance._skinned) _mm.skinningManager_->refresh(meshInstance._skinJob);
+  }
+}
+
+uint32_t ModelInstance::nodeSlot(const Ptr<Node> &node) const {
+  if(!_pose.ptr) return node.get().ubo.offset;
+  return _pose.offset + _model.get().hierarchyIndex(node);
+}
+
 Ptr<Model> ModelInstance::model() { return _model; }
 const Transform &ModelInstance::transform() const { return _transform; }
 void ModelInstance::setTransform(const Transform &transform) {
+  errorIf(_removed, "model instance has been removed!");
   _transform = transform;
-  *_ubo.ptr = _transform.toMatrix();
+  _ubo.write() = _transform.toMatrix();
 }
 bool ModelInstance::visible() const { return _visible; }
 void ModelInstance::setVisible(bool visible) {
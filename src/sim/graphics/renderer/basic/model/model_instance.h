@@ -8,6 +8,7 @@ class BasicSceneManager;
 class MeshInstance {
   friend class BasicSceneManager;
   friend class ModelInstance;
+  friend class SkinningManager;
 
   // ref in shaders
   struct UBO {
@@ -21,6 +22,15 @@ public:
 
 private:
   void setVisible(bool visible);
+  /**write the current vertex and index ranges to the draw commands of every frame.*/
+  void writeDrawCMDs();
+  /**
+   * a mesh is skinned if its node has a skin and its primitive carries joints. It draws
+   * the vertices the skinning pass writes for each frame, from the dynamic queues.
+   */
+  static bool skinned(
+    const Ptr<Primitive> &primitive, const Ptr<Node> &node,
+    const Ptr<ModelInstance> &instance);
 
 private:
   BasicSceneManager &_mm;
@@ -31,20 +41,35 @@ private:
   Ptr<ModelInstance> _instance{};
 
   bool _visible{true};
+  bool _skinned{false};
+  /**the mesh's job in the skinning manager, if skinned.*/
+  uint32_t _skinJob{-1u};
+  /**the frames' output vertices of the skinning pass, if skinned.*/
+  Range _skinnedVertices{};
 
   Allocation<MeshInstance::UBO> _ubo;
-  std::vector<Allocation<vk::DrawIndexedIndirectCommand>> _drawCMDs;
+  /**the mesh instance's batch in the draw queue.*/
+  uint32_t _batch;
 };
 
 class ModelInstance {
   friend class BasicSceneManager;
   friend class MeshInstance;
+  friend class AnimationManager;
+  friend class SkinningManager;
 
 public:
   static void applyModel(Ptr<Model> model, Ptr<ModelInstance> instance);
 
 private:
   static void generateMeshInstances(Ptr<ModelInstance> instance, Ptr<Node> node);
+  /**
+   * give the instance its own block of node matrices, in Model::hierarchy order, and
+   * point its meshes at it instead of the model's shared nodes.
+   */
+  void ownPose();
+  /**@return the slot of node's world matrix in the transforms buffer for this instance.*/
+  uint32_t nodeSlot(const Ptr<Node> &node) const;
 
 public:
   explicit ModelInstance(
@@ -64,7 +89,11 @@ private:
   std::vector<MeshInstance> _meshInstances;
 
   bool _visible{true};
+  /**set by BasicSceneManager::removeModelInstance.*/
+  bool _removed{false};
 
   Allocation<glm::mat4> _ubo;
+  /**the instance's own pose; ptr is null while it shares the model's.*/
+  Allocation<glm::mat4> _pose{0, nullptr};
 };
 }
\ No newline at end of file
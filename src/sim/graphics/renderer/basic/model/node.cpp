@@ -5,32 +5,42 @@ namespace sim::graphics::renderer::basic {
 
 Node::Node(BasicSceneManager &mm, const Transform &transform, const std::string &name)
   : mm{mm}, _transform{transform}, _name{name}, ubo{mm.allocateMatrixUBO()} {
-  *ubo.ptr = _transform.toMatrix();
+  _global = _transform.toMatrix();
+  ubo.write() = _global;
 }
 std::string &Node::name() { return _name; }
 void Node::setName(const std::string &name) { _name = name; }
 const Transform &Node::transform() const { return _transform; }
 void Node::setTransform(const Transform &transform) {
   _transform = transform;
-  updateMatrix();
+  markDirty();
+}
+
+void Node::markDirty() {
+  if(_dirty) return;
+  _dirty = true;
+  mm.Scene.firstDirtyNode = std::min(mm.Scene.firstDirtyNode, _order);
 }
 
 void Node::updateMatrix() {
-  auto m = _transform.toMatrix();
-  if(_parent) {
-    auto parentMatrix = *_parent->ubo.ptr;
-    m = parentMatrix * m;
-  }
-  *ubo.ptr = m;
+  _global = _transform.toMatrix();
+  if(_parent) _global = _parent->_global * _global;
+  ubo.write() = _global;
+  _dirty = false;
 
   for(auto &child: _children)
-    child->updateMatrix();
+    child->_dirty = true;
 }
 
 const std::vector<Ptr<Mesh>> &Node::meshes() const { return _meshes; }
 const Ptr<Node> &Node::parent() const { return _parent; }
 
 const std::vector<Ptr<Node>> &Node::children() const { return _children; }
+const Ptr<Skin> &Node::skin() const { return _skin; }
+void Node::setSkin(const Ptr<Skin> &skin) {
+  errorIf(fixed, "Node is fixed, cannot set skin");
+  _skin = skin;
+}
 
 void Node::addMesh(Ptr<Node> node, Ptr<Mesh> mesh) {
   errorIf(node->fixed, "Node is fixed, cannot add mesh");
@@ -41,12 +51,14 @@ void Node::addChild(Ptr<Node> parent, Ptr<Node> child) {
   errorIf(parent->fixed || child->fixed, "Node is fixed, cannot add child or parent");
   parent->_children.push_back(child);
   child->_parent = parent;
-  child->updateMatrix();
+  child->markDirty();
+  child->mm.Scene.nodeOrderStale = true;
 }
 
 AABB Node::aabb() {
+  mm.updateTransforms();
   _aabb = {};
-  auto m = *ubo.ptr;
+  auto &m = _global;
   for(auto &mesh: _meshes)
     _aabb.merge(mesh->_primitive->aabb().transform(m));
 
@@ -3,6 +3,7 @@
 //
 
 #pragma once
+#include <limits>
 #include "aabb.h"
 #include "transform.h"
 #include "mesh.h"
@@ -10,12 +11,14 @@
 namespace sim::graphics::renderer::basic {
 
 class BasicSceneManager;
+class Skin;
 
 class Node {
   friend class BasicSceneManager;
   friend class Mesh;
   friend class ModelInstance;
   friend class MeshInstance;
+  friend class SkinningManager;
 
 public:
   static void addMesh(Ptr<Node> node, Ptr<Mesh> mesh);
@@ -27,16 +30,25 @@ public:
   std::string &name();
   void setName(const std::string &name);
   const Transform &transform() const;
+  /**
+   * only marks the node dirty; world matrices are recomputed once per frame in a single
+   * parent-before-child pass, see BasicSceneManager::updateTransforms.
+   */
   void setTransform(const Transform &transform);
   const std::vector<Ptr<Mesh>> &meshes() const;
   const Ptr<Node> &parent() const;
   const std::vector<Ptr<Node>> &children() const;
+  /**meshes of a node with a skin are deformed by the skin's joints.*/
+  const Ptr<Skin> &skin() const;
+  void setSkin(const Ptr<Skin> &skin);
 
   AABB aabb();
 
   void fix();
 
 private:
+  void markDirty();
+  /**recompute the world matrix from the parent's and mark the children dirty.*/
   void updateMatrix();
 
 private:
@@ -48,12 +60,17 @@ private:
 
   Ptr<Node> _parent{};
   std::vector<Ptr<Node>> _children{};
+  Ptr<Skin> _skin{};
 
   AABB _aabb;
 
   Allocation<glm::mat4> ubo;
+  glm::mat4 _global{1};
 
   bool fixed{false};
+  bool _dirty{false};
+  /**position in the scene's linearized node order.*/
+  uint32_t _order{std::numeric_limits<uint32_t>::max()};
 };
 
 }
\ No newline at end of file
@@ -42,5 +42,16 @@ void Primitive::setTesselationLevel(float tesselationLevel) {
   ubo.ptr->_tesselationLevel = _tesselationLevel;
 }
 DynamicType Primitive::type() const { return _type; }
+bool Primitive::quantized() const { return _quantized; }
+uint32_t Primitive::numLODs() const { return _numLODs; }
+const Range &Primitive::lodIndex(uint32_t level) const {
+  errorIf(level >= _numLODs, "level of detail out of range!");
+  return level == 0 ? _index : _lods[level - 1];
+}
+float Primitive::lodError(uint32_t level) const {
+  errorIf(level >= _numLODs, "level of detail out of range!");
+  return level == 0 ? 0.f : _lodErrors[level - 1];
+}
+const Range &Primitive::clusters() const { return _clusters; }
 
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include "aabb.h"
 #include "sim/util/range.h"
 #include "model_buffer.h"
@@ -20,8 +21,13 @@ class Primitive {
   friend class MeshInstance;
   friend class PrimitiveBuilder;
   friend class BasicSceneManager;
+  friend class SkinningManager;
 
 public:
+  //ref in shaders
+  /**levels of detail of a primitive, the full one included.*/
+  static constexpr uint32_t maxNumLODs = 4;
+
   //ref in shaders
   struct alignas(sizeof(glm::vec4)) UBO {
     Range _index, _position, _normal, _uv, _joint0, _weight0;
@@ -30,6 +36,11 @@ public:
     float _tesselationLevel{64.0f};
     PrimitiveTopology _topology{PrimitiveTopology::Triangles};
     DynamicType _type{DynamicType::Static};
+    AABB _quantization;
+    Range _lods[maxNumLODs - 1]{};
+    float _lodErrors[maxNumLODs - 1]{};
+    uint32_t _numLODs{1};
+    Range _clusters{};
   };
 
 public:
@@ -58,6 +69,16 @@ public:
   void setLod(bool lod);
   PrimitiveTopology topology() const;
   DynamicType type() const;
+  /**true if the vertices are in the compact streams of QuantizedVertex.*/
+  bool quantized() const;
+  /**number of levels of detail, 1 if the primitive only has its full indices.*/
+  uint32_t numLODs() const;
+  /**@return the index range of level, 0 being the full primitive.*/
+  const Range &lodIndex(uint32_t level) const;
+  /**@return how far level deviates from the full primitive, in position units.*/
+  float lodError(uint32_t level) const;
+  /**@return the range of the clusters in the cluster buffer, empty if not clustered.*/
+  const Range &clusters() const;
 
 private:
   BasicSceneManager &mm;
@@ -68,6 +89,18 @@ private:
   float _tesselationLevel{64.0f};
   PrimitiveTopology _topology{PrimitiveTopology::Triangles};
   DynamicType _type{DynamicType::Static};
+  /**set by BasicSceneManager::removePrimitive.*/
+  bool _released{false};
+  bool _quantized{false};
+  /**the box quantized positions are relative to, fixed on upload unlike the aabb.*/
+  AABB _quantization;
+  /**the indices of the coarser levels, and each level's range in the index buffer.*/
+  Range _lodIndices;
+  std::array<Range, maxNumLODs - 1> _lods{};
+  std::array<float, maxNumLODs - 1> _lodErrors{};
+  uint32_t _numLODs{1};
+  /**the clusters of the full indices, see ModelConfig::clusterTriangles.*/
+  Range _clusters;
 
   Allocation<UBO> ubo;
 };
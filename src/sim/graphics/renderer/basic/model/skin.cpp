@@ -0,0 +1,14 @@
+#include "skin.h"
+
+namespace sim::graphics::renderer::basic {
+Skin::Skin(
+  std::vector<Ptr<Node>> &&joints, std::vector<glm::mat4> &&inverseBindMatrices,
+  uint32_t ibmOffset)
+  : _joints{std::move(joints)},
+    _inverseBindMatrices{std::move(inverseBindMatrices)},
+    ibmOffset{ibmOffset} {}
+const std::vector<Ptr<Node>> &Skin::joints() const { return _joints; }
+const std::vector<glm::mat4> &Skin::inverseBindMatrices() const {
+  return _inverseBindMatrices;
+}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "node.h"
+
+namespace sim::graphics::renderer::basic {
+
+/**
+ * The joints of a skinned mesh. Vertex joint indices refer to the joints list; each joint
+ * brings the vertex from the mesh's bind space into the joint's space with its inverse
+ * bind matrix.
+ */
+class Skin {
+  friend class SkinningManager;
+
+public:
+  Skin(
+    std::vector<Ptr<Node>> &&joints, std::vector<glm::mat4> &&inverseBindMatrices,
+    uint32_t ibmOffset);
+
+  const std::vector<Ptr<Node>> &joints() const;
+  const std::vector<glm::mat4> &inverseBindMatrices() const;
+
+private:
+  std::vector<Ptr<Node>> _joints;
+  std::vector<glm::mat4> _inverseBindMatrices;
+  /**first inverse bind matrix of the skin in the skinning manager's buffer.*/
+  uint32_t ibmOffset;
+};
+}
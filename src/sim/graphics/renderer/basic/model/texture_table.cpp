@@ -0,0 +1,99 @@
+#include "texture_table.h"
+#include <algorithm>
+#include "sim/graphics/base/pipeline/descriptor_pool_maker.h"
+
+namespace sim::graphics::renderer::basic {
+TextureTable::TextureTable(
+  const vk::Device &device, uint32_t capacity, uint32_t maxCapacity, uint32_t numFrame)
+  : device{device},
+    _capacity{std::clamp(capacity, 1u, maxCapacity)},
+    maxCapacity{maxCapacity},
+    numFrame{numFrame} {
+  setDef.textures.descriptorCount() = maxCapacity;
+  setDef.init(device);
+  current = allocateSet(_capacity);
+}
+
+auto TextureTable::allocateSet(uint32_t capacity) -> Generation {
+  Generation generation;
+  generation.pool = DescriptorPoolMaker()
+                      .combinedImageSampler(capacity)
+                      .set(1)
+                      .updateAfterBind()
+                      .createUnique(device);
+  generation.set = setDef.createSet(*generation.pool, capacity);
+  return generation;
+}
+
+uint32_t TextureTable::allocate() {
+  if(!freeSlots.empty()) {
+    auto slot = freeSlots.back();
+    freeSlots.pop_back();
+    return slot;
+  }
+  errorIf(infos.size() >= maxCapacity, "exceeding maximum number of textures!");
+  infos.emplace_back();
+  return uint32_t(infos.size() - 1);
+}
+
+void TextureTable::set(uint32_t slot, const Texture &texture) {
+  infos.at(slot) = {
+    texture.sampler(), texture.imageView(), vk::ImageLayout::eShaderReadOnlyOptimal};
+  dirty.push_back(slot);
+}
+
+void TextureTable::release(uint32_t slot) {
+  // the descriptor is left as it is: a partially bound slot nobody reads may be stale.
+  infos.at(slot) = {};
+  freeSlots.push_back(slot);
+}
+
+void TextureTable::update(uint64_t frame) {
+  // a set replaced at frame r was last bound by frame r-1, which completed before this
+  // frame once r-1+numFrame frames are updated.
+  auto released = std::find_if(retired.begin(), retired.end(), [&](auto &generation) {
+    return frame + 1 < generation.frame + numFrame;
+  });
+  retired.erase(retired.begin(), released);
+
+  if(infos.size() > _capacity) {
+    auto capacity = _capacity;
+    while(capacity < infos.size())
+      capacity = std::min(capacity * 2, maxCapacity);
+    current.frame = frame;
+    retired.push_back(std::move(current));
+    current = allocateSet(capacity);
+    _capacity = capacity;
+    // nothing reads the new set yet: every slot in use is written again.
+    dirty.clear();
+    for(uint32_t slot = 0; slot < infos.size(); ++slot)
+      dirty.push_back(slot);
+  }
+  if(dirty.empty()) return;
+
+  std::sort(dirty.begin(), dirty.end());
+  dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+  // one write per run of consecutive slots, leaving out the ones given back meanwhile.
+  for(size_t i = 0; i < dirty.size();) {
+    auto first = dirty[i];
+    if(!infos[first].imageView) {
+      ++i;
+      continue;
+    }
+    uint32_t count = 1;
+    while(i + count < dirty.size() && dirty[i + count] == first + count &&
+          infos[first + count].imageView)
+      ++count;
+    setDef.textures(first, count, infos.data() + first);
+    i += count;
+  }
+  setDef.update(current.set);
+  dirty.clear();
+}
+
+vk::DescriptorSet TextureTable::descriptorSet() const { return current.set; }
+uint32_t TextureTable::count() const {
+  return uint32_t(infos.size() - freeSlots.size());
+}
+uint32_t TextureTable::capacity() const { return _capacity; }
+}
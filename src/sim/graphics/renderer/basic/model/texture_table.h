@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include "sim/graphics/base/pipeline/descriptors.h"
+
+namespace sim::graphics::renderer::basic {
+/**
+ * The 2d textures that materials index, bound as one array of combined image samplers
+ * with update after bind, partially bound and of variable size. Slots given back are
+ * reused. The array grows by allocating a larger set of the same layout, so pipelines
+ * stay valid; the smaller set lives on until the frames binding it complete. Descriptors
+ * are only ever written to slots that no frame in flight reads.
+ */
+class TextureTable {
+  using flag = vk::DescriptorBindingFlagBitsEXT;
+  using shader = vk::ShaderStageFlagBits;
+
+public:
+  struct TextureSetDef: DescriptorSetDef {
+    __samplers__(
+      textures,
+      flag::eUpdateAfterBind | flag::ePartiallyBound | flag::eVariableDescriptorCount |
+        flag::eUpdateUnusedWhilePending,
+      shader::eVertex | shader::eFragment | shader::eTessellationControl |
+        shader::eTessellationEvaluation);
+  } setDef;
+
+  /**
+   * @param capacity number of slots of the first set.
+   * @param maxCapacity number of slots the table may grow to; the size of the layout.
+   * @param numFrame number of frames in flight.
+   */
+  TextureTable(
+    const vk::Device &device, uint32_t capacity, uint32_t maxCapacity, uint32_t numFrame);
+
+  /**@return a free slot, one given back before if any.*/
+  uint32_t allocate();
+  /**point slot at texture from the next update on.*/
+  void set(uint32_t slot, const Texture &texture);
+  /**give slot back. No frame in flight may read it anymore.*/
+  void release(uint32_t slot);
+  /**
+   * write the descriptors set since the last update, or move to a larger set if the
+   * slots outgrew this one.
+   * @param frame number of frames updated so far.
+   */
+  void update(uint64_t frame);
+
+  vk::DescriptorSet descriptorSet() const;
+  /**number of slots in use.*/
+  uint32_t count() const;
+  /**number of slots of the current set.*/
+  uint32_t capacity() const;
+
+private:
+  struct Generation {
+    vk::UniqueDescriptorPool pool;
+    vk::DescriptorSet set;
+    /**the first frame that no longer binds set.*/
+    uint64_t frame{0};
+  };
+
+  Generation allocateSet(uint32_t capacity);
+
+  vk::Device device;
+  uint32_t _capacity, maxCapacity, numFrame;
+
+  /**the descriptor of each slot; free slots have no image view.*/
+  std::vector<vk::DescriptorImageInfo> infos;
+  std::vector<uint32_t> freeSlots;
+  /**slots set since the last update.*/
+  std::vector<uint32_t> dirty;
+
+  Generation current;
+  std::vector<Generation> retired;
+};
+}
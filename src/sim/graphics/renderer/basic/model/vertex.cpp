@@ -1,3 +1,28 @@
 #include "vertex.h"
 namespace sim::graphics::renderer::basic {
-}
\ No newline at end of file
+
+QuantizedVertex::Position QuantizedVertex::position(
+  const Vertex::Position &position, const AABB &box) {
+  auto halfRange = box.halfRange();
+  // flat axes decode to the center whatever is stored.
+  auto scale = glm::vec3{halfRange.x > 0 ? 1 / halfRange.x : 0,
+                         halfRange.y > 0 ? 1 / halfRange.y : 0,
+                         halfRange.z > 0 ? 1 / halfRange.z : 0};
+  auto q = glm::clamp((position - box.center()) * scale, -1.f, 1.f);
+  return Position{glm::round(q * 32767.f), 0};
+}
+
+QuantizedVertex::Normal QuantizedVertex::normal(const Vertex::Normal &normal) {
+  auto l1 = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+  if(l1 == 0) return glm::packSnorm2x16({});
+  auto e = glm::vec2{normal} / l1;
+  if(normal.z < 0)
+    e = (1.f - glm::abs(glm::vec2{e.y, e.x})) *
+        glm::vec2{e.x >= 0 ? 1.f : -1.f, e.y >= 0 ? 1.f : -1.f};
+  return glm::packSnorm2x16(e);
+}
+
+QuantizedVertex::UV QuantizedVertex::uv(const Vertex::UV &uv) {
+  return glm::packHalf2x16(uv);
+}
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include "sim/graphics/base/vkcommon.h"
+#include "aabb.h"
+#include <glm/gtc/type_precision.hpp>
 
 namespace sim::graphics::renderer::basic {
 // ref in shaders
@@ -12,4 +14,19 @@ struct Vertex {
   using Joint = glm::vec4;
   using Weight = glm::vec4;
 };
+
+// ref in shaders
+/**compact vertex streams of static primitives, see ModelConfig::quantizeVertices.*/
+struct QuantizedVertex {
+  /**snorm16 coordinates within the primitive's quantization box; w is padding.*/
+  using Position = glm::i16vec4;
+  /**snorm16x2 octahedral encoding.*/
+  using Normal = uint32_t;
+  /**half2.*/
+  using UV = uint32_t;
+
+  static Position position(const Vertex::Position &position, const AABB &box);
+  static Normal normal(const Vertex::Normal &normal);
+  static UV uv(const Vertex::UV &uv);
+};
 }
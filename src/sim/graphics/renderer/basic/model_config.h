@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <string>
 
 namespace sim::graphics::renderer::basic {
 struct ModelConfig {
@@ -18,15 +19,83 @@ struct ModelConfig {
     maxNumTransparentMeshes{1'000}, maxNumTransparentLineMeshes{1'000};
   /**max number of terrain mesh instances*/
   uint32_t maxNumTerranMeshes{1'000};
-  /**max number of dynamic mesh instances*/
-  uint32_t maxNumDynamicMeshes{1'000}, maxNumDynamicLineMeshes{1'000},
+  /**max number of dynamic mesh instances, including skinned ones*/
+  uint32_t maxNumDynamicMeshes{1'0000}, maxNumDynamicLineMeshes{1'000},
     maxNumDynamicTransparentMeshes{1'000}, maxNumDynamicTransparentLineMeshes{1'000};
   /**max number of terrain mesh instances*/
   uint32_t maxNumDynamicTerranMeshes{1'000};
 
-  /**max number of texture including 2d and cube map.*/
+  /**max number of skinned mesh instances*/
+  uint32_t maxNumSkinnedMeshes{1'0000};
+  /**max number of joints over all skins, and over all skinned mesh instances*/
+  uint32_t maxNumJoints{10'0000};
+
+  /**
+   * max number of vertices plus indices that static primitives move to lower free blocks
+   * of the vertex and index buffers per frame, to compact the holes left by
+   * BasicSceneManager::removePrimitive; 0 disables defragmentation.
+   */
+  uint32_t defragmentBudget{0};
+
+  /**
+   * store static primitives in compact vertex streams: positions as snorm16 within the
+   * primitive's bounds, octahedral normals in 32 bits and half float uvs, 16 bytes per
+   * vertex instead of 32. Static primitives then get maxNumVertex compact vertices and
+   * dynamic primitives and skinned meshes maxNumDynamicVertex full ones.
+   */
+  bool quantizeVertices{false};
+  /**
+   * reorder the triangles of static primitives for the post-transform vertex cache and
+   * less overdraw, and their vertices in the order the triangles fetch them. Primitives
+   * of more than 64k triangles are split and optimized on numLoaderThreads workers.
+   */
+  bool optimizeIndices{false};
+  /**
+   * simplify static triangle primitives into up to Primitive::maxNumLODs levels of
+   * detail when they are created; culling then draws every mesh instance with the
+   * coarsest level whose error stays within CullingManager::lodError pixels.
+   */
+  bool generateLODs{false};
+  /**
+   * split static triangle primitives of more than ClusterBuilder::minClusteredTriangles
+   * triangles into clusters with bounding spheres and normal cones. Culling then draws
+   * the opaque mesh instances of their full level of detail cluster by cluster, leaving
+   * out the clusters outside the frustum or facing away from the camera. Needs
+   * VK_KHR_draw_indirect_count; without it the primitives are drawn whole.
+   */
+  bool clusterTriangles{false};
+  /**max number of clusters over all primitives*/
+  uint32_t maxNumClusters{10'0000};
+  /**
+   * max number of visible mesh instances culled cluster by cluster per frame; the others
+   * are drawn whole. At most the device's maxComputeWorkGroupCount[0].
+   */
+  uint32_t maxNumClusteredInstances{1'0000};
+  /**
+   * max number of clusters drawn per frame. Every cluster of a clustered instance is
+   * reserved, visible or not; instances whose clusters no longer fit are drawn whole.
+   */
+  uint32_t maxNumClusterDraws{20'0000};
+
+  /**initial number of slots of the 2d texture table; it grows as textures are added.*/
   uint32_t maxNumTexture{1000};
+  /**max number of slots the 2d texture table grows to, within the device's update after
+   * bind limits.*/
+  uint32_t maxNumTextureSlots{64 * 1024};
   /**max number of lights*/
   uint32_t maxNumLights{1};
+
+  /**worker threads used by loadModel to decode images and convert vertex data; 1 loads
+   * on the calling thread, 0 uses the hardware concurrency.*/
+  uint32_t numLoaderThreads{0};
+  /**worker threads sampling the animations played by AnimationManager; 1 samples on the
+   * calling thread, 0 uses the hardware concurrency.*/
+  uint32_t numAnimationThreads{0};
+  /**worker threads evaluating the ocean spectrum when the wind or wave amplitude
+   * changes; 1 evaluates on the calling thread, 0 uses the hardware concurrency.*/
+  uint32_t numOceanThreads{0};
+  /**directory the cooked models, the precomputed sky textures and the baked image based
+   * lighting maps are cached in, created on first use; empty disables the caches.*/
+  std::string cacheDir;
 };
 }
\ No newline at end of file
@@ -2,14 +2,16 @@
 #include "../basic_scene_manager.h"
 #include "sim/graphics/compiledShaders/ocean/wave_fft_ping_comp.h"
 #include "sim/graphics/compiledShaders/ocean/wave_fft_pong_comp.h"
+#include <random>
 
 namespace sim::graphics::renderer::basic {
 using bindpoint = vk::PipelineBindPoint;
 using stage = vk::PipelineStageFlagBits;
 using access = vk::AccessFlagBits;
 
-OceanManager::OceanManager(BasicSceneManager &mm)
+OceanManager::OceanManager(BasicSceneManager &mm, uint32_t numThreads)
   : mm(mm), device{mm.device()}, debugMarker{mm.debugMarker()} {
+  if(numThreads != 1) pool = u<ThreadPool>(numThreads);
   oceanSetDef.init(device.getDevice());
   oceanLayoutDef.set(oceanSetDef);
   oceanLayoutDef.init(device.getDevice());
@@ -39,7 +41,12 @@ Ptr<ModelInstance> OceanManager::newField(float patchSize, int N) {
   debugMarker.name(bitReversalBuffer->buffer(), "bitReversalBuffer");
   debugMarker.name(datumBuffers->buffer(), "datumBuffers");
 
-  initOceanData();
+  spectrum = u<OceanSpectrum>(N, patchSize, std::random_device{}());
+  spectrum->setWind(windDirection_, windSpeed_);
+  spectrum->setWaveAmplitude(waveAmplitude_);
+  fft = u<OceanFFT>(*spectrum, pool.get());
+  sliceVersions.assign(mm.config().numFrame, 0);
+  updateSpectrum();
 
   oceanSetDef.bitReversal(bitReversalBuffer->buffer());
   oceanSetDef.datum(datumBuffers->buffer());
@@ -69,69 +76,50 @@ Ptr<ModelInstance> OceanManager::newField(float patchSize, int N) {
     ComputePipelineMaker pipelineMaker{device.getDevice()};
     pipelineMaker.shader(wave_fft_ping_comp, __ArraySize__(wave_fft_ping_comp), &spInfo);
 
-    pingPipe = pipelineMaker.createUnique(nullptr, *oceanLayoutDef.pipelineLayout);
+    pingPipe = pipelineMaker.createUnique(
+      device.getPipelineCache(), *oceanLayoutDef.pipelineLayout);
   }
   {
     ComputePipelineMaker pipelineMaker{device.getDevice()};
     pipelineMaker.shader(wave_fft_pong_comp, __ArraySize__(wave_fft_pong_comp), &spInfo);
 
-    pongPipe = pipelineMaker.createUnique(nullptr, *oceanLayoutDef.pipelineLayout);
+    pongPipe = pipelineMaker.createUnique(
+      device.getPipelineCache(), *oceanLayoutDef.pipelineLayout);
   }
   return sea;
 }
 
 void OceanManager::updateWind(glm::vec2 windDirection, float windSpeed) {
-  windDx_ = windDirection.x;
-  windDy_ = windDirection.y;
+  windDirection_ = windDirection;
   windSpeed_ = windSpeed;
-
-  initOceanData();
+  if(!spectrum) return;
+  spectrum->setWind(windDirection, windSpeed);
+  updateSpectrum();
 }
 
 void OceanManager::updateWaveAmplitude(float waveAmplitude) {
   waveAmplitude_ = waveAmplitude;
-
-  initOceanData();
+  if(!spectrum) return;
+  spectrum->setWaveAmplitude(waveAmplitude);
+  updateSpectrum();
 }
 
-float OceanManager::phillipsSpectrum(glm::vec2 k) {
-  float L = windSpeed_ * windSpeed_ / g;
-  float damping = 0.001f;
-  float l = L * damping;
-  float sqrK = dot(k, k);
-  glm::vec2 windDir{windDx_, windDy_};
-  float cosK = dot(k, windDir);
-  float phillips =
-    waveAmplitude_ * glm::exp(-1 / (sqrK * L * L)) / (sqrK * sqrK * sqrK) * (cosK * cosK);
-  if(cosK < 0) phillips *= 0.07f;
-  return phillips * glm::exp(-sqrK * l * l);
+void OceanManager::updateSpectrum() {
+  spectrum->update(pool.get());
+  fft->invalidate();
+  ++spectrumVersion;
 }
 
-glm::vec2 OceanManager::hTiled_0(glm::vec2 k) {
-  float phillips = (k.x == 0 && k.y == 0) ? 0 : glm::sqrt(phillipsSpectrum(k));
-  return {guassian() * phillips / sqrt(2), guassian() * phillips / glm::sqrt(2)};
-}
+float OceanManager::time() const { return oceanConstant.time; }
+float OceanManager::timeScale() const { return oceanConstant.timeScale; }
 
-void OceanManager::initOceanData() {
-  for(int i = 0; i < mm.config().numFrame; ++i) {
-    auto ptr = datumBuffers->ptr<Ocean>() + i * N * N;
-    for(auto row = 0; row < N; ++row) {
-      glm::vec2 k;
-      k.y = (float(-N) / 2.f + row) * 2 * PI / oceanConstant.patchSize;
-      for(auto column = 0; column < N; ++column) {
-        k.x = (float(-N) / 2.f + column) * 2 * PI / oceanConstant.patchSize;
-        glm::vec2 phi = hTiled_0(k);
-        ptr[row * N + column].h0 = {phi.x, phi.y};
-      }
-    }
-  }
+OceanFFT &OceanManager::surface() {
+  errorIf(!fft, "no ocean field yet!");
+  return *fft;
 }
 
 void OceanManager::compute(
   vk::CommandBuffer cb, uint32_t imageIndex, float elapsedDuration) {
-  static float time = 0;
-  time += elapsedDuration;
-
   cb.bindDescriptorSets(
     bindpoint::eCompute, *oceanLayoutDef.pipelineLayout, oceanLayoutDef.set.set(),
     oceanSet, nullptr);
@@ -139,6 +127,15 @@ void OceanManager::compute(
   auto dataSize = N * N;
   auto offset = imageIndex * dataSize;
 
+  // the frame that last read this slice has completed.
+  if(sliceVersions[imageIndex] != spectrumVersion) {
+    auto slice = datumBuffers->ptr<Ocean>() + offset;
+    auto &h0 = spectrum->h0();
+    for(auto i = 0; i < dataSize; ++i)
+      slice[i].h0 = h0[i];
+    sliceVersions[imageIndex] = spectrumVersion;
+  }
+
   auto &positionRange = seaPrimitive->position();
   auto &normalRange = seaPrimitive->normal();
 
@@ -146,9 +143,8 @@ void OceanManager::compute(
     positionRange.offset + imageIndex * positionRange.size / mm.config().numFrame;
   oceanConstant.normalOffset =
     normalRange.offset + imageIndex * normalRange.size / mm.config().numFrame;
-  oceanConstant.dataOffset = 0;
-  //  oceanConstant.dataOffset = offset;
-  oceanConstant.time = time;
+  oceanConstant.dataOffset = offset;
+  oceanConstant.time += elapsedDuration;
 
   debugMarker.begin(cb, toString("compute wave mesh ", imageIndex).c_str());
   cb.bindPipeline(bindpoint::eCompute, *pingPipe);
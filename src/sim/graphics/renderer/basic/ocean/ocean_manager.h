@@ -5,35 +5,48 @@
 #include "sim/graphics/base/resource/buffers.h"
 #include "sim/graphics/base/pipeline/pipeline.h"
 #include "sim/graphics/base/pipeline/descriptors.h"
+#include "sim/graphics/util/ocean/ocean_fft.h"
 #include "../model/basic_model.h"
 
 namespace sim::graphics::renderer::basic {
 class BasicSceneManager;
+/**
+ * Animates an ocean field by FFT on the GPU. The spectrum is evaluated on the CPU, across
+ * numThreads workers, whenever the wind or the wave amplitude changes, and copied into a
+ * frame's data slice only when that frame is recorded again, so no slice changes while
+ * the GPU may read it.
+ */
 class OceanManager {
 public:
-  explicit OceanManager(BasicSceneManager &mm);
+  /**@param numThreads workers evaluating the spectrum; 0 uses the hardware concurrency.*/
+  OceanManager(BasicSceneManager &mm, uint32_t numThreads);
 
   Ptr<ModelInstance> newField(float patchSize = 500.f, int N = 128);
 
   void updateWind(glm::vec2 windDirection, float windSpeed);
   void updateWaveAmplitude(float waveAmplitude);
 
+  /**the time of the last computed frame, before the shaders scale it.*/
+  float time() const;
+  /**the scale the shaders apply to time().*/
+  float timeScale() const;
+  /**
+   * the surface of the field on the CPU, for physics; pass it time() and timeScale() to
+   * sample the frame last computed. Needs newField first.
+   */
+  OceanFFT &surface();
+
 private:
   void createDescriptorSets(vk::DescriptorPool descriptorPool);
   bool enabled();
 
-  glm::vec2 hTiled_0(glm::vec2 k);
-  float phillipsSpectrum(glm::vec2 k);
-  void initOceanData();
+  void updateSpectrum();
 
   void compute(vk::CommandBuffer computeCB, uint32_t imageIndex, float elapsedDuration);
 
 private:
   friend class BasicSceneManager;
 
-  const float g = 9.8f;
-  const float PI = glm::pi<float>();
-
   using shader = vk::ShaderStageFlagBits;
   struct OceanDescriptorSet: DescriptorSetDef {
     __buffer__(bitReversal, shader::eCompute);
@@ -73,13 +86,20 @@ private:
   uPtr<HostStorageBuffer> bitReversalBuffer;
   uPtr<HostStorageBuffer> datumBuffers;
 
+  uPtr<OceanSpectrum> spectrum;
+  uPtr<OceanFFT> fft;
+  uPtr<ThreadPool> pool;
+  /**bumped by every spectrum update; the version each frame's slice holds.*/
+  uint64_t spectrumVersion{0};
+  std::vector<uint64_t> sliceVersions;
+
   Ptr<Primitive> seaPrimitive;
 
   bool initialized{false};
   int32_t N{128};
   uint32_t lx{128}, ly{1};
 
-  float windDx_{0.8f}, windDy_{0.6f};
+  glm::vec2 windDirection_{0.8f, 0.6f};
   float windSpeed_{60.f};
   float waveAmplitude_{10.f};
 };
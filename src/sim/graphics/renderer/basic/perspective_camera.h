@@ -7,6 +7,7 @@ public:
   enum side { LEFT = 0, RIGHT = 1, TOP = 2, BOTTOM = 3, BACK = 4, FRONT = 5 };
   std::array<glm::vec4, 6> planes{};
 
+  Frustum() = default;
   explicit Frustum(glm::mat4 matrix) {
     planes[LEFT].x = matrix[0].w + matrix[0].x;
     planes[LEFT].y = matrix[1].w + matrix[1].x;
@@ -32,7 +32,7 @@ void BasicRenderer::createDeferredPipeline(
     pipelineMaker.shader(shader::eFragment, deferred_frag, __ArraySize__(deferred_frag));
   }
   Pipelines.deferred =
-    pipelineMaker.createUnique(*pipelineCache, pipelineLayout, *renderPass);
+    pipelineMaker.createUnique(device->getPipelineCache(), pipelineLayout, *renderPass);
   debugMarker.name(*Pipelines.deferred, "deferred pipeline");
 
   pipelineMaker.clearShaders();
@@ -45,7 +45,7 @@ void BasicRenderer::createDeferredPipeline(
     pipelineMaker.shader(
       shader::eFragment, deferred_ibl_frag, __ArraySize__(deferred_ibl_frag));
   Pipelines.deferredIBL =
-    pipelineMaker.createUnique(*pipelineCache, pipelineLayout, *renderPass);
+    pipelineMaker.createUnique(device->getPipelineCache(), pipelineLayout, *renderPass);
   debugMarker.name(*Pipelines.deferredIBL, "deferred IBL pipeline");
 
   pipelineMaker.clearShaders();
@@ -58,7 +58,7 @@ void BasicRenderer::createDeferredPipeline(
     pipelineMaker.shader(
       shader::eFragment, deferred_sky_frag, __ArraySize__(deferred_sky_frag));
   Pipelines.deferredSky =
-    pipelineMaker.createUnique(*pipelineCache, pipelineLayout, *renderPass);
+    pipelineMaker.createUnique(device->getPipelineCache(), pipelineLayout, *renderPass);
   debugMarker.name(*Pipelines.deferredSky, "deferred Sky pipeline");
 }
 }
\ No newline at end of file
@@ -4,18 +4,14 @@
 
 namespace sim::graphics::renderer::basic {
 using shader = vk::ShaderStageFlagBits;
-using f = vk::Format;
 
 void BasicRenderer::createOpaquePipeline(
-  const vk::PipelineLayout &pipelineLayout) { // Pipeline
+  const vk::PipelineLayout &pipelineLayout, bool quantized) { // Pipeline
+  auto &pipelines = quantized ? QuantizedPipelines : Pipelines;
+  auto prefix = quantized ? "quantized " : "";
   GraphicsPipelineMaker pipelineMaker{vkDevice, extent.width, extent.height};
+  vertexInput(pipelineMaker, quantized);
   pipelineMaker.subpass(Subpasses.gBuffer)
-    .vertexBinding(0, sizeof(Vertex::Position))
-    .vertexAttribute(0, 0, f::eR32G32B32Sfloat, 0)
-    .vertexBinding(1, sizeof(Vertex::Normal))
-    .vertexAttribute(1, 1, f::eR32G32B32Sfloat, 0)
-    .vertexBinding(2, sizeof(Vertex::UV))
-    .vertexAttribute(2, 2, f::eR32G32Sfloat, 0)
     .topology(vk::PrimitiveTopology::eTriangleList)
     .polygonMode(vk::PolygonMode::eFill)
     .cullMode(vk::CullModeFlagBits::eBack)
@@ -35,28 +31,31 @@ void BasicRenderer::createOpaquePipeline(
   pipelineMaker.blendColorAttachment(false);
   pipelineMaker.blendColorAttachment(false);
 
-  pipelineMaker.shader(shader::eVertex, basic_vert, __ArraySize__(basic_vert));
-  SpecializationMaker sp;
-  auto spInfo = sp.entry(modelConfig.maxNumTexture).create();
+  SpecializationMaker vertSp;
+  auto vertSpInfo = vertSp.entry(vk::Bool32(quantized)).create();
   pipelineMaker.shader(
-    shader::eFragment, gbuffer_frag, __ArraySize__(gbuffer_frag), &spInfo);
-  Pipelines.opaqueTri =
-    pipelineMaker.createUnique(*pipelineCache, pipelineLayout, *renderPass);
-  debugMarker.name(*Pipelines.opaqueTri, "opaque triangle pipeline");
+    shader::eVertex, basic_vert, __ArraySize__(basic_vert), &vertSpInfo);
+  pipelineMaker.shader(shader::eFragment, gbuffer_frag, __ArraySize__(gbuffer_frag));
+  pipelines.opaqueTri =
+    pipelineMaker.createUnique(device->getPipelineCache(), pipelineLayout, *renderPass);
+  debugMarker.name(
+    *pipelines.opaqueTri, toString(prefix, "opaque triangle pipeline").c_str());
 
   pipelineMaker.polygonMode(vk::PolygonMode::eLine);
 
-  Pipelines.opaqueTriWireframe =
-    pipelineMaker.createUnique(*pipelineCache, pipelineLayout, *renderPass);
-  debugMarker.name(*Pipelines.opaqueTriWireframe, "opaque wireframe pipeline");
+  pipelines.opaqueTriWireframe =
+    pipelineMaker.createUnique(device->getPipelineCache(), pipelineLayout, *renderPass);
+  debugMarker.name(
+    *pipelines.opaqueTriWireframe, toString(prefix, "opaque wireframe pipeline").c_str());
 
   pipelineMaker.topology(vk::PrimitiveTopology::eLineList)
     .polygonMode(vk::PolygonMode::eFill)
     .cullMode(vk::CullModeFlagBits::eNone)
     .lineWidth(1.f);
-  Pipelines.opaqueLine =
-    pipelineMaker.createUnique(*pipelineCache, pipelineLayout, *renderPass);
-  debugMarker.name(*Pipelines.opaqueLine, "opaque line pipeline");
+  pipelines.opaqueLine =
+    pipelineMaker.createUnique(device->getPipelineCache(), pipelineLayout, *renderPass);
+  debugMarker.name(
+    *pipelines.opaqueLine, toString(prefix, "opaque line pipeline").c_str());
 }
 
 }
\ No newline at end of file
@@ -6,18 +6,14 @@
 
 namespace sim::graphics::renderer::basic {
 using shader = vk::ShaderStageFlagBits;
-using f = vk::Format;
 
 void BasicRenderer::createTerrainPipeline(
-  const vk::PipelineLayout &pipelineLayout) { // Pipeline
+  const vk::PipelineLayout &pipelineLayout, bool quantized) { // Pipeline
+  auto &pipelines = quantized ? QuantizedPipelines : Pipelines;
+  auto prefix = quantized ? "quantized " : "";
   GraphicsPipelineMaker pipelineMaker{vkDevice, extent.width, extent.height};
+  vertexInput(pipelineMaker, quantized);
   pipelineMaker.subpass(Subpasses.gBuffer)
-    .vertexBinding(0, sizeof(Vertex::Position))
-    .vertexAttribute(0, 0, f::eR32G32B32Sfloat, 0)
-    .vertexBinding(1, sizeof(Vertex::Normal))
-    .vertexAttribute(1, 1, f::eR32G32B32Sfloat, 0)
-    .vertexBinding(2, sizeof(Vertex::UV))
-    .vertexAttribute(2, 2, f::eR32G32Sfloat, 0)
     .topology(vk::PrimitiveTopology::ePatchList)
     .tesselationState(4)
     .polygonMode(vk::PolygonMode::eFill)
@@ -38,26 +34,27 @@ void BasicRenderer::createTerrainPipeline(
   pipelineMaker.blendColorAttachment(false);
   pipelineMaker.blendColorAttachment(false);
 
-  SpecializationMaker sp;
-  auto spInfo = sp.entry(modelConfig.maxNumTexture).create();
+  SpecializationMaker vertSp;
+  auto vertSpInfo = vertSp.entry(vk::Bool32(quantized)).create();
   pipelineMaker
-    .shader(shader::eVertex, terrain_tess_vert, __ArraySize__(terrain_tess_vert))
     .shader(
-      shader::eTessellationControl, terrain_tesc, __ArraySize__(terrain_tesc), &spInfo)
-    .shader(
-      shader::eTessellationEvaluation, terrain_tese, __ArraySize__(terrain_tese), &spInfo)
-    .shader(shader::eFragment, gbuffer_frag, __ArraySize__(gbuffer_frag), &spInfo);
+      shader::eVertex, terrain_tess_vert, __ArraySize__(terrain_tess_vert), &vertSpInfo)
+    .shader(shader::eTessellationControl, terrain_tesc, __ArraySize__(terrain_tesc))
+    .shader(shader::eTessellationEvaluation, terrain_tese, __ArraySize__(terrain_tese))
+    .shader(shader::eFragment, gbuffer_frag, __ArraySize__(gbuffer_frag));
 
-  Pipelines.terrainTess =
-    pipelineMaker.createUnique(*pipelineCache, pipelineLayout, *renderPass);
-  debugMarker.name(*Pipelines.terrainTess, "terrain tessellation pipeline");
+  pipelines.terrainTess =
+    pipelineMaker.createUnique(device->getPipelineCache(), pipelineLayout, *renderPass);
+  debugMarker.name(
+    *pipelines.terrainTess, toString(prefix, "terrain tessellation pipeline").c_str());
 
   pipelineMaker.polygonMode(vk::PolygonMode::eLine);
 
-  Pipelines.terrainTessWireframe =
-    pipelineMaker.createUnique(*pipelineCache, pipelineLayout, *renderPass);
+  pipelines.terrainTessWireframe =
+    pipelineMaker.createUnique(device->getPipelineCache(), pipelineLayout, *renderPass);
   debugMarker.name(
-    *Pipelines.terrainTessWireframe, "terrain tessellation wireframe pipeline");
+    *pipelines.terrainTessWireframe,
+    toString(prefix, "terrain tessellation wireframe pipeline").c_str());
 }
 
 }
\ No newline at end of file
@@ -4,18 +4,14 @@
 
 namespace sim::graphics::renderer::basic {
 using shader = vk::ShaderStageFlagBits;
-using f = vk::Format;
 
 void BasicRenderer::createTranslucentPipeline(
-  const vk::PipelineLayout &pipelineLayout) { // translucent pipeline
+  const vk::PipelineLayout &pipelineLayout, bool quantized) { // translucent pipeline
+  auto &pipelines = quantized ? QuantizedPipelines : Pipelines;
+  auto prefix = quantized ? "quantized " : "";
   GraphicsPipelineMaker pipelineMaker{vkDevice, extent.width, extent.height};
+  vertexInput(pipelineMaker, quantized);
   pipelineMaker.subpass(Subpasses.translucent)
-    .vertexBinding(0, sizeof(Vertex::Position))
-    .vertexAttribute(0, 0, f::eR32G32B32Sfloat, 0)
-    .vertexBinding(1, sizeof(Vertex::Normal))
-    .vertexAttribute(1, 1, f::eR32G32B32Sfloat, 0)
-    .vertexBinding(2, sizeof(Vertex::UV))
-    .vertexAttribute(2, 2, f::eR32G32Sfloat, 0)
     .cullMode(vk::CullModeFlagBits::eNone)
     .frontFace(vk::FrontFace::eCounterClockwise)
     .depthTestEnable(true)
@@ -37,19 +33,24 @@ void BasicRenderer::createTranslucentPipeline(
     .alphaBlendOp(vk::BlendOp::eAdd)
     .colorWriteMask(flag::eR | flag::eG | flag::eB | flag::eA);
 
-  pipelineMaker.shader(shader::eVertex, basic_vert, __ArraySize__(basic_vert));
+  SpecializationMaker vertSp;
+  auto vertSpInfo = vertSp.entry(vk::Bool32(quantized)).create();
+  pipelineMaker.shader(
+    shader::eVertex, basic_vert, __ArraySize__(basic_vert), &vertSpInfo);
   pipelineMaker.shader(
     shader::eFragment, translucent_frag, __ArraySize__(translucent_frag));
 
-  Pipelines.transTri =
-    pipelineMaker.createUnique(*pipelineCache, pipelineLayout, *renderPass);
-  debugMarker.name(*Pipelines.transTri, "translucent tri pipeline");
+  pipelines.transTri =
+    pipelineMaker.createUnique(device->getPipelineCache(), pipelineLayout, *renderPass);
+  debugMarker.name(
+    *pipelines.transTri, toString(prefix, "translucent tri pipeline").c_str());
 
   pipelineMaker.topology(vk::PrimitiveTopology::eLineList)
     .cullMode(vk::CullModeFlagBits::eNone)
     .lineWidth(1.f);
-  Pipelines.transLine =
-    pipelineMaker.createUnique(*pipelineCache, pipelineLayout, *renderPass);
-  debugMarker.name(*Pipelines.transLine, "translucent line pipeline");
+  pipelines.transLine =
+    pipelineMaker.createUnique(device->getPipelineCache(), pipelineLayout, *renderPass);
+  debugMarker.name(
+    *pipelines.transLine, toString(prefix, "translucent line pipeline").c_str());
 }
 }
\ No newline at end of file
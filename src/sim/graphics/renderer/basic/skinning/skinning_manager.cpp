@@ -0,0 +1,168 @@
+#include "skinning_manager.h"
+#include "../basic_scene_manager.h"
+#include "sim/graphics/compiledShaders/skinning/joint_palette_comp.h"
+#include "sim/graphics/compiledShaders/skinning/skin_comp.h"
+#include <algorithm>
+
+namespace sim::graphics::renderer::basic {
+using bindpoint = vk::PipelineBindPoint;
+using stage = vk::PipelineStageFlagBits;
+using access = vk::AccessFlagBits;
+
+SkinningManager::SkinningManager(BasicSceneManager &mm)
+  : mm{mm},
+    device{mm.device()},
+    debugMarker{mm.debugMarker()},
+    numFrame{mm.config().numFrame},
+    maxNumJoints{mm.modelConfig().maxNumJoints},
+    maxNumJobs{mm.modelConfig().maxNumSkinnedMeshes},
+    paletteRanges{mm.modelConfig().maxNumJoints} {
+  // jobs are spread over the y dimension of the skin dispatch.
+  errorIf(
+    maxNumJobs > device.getLimits().maxComputeWorkGroupCount[1],
+    "max number of skinned meshes exceeds the compute work group count limit!");
+
+  auto &allocator = device.allocator();
+  inverseBindMatrices =
+    u<HostStorageBuffer>(allocator, maxNumJoints * sizeof(glm::mat4));
+  paletteEntries = u<HostStorageBuffer>(allocator, maxNumJoints * sizeof(PaletteEntry));
+  jobs = u<HostStorageBuffer>(allocator, maxNumJobs * sizeof(SkinJob));
+  palette = u<StorageBuffer>(
+    allocator, vk::DeviceSize(numFrame) * maxNumJoints * sizeof(glm::mat4));
+  debugMarker.name(inverseBindMatrices->buffer(), "inverse bind matrices buffer");
+  debugMarker.name(paletteEntries->buffer(), "palette entries buffer");
+  debugMarker.name(jobs->buffer(), "skin jobs buffer");
+  debugMarker.name(palette->buffer(), "joint palette buffer");
+
+  skinSetDef.init(device.getDevice());
+  skinLayoutDef.set(skinSetDef);
+  skinLayoutDef.init(device.getDevice());
+
+  ComputePipelineMaker pipelineMaker{device.getDevice()};
+  pipelineMaker.shader(joint_palette_comp, __ArraySize__(joint_palette_comp));
+  palettePipe =
+    pipelineMaker.createUnique(device.getPipelineCache(), *skinLayoutDef.pipelineLayout);
+  SpecializationMaker sp;
+  auto spInfo = sp.entry(vk::Bool32(mm.modelConfig().quantizeVertices)).create();
+  pipelineMaker.shader(skin_comp, __ArraySize__(skin_comp), &spInfo);
+  skinPipe =
+    pipelineMaker.createUnique(device.getPipelineCache(), *skinLayoutDef.pipelineLayout);
+}
+
+void SkinningManager::createDescriptorSets(vk::DescriptorPool descriptorPool) {
+  skinSet = skinSetDef.createSet(descriptorPool);
+
+  skinSetDef.positions(mm.Buffer.position->buffer());
+  skinSetDef.normals(mm.Buffer.normal->buffer());
+  skinSetDef.uvs(mm.Buffer.uv->buffer());
+  skinSetDef.joints(mm.Buffer.joint0->buffer());
+  skinSetDef.weights(mm.Buffer.weight0->buffer());
+  skinSetDef.transforms(mm.Buffer.transforms->buffer(), mm.Buffer.transforms->size());
+  skinSetDef.inverseBindMatrices(inverseBindMatrices->buffer());
+  skinSetDef.paletteEntries(paletteEntries->buffer());
+  skinSetDef.jobs(jobs->buffer());
+  skinSetDef.palette(palette->buffer());
+  // without quantized vertices the skin pass never reads these; any buffer does.
+  auto quantized = mm.modelConfig().quantizeVertices;
+  skinSetDef.quantizedPositions(
+    quantized ? mm.Buffer.quantizedPosition->buffer() : mm.Buffer.position->buffer());
+  skinSetDef.quantizedNormals(
+    quantized ? mm.Buffer.quantizedNormal->buffer() : mm.Buffer.normal->buffer());
+  skinSetDef.quantizedUVs(
+    quantized ? mm.Buffer.quantizedUV->buffer() : mm.Buffer.uv->buffer());
+  skinSetDef.primitives(mm.Buffer.primitives->buffer());
+  skinSetDef.update(skinSet);
+}
+
+uint32_t SkinningManager::count() const { return uint32_t(skinned.size()); }
+
+uint32_t SkinningManager::addSkin(const std::vector<glm::mat4> &ibms) {
+  errorIf(
+    numIBMs + ibms.size() > maxNumJoints,
+    "exceeding max number of inverse bind matrices!");
+  auto offset = numIBMs;
+  std::copy(ibms.begin(), ibms.end(), inverseBindMatrices->ptr<glm::mat4>() + offset);
+  numIBMs += uint32_t(ibms.size());
+  return offset;
+}
+
+uint32_t SkinningManager::add(
+  const Ptr<Primitive> &primitive, const Ptr<Node> &node,
+  const Ptr<ModelInstance> &instance, uint32_t dstVertex) {
+  auto numJoints = uint32_t(node.get()._skin.get()._joints.size());
+  errorIf(skinned.size() >= maxNumJobs, "exceeding max number of skinned meshes!");
+  Range palette;
+  errorIf(
+    !paletteRanges.allocate(numJoints, palette), "exceeding max number of joints!");
+
+  auto &p = primitive.get();
+  // skin.comp reads the source normals and uvs at the position offset.
+  errorIf(
+    p.normal().offset != p.position().offset || p.uv().offset != p.position().offset,
+    "skinned primitive's vertex streams are out of step!");
+  auto job = uint32_t(skinned.size());
+  skinned.push_back({node, instance, palette});
+  jobs->ptr<SkinJob>()[job] = {p.position().offset, p.joint0().offset,
+                               p.weight0().offset,  p.position().size,
+                               dstVertex,           palette.offset,
+                               p.ubo.offset};
+  numEntries = std::max(numEntries, palette.endOffset());
+  maxVertices = std::max(maxVertices, p.position().size);
+  refresh(job);
+  return job;
+}
+
+void SkinningManager::refresh(uint32_t job) {
+  auto &s = skinned[job];
+  auto &skin = s.node.get()._skin.get();
+  auto &instance = s.instance.get();
+  auto meshNode = instance.nodeSlot(s.node);
+  auto entries = paletteEntries->ptr<PaletteEntry>() + s.palette.offset;
+  for(uint32_t i = 0; i < skin._joints.size(); ++i)
+    entries[i] = {instance.nodeSlot(skin._joints[i]), skin.ibmOffset + i, meshNode, 0};
+}
+
+void SkinningManager::remove(uint32_t job) {
+  // entries left in the freed palette range are still computed, but no job reads them.
+  paletteRanges.free(skinned[job].palette);
+  auto last = uint32_t(skinned.size() - 1);
+  if(job != last) {
+    skinned[job] = skinned[last];
+    jobs->ptr<SkinJob>()[job] = jobs->ptr<SkinJob>()[last];
+    for(auto &meshInstance: skinned[job].instance->_meshInstances)
+      if(meshInstance._skinJob == last) meshInstance._skinJob = job;
+  }
+  skinned.pop_back();
+}
+
+void SkinningManager::compute(vk::CommandBuffer cb, uint32_t imageIndex) {
+  if(skinned.empty()) return;
+  auto numJobs = uint32_t(skinned.size());
+  SkinConstant constant{imageIndex, imageIndex * maxNumJoints, numEntries, numJobs};
+
+  debugMarker.begin(cb, toString("skinning frame:", imageIndex).c_str());
+  cb.bindDescriptorSets(
+    bindpoint::eCompute, *skinLayoutDef.pipelineLayout, skinLayoutDef.set.set(), skinSet,
+    mm.Buffer.transforms->offset(imageIndex));
+  cb.pushConstants<SkinConstant>(
+    *skinLayoutDef.pipelineLayout, shader::eCompute, 0, constant);
+
+  cb.bindPipeline(bindpoint::eCompute, *palettePipe);
+  cb.dispatch((numEntries + 63) / 64, 1, 1);
+
+  auto matrixSize = vk::DeviceSize(sizeof(glm::mat4));
+  vk::BufferMemoryBarrier barrier{access::eShaderWrite,
+                                  access::eShaderRead,
+                                  VK_QUEUE_FAMILY_IGNORED,
+                                  VK_QUEUE_FAMILY_IGNORED,
+                                  palette->buffer(),
+                                  imageIndex * maxNumJoints * matrixSize,
+                                  maxNumJoints * matrixSize};
+  cb.pipelineBarrier(
+    stage::eComputeShader, stage::eComputeShader, {}, nullptr, barrier, nullptr);
+
+  cb.bindPipeline(bindpoint::eCompute, *skinPipe);
+  cb.dispatch((maxVertices + 63) / 64, numJobs, 1);
+  debugMarker.end(cb);
+}
+}
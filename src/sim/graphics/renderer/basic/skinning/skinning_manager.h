@@ -0,0 +1,138 @@
+#pragma once
+#include "sim/graphics/base/device.h"
+#include "sim/graphics/base/debug_marker.h"
+#include "sim/graphics/base/resource/buffers.h"
+#include "sim/graphics/base/pipeline/pipeline.h"
+#include "sim/graphics/base/pipeline/descriptors.h"
+#include "../model/basic_model.h"
+
+namespace sim::graphics::renderer::basic {
+class BasicSceneManager;
+
+/**
+ * Skins meshes on the gpu every frame. A palette pass computes one matrix per joint of
+ * every skinned mesh instance from the joints' world matrices in the transforms buffer,
+ * then a skin pass blends the joint0/weight0 streams of the source primitive with it and
+ * writes the skinned positions, normals and uvs into the frame's output range, which the
+ * mesh instance draws from the dynamic queues.
+ *
+ * Palette matrices bring vertices into the space of the mesh's node, so the vertex shader
+ * applies the node and instance transforms to skinned vertices as to any other.
+ *
+ * With ModelConfig::quantizeVertices the source primitives are quantized like any static
+ * one; the skin pass decodes them and writes full vertices.
+ */
+class SkinningManager {
+public:
+  explicit SkinningManager(BasicSceneManager &mm);
+
+  /**number of skinned mesh instances.*/
+  uint32_t count() const;
+
+private:
+  friend class BasicSceneManager;
+  friend class MeshInstance;
+  friend class ModelInstance;
+
+  void createDescriptorSets(vk::DescriptorPool descriptorPool);
+  /**@return the offset of the inverse bind matrices in the skinning manager's buffer.*/
+  uint32_t addSkin(const std::vector<glm::mat4> &inverseBindMatrices);
+  /**
+   * skin primitive with the skin of node for instance into the frames of the output
+   * range starting at dstVertex.
+   * @return the job of the mesh instance.
+   */
+  uint32_t add(
+    const Ptr<Primitive> &primitive, const Ptr<Node> &node,
+    const Ptr<ModelInstance> &instance, uint32_t dstVertex);
+  /**reread the matrix slots of job, after its instance changed where its pose lives.*/
+  void refresh(uint32_t job);
+  /**remove job, giving its number to the last job.*/
+  void remove(uint32_t job);
+  /**record the palette and skin dispatches of imageIndex.*/
+  void compute(vk::CommandBuffer cb, uint32_t imageIndex);
+
+  using shader = vk::ShaderStageFlagBits;
+  struct SkinSetDef: DescriptorSetDef {
+    __buffer__(positions, shader::eCompute);
+    __buffer__(normals, shader::eCompute);
+    __buffer__(uvs, shader::eCompute);
+    __buffer__(joints, shader::eCompute);
+    __buffer__(weights, shader::eCompute);
+    __bufferDynamic__(transforms, shader::eCompute);
+    __buffer__(inverseBindMatrices, shader::eCompute);
+    __buffer__(paletteEntries, shader::eCompute);
+    __buffer__(jobs, shader::eCompute);
+    __buffer__(palette, shader::eCompute);
+    __buffer__(quantizedPositions, shader::eCompute);
+    __buffer__(quantizedNormals, shader::eCompute);
+    __buffer__(quantizedUVs, shader::eCompute);
+    __buffer__(primitives, shader::eCompute);
+  } skinSetDef;
+
+  // ref in shaders
+  struct SkinConstant {
+    uint32_t frame;
+    uint32_t paletteOffset;
+    uint32_t numEntries;
+    uint32_t numJobs;
+  };
+
+  struct SkinLayoutDef: PipelineLayoutDef {
+    __push_constant__(constant, shader::eCompute, SkinConstant);
+    __set__(set, SkinSetDef);
+  } skinLayoutDef;
+
+  // ref in shaders
+  /**where the palette matrix of one joint of one job comes from.*/
+  struct PaletteEntry {
+    uint32_t joint;
+    uint32_t inverseBindMatrix;
+    uint32_t meshNode;
+    uint32_t padding;
+  };
+
+  // ref in shaders
+  struct SkinJob {
+    uint32_t srcVertex;
+    uint32_t joint;
+    uint32_t weight;
+    uint32_t numVertices;
+    uint32_t dstVertex;
+    /**first palette entry of the job.*/
+    uint32_t palette;
+    /**UBO of the source primitive, whose box decodes quantized positions.*/
+    uint32_t primitive;
+  };
+
+  struct Skinned {
+    Ptr<Node> node;
+    Ptr<ModelInstance> instance;
+    Range palette;
+  };
+
+private:
+  BasicSceneManager &mm;
+  Device &device;
+  DebugMarker &debugMarker;
+
+  uint32_t numFrame;
+  uint32_t maxNumJoints, maxNumJobs;
+  uint32_t numIBMs{0}, maxVertices{0};
+  /**end of the highest palette entries in use.*/
+  uint32_t numEntries{0};
+
+  std::vector<Skinned> skinned;
+  RangeAllocator paletteRanges;
+
+  vk::DescriptorSet skinSet;
+  vk::UniquePipeline palettePipe;
+  vk::UniquePipeline skinPipe;
+
+  uPtr<HostStorageBuffer> inverseBindMatrices;
+  uPtr<HostStorageBuffer> paletteEntries;
+  uPtr<HostStorageBuffer> jobs;
+  /**numFrame regions of maxNumJoints matrices.*/
+  uPtr<StorageBuffer> palette;
+};
+}
@@ -28,8 +28,8 @@ void SkyModel::createDirectIrradianceSets() {
   pipelineMaker.shader(
     direct_irradiance_comp, __ArraySize__(direct_irradiance_comp), &spInfo);
 
-  directIrradiancePipeline =
-    pipelineMaker.createUnique(nullptr, *directIrradianceLayoutDef.pipelineLayout);
+  directIrradiancePipeline = pipelineMaker.createUnique(
+    device.getPipelineCache(), *directIrradianceLayoutDef.pipelineLayout);
 }
 
 void SkyModel::recordDirectIrradianceCMD(vk::CommandBuffer cb, vk::Bool32 cumulate) {
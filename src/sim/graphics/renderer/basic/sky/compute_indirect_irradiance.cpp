@@ -30,8 +30,8 @@ void SkyModel::createIndirectIrradianceSets() {
   ComputePipelineMaker pipelineMaker{device.getDevice()};
   pipelineMaker.shader(
     indirect_irradiance_comp, __ArraySize__(indirect_irradiance_comp), &spInfo);
-  indirectIrradiancePipeline =
-    pipelineMaker.createUnique(nullptr, *indirectIrradianceLayoutDef.pipelineLayout);
+  indirectIrradiancePipeline = pipelineMaker.createUnique(
+    device.getPipelineCache(), *indirectIrradianceLayoutDef.pipelineLayout);
 }
 
 void SkyModel::recordIndirectIrradianceCMD(
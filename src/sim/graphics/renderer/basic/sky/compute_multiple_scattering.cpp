@@ -28,8 +28,8 @@ void SkyModel::createMultipleScatteringSets() {
   ComputePipelineMaker pipelineMaker{device.getDevice()};
   pipelineMaker.shader(
     multiple_scattering_comp, __ArraySize__(multiple_scattering_comp), &spInfo);
-  multipleScatteringPipeline =
-    pipelineMaker.createUnique(nullptr, *multipleScatteringLayoutDef.pipelineLayout);
+  multipleScatteringPipeline = pipelineMaker.createUnique(
+    device.getPipelineCache(), *multipleScatteringLayoutDef.pipelineLayout);
 }
 
 void SkyModel::recordMultipleScatteringCMD(
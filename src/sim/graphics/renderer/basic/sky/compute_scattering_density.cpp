@@ -31,8 +31,8 @@ void SkyModel::createScatteringDensitySets() {
   ComputePipelineMaker pipelineMaker{device.getDevice()};
   pipelineMaker.shader(
     scattering_density_comp, __ArraySize__(scattering_density_comp), &spInfo);
-  scatteringDensityPipeline =
-    pipelineMaker.createUnique(nullptr, *scatteringDensityLayoutDef.pipelineLayout);
+  scatteringDensityPipeline = pipelineMaker.createUnique(
+    device.getPipelineCache(), *scatteringDensityLayoutDef.pipelineLayout);
 }
 
 void SkyModel::recordScatteringDensityCMD(vk::CommandBuffer cb, int32_t scatteringOrder) {
@@ -29,8 +29,8 @@ void SkyModel::createSingleScatteringSets() {
   ComputePipelineMaker pipelineMaker{device.getDevice()};
   pipelineMaker.shader(
     single_scattering_comp, __ArraySize__(single_scattering_comp), &spInfo);
-  singleScatteringPipeline =
-    pipelineMaker.createUnique(nullptr, *singleScatteringLayoutDef.pipelineLayout);
+  singleScatteringPipeline = pipelineMaker.createUnique(
+    device.getPipelineCache(), *singleScatteringLayoutDef.pipelineLayout);
 }
 
 void SkyModel::recordSingleScatteringCMD(
@@ -21,8 +21,8 @@ void SkyModel::createTransmittanceSets() {
   auto spInfo = sp.entry<uint32_t>(8).entry<uint32_t>(8).entry<uint32_t>(1).create();
   pipelineMaker.shader(transmittance_comp, __ArraySize__(transmittance_comp), &spInfo);
 
-  transmittancePipeline =
-    pipelineMaker.createUnique(nullptr, *transmittanceLayoutDef.pipelineLayout);
+  transmittancePipeline = pipelineMaker.createUnique(
+    device.getPipelineCache(), *transmittanceLayoutDef.pipelineLayout);
 
   transmittanceSet = transmittanceSetDef.createSet(*descriptorPool);
   transmittanceSetDef.atmosphere(_atmosphereUBO->buffer());
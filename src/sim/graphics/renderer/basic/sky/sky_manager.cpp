@@ -116,7 +116,7 @@ void SkyManager::updateModel() {
 
   auto tStart = std::chrono::high_resolution_clock::now();
 
-  _model->Init();
+  _model->Init(4, mm.cachePath("sky.simcache"));
 
   auto tEnd = std::chrono::high_resolution_clock::now();
   auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
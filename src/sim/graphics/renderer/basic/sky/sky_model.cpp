@@ -3,6 +3,11 @@
 #include "sim/graphics/base/pipeline/render_pass.h"
 #include "sim/graphics/base/pipeline/descriptors.h"
 #include "sim/graphics/base/pipeline/descriptor_pool_maker.h"
+#include "sim/util/mapped_file.h"
+#include "sim/util/hash.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
 
 namespace sim::graphics::renderer::basic {
 
@@ -164,7 +169,8 @@ uPtr<Texture> newTexture2D(
       1,
       vk::SampleCountFlagBits::e1,
       vk::ImageTiling::eOptimal,
-      imageUsage::eSampled | imageUsage::eTransferSrc | imageUsage::eStorage,
+      imageUsage::eSampled | imageUsage::eTransferSrc | imageUsage::eTransferDst |
+        imageUsage::eStorage,
       sharingMode,
       queueFamilyIndexCount,
       queueFamilyIndices},
@@ -201,7 +207,8 @@ uPtr<Texture> newTexture3D(
       1,
       vk::SampleCountFlagBits::e1,
       vk::ImageTiling::eOptimal,
-      imageUsage::eSampled | imageUsage::eTransferSrc | imageUsage::eStorage,
+      imageUsage::eSampled | imageUsage::eTransferSrc | imageUsage::eTransferDst |
+        imageUsage::eStorage,
       sharingMode,
       queueFamilyIndexCount,
       queueFamilyIndices},
@@ -215,6 +222,37 @@ uPtr<Texture> newTexture3D(
   texture->setSampler(maker.createUnique(device.getDevice()));
   return texture;
 }
+
+constexpr uint32_t cacheMagic = 0x4b535353; // "SSSK"
+/**bump whenever the precompute shaders change what they write.*/
+constexpr uint32_t cacheVersion = 1;
+
+struct CacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+};
+
+vk::DeviceSize sizeInBytes(const Texture &texture) {
+  auto &extent = texture.extent();
+  return vk::DeviceSize(extent.width) * extent.height * extent.depth * sizeof(glm::vec4);
+}
+
+/**copy texture, which the precomputation left shader readable, into host memory.*/
+void readBack(Device &device, Texture &texture, std::ofstream &out) {
+  auto size = sizeInBytes(texture);
+  ReadBackBuffer buffer{device.allocator(), vk::BufferUsageFlagBits::eTransferDst, size};
+  device.computeImmediately([&](vk::CommandBuffer cb) {
+    texture.transitToLayout(
+      cb, layout::eTransferSrcOptimal, access::eTransferRead, stage::eTransfer);
+    cb.copyImageToBuffer(
+      texture.image(), layout::eTransferSrcOptimal, buffer.buffer(),
+      vk::BufferImageCopy{0, 0, 0, {aspect::eColor, 0, 0, 1}, {}, texture.extent()});
+    texture.transitToLayout(
+      cb, layout::eShaderReadOnlyOptimal, access::eShaderRead, stage::eComputeShader);
+  });
+  out.write(buffer.ptr<char>(), std::streamsize(size));
+}
 }
 
 SkyModel::SkyModel(
@@ -385,7 +423,20 @@ void SkyModel::createDescriptors() {
   createMultipleScatteringSets();
 }
 
-void SkyModel::Init(unsigned int num_scattering_orders) {
+void SkyModel::Init(unsigned int num_scattering_orders, const std::string &cacheFile) {
+  transmittance_texture_->setCurrentState(
+    layout::eUndefined, access::eShaderRead, stage::eComputeShader);
+  scattering_texture_->setCurrentState(
+    layout::eUndefined, access::eShaderRead, stage::eComputeShader);
+  irradiance_texture_->setCurrentState(
+    layout::eUndefined, access::eShaderRead, stage::eComputeShader);
+
+  auto key = cacheKey(num_scattering_orders);
+  if(!cacheFile.empty() && loadCache(cacheFile, key)) {
+    _atmosphereUBO->ptr<AtmosphereUniform>()->atmosphere =
+      calcAtmosphereParams({kLambdaR, kLambdaG, kLambdaB});
+    return;
+  }
 
   delta_irradiance_texture = newTexture2D(
     device, IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT,
@@ -410,12 +461,6 @@ void SkyModel::Init(unsigned int num_scattering_orders) {
   debugMarker.name(
     delta_scattering_density_texture->image(), "delta_scattering_density_texture");
 
-  transmittance_texture_->setCurrentState(
-    layout::eUndefined, access::eShaderRead, stage::eComputeShader);
-  scattering_texture_->setCurrentState(
-    layout::eUndefined, access::eShaderRead, stage::eComputeShader);
-  irradiance_texture_->setCurrentState(
-    layout::eUndefined, access::eShaderRead, stage::eComputeShader);
   delta_irradiance_texture->setCurrentState(
     layout::eUndefined, access::eShaderRead, stage::eComputeShader);
   delta_rayleigh_scattering_texture->setCurrentState(
@@ -428,6 +473,7 @@ void SkyModel::Init(unsigned int num_scattering_orders) {
   createDescriptors();
 
   compute(num_scattering_orders);
+  if(!cacheFile.empty()) saveCache(cacheFile, key);
 
   //  transmittance_texture_->saveToFile(
   //    device, device.getComputeCmdPool(), device.computeQueue(), "./transmittance");
@@ -442,23 +488,27 @@ void SkyModel::Init(unsigned int num_scattering_orders) {
   delta_scattering_density_texture.reset();
 }
 
-void SkyModel::compute(uint32_t num_scattering_orders) {
+auto SkyModel::iterations() const -> std::vector<Iteration> {
   constexpr double _kLambdaMin = 360.0;
   constexpr double _kLambdaMax = 830.0;
   int num_iterations = (int(num_precomputed_wavelengths_) + 2) / 3;
   double dlambda = (_kLambdaMax - _kLambdaMin) / (3 * num_iterations);
 
+  std::vector<Iteration> result;
   for(int i = 0; i < num_iterations; ++i) {
     glm::vec3 lambdas{
       _kLambdaMin + (3 * i + 0.5) * dlambda, _kLambdaMin + (3 * i + 1.5) * dlambda,
       _kLambdaMin + (3 * i + 2.5) * dlambda};
-
-    glm::mat4 luminance_from_radiance = luminanceFromRadiance(dlambda, lambdas);
-    precompute(lambdas, luminance_from_radiance, i > 0, num_scattering_orders);
-    //    device.computeImmediately([&](vk::CommandBuffer cb) {
-    //
-    //    });
+    result.push_back({lambdas, luminanceFromRadiance(dlambda, lambdas)});
   }
+  return result;
+}
+
+void SkyModel::compute(uint32_t num_scattering_orders) {
+  auto all = iterations();
+  for(size_t i = 0; i < all.size(); ++i)
+    precompute(
+      all[i].lambdas, all[i].luminance_from_radiance, i > 0, num_scattering_orders);
 
   _atmosphereUBO->ptr<AtmosphereUniform>()->atmosphere =
     calcAtmosphereParams({kLambdaR, kLambdaG, kLambdaB});
@@ -491,6 +541,70 @@ void SkyModel::precompute(
   }
 }
 
+uint64_t SkyModel::cacheKey(uint32_t num_scattering_orders) const {
+  uint64_t key = sim::util::fnvOffsetBasis;
+  auto add = [&](const auto &value) {
+    key = sim::util::fnv1a(&value, sizeof(value), key);
+  };
+  add(num_scattering_orders);
+  add(transmittance_texture_->extent());
+  add(scattering_texture_->extent());
+  add(irradiance_texture_->extent());
+  // the parameters of each iteration cover every input spectrum and profile.
+  for(auto &iteration: iterations()) {
+    add(calcAtmosphereParams(iteration.lambdas));
+    add(iteration.luminance_from_radiance);
+  }
+  // the final transmittance is computed at the rgb wavelengths.
+  add(calcAtmosphereParams({kLambdaR, kLambdaG, kLambdaB}));
+  return key;
+}
+
+bool SkyModel::loadCache(const std::string &cacheFile, uint64_t key) {
+  Texture *textures[]{
+    transmittance_texture_.get(), scattering_texture_.get(), irradiance_texture_.get()};
+  size_t size = sizeof(CacheHeader);
+  for(auto texture: textures)
+    size += sizeInBytes(*texture);
+
+  MappedFile file{cacheFile};
+  if(!file.valid() || file.size() != size) return false;
+  CacheHeader header{};
+  std::memcpy(&header, file.data(), sizeof(header));
+  if(header.magic != cacheMagic || header.version != cacheVersion || header.key != key) {
+    debugLog("sky cache", cacheFile, "is stale, recomputing");
+    return false;
+  }
+
+  auto data = reinterpret_cast<const unsigned char *>(file.data()) + sizeof(header);
+  for(auto texture: textures) {
+    auto textureSize = sizeInBytes(*texture);
+    texture->upload(device, data, textureSize);
+    data += textureSize;
+  }
+  debugLog("loaded sky cache", cacheFile);
+  return true;
+}
+
+void SkyModel::saveCache(const std::string &cacheFile, uint64_t key) {
+  // write to a temporary file first so that a crash never leaves a torn cache behind.
+  auto tmpFile = cacheFile + ".tmp";
+  std::ofstream out{tmpFile, std::ios::binary | std::ios::trunc};
+  CacheHeader header{cacheMagic, cacheVersion, key};
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  readBack(device, *transmittance_texture_, out);
+  readBack(device, *scattering_texture_, out);
+  readBack(device, *irradiance_texture_, out);
+  out.close();
+  if(!out) {
+    debugLog("failed to write sky cache", cacheFile);
+    std::remove(tmpFile.c_str());
+    return;
+  }
+  std::remove(cacheFile.c_str());
+  if(std::rename(tmpFile.c_str(), cacheFile.c_str()) != 0) std::remove(tmpFile.c_str());
+}
+
 HostUniformBuffer &SkyModel::atmosphereUBO() { return *_atmosphereUBO; }
 HostUniformBuffer &SkyModel::sunUBO() { return *_sunUBO; }
 
@@ -92,7 +92,12 @@ public:
     float length_unit_in_meters, unsigned int num_precomputed_wavelengths,
     float exposure_scale);
 
-  void Init(unsigned int num_scattering_orders = 4);
+  /**
+   * precompute the transmittance, scattering and irradiance textures.
+   * @param cacheFile file the textures are loaded from instead if it was written for the
+   * same atmosphere, and saved to otherwise; empty disables the cache.
+   */
+  void Init(unsigned int num_scattering_orders = 4, const std::string &cacheFile = {});
 
   HostUniformBuffer &atmosphereUBO();
   HostUniformBuffer &sunUBO();
@@ -126,11 +131,23 @@ private:
   void createMultipleScatteringSets();
   void recordMultipleScatteringCMD(
     vk::CommandBuffer cb, const glm::mat4 &luminance_from_radiance);
+  /**a group of three wavelengths that the precomputation runs at once.*/
+  struct Iteration {
+    glm::vec3 lambdas;
+    glm::mat4 luminance_from_radiance;
+  };
+  std::vector<Iteration> iterations() const;
+
   void compute(uint32_t num_scattering_orders);
   void precompute(
     const glm::vec3 &lambdas, const glm::mat4 &luminance_from_radiance, bool cumulate,
     unsigned int num_scattering_orders);
 
+  /**@return a hash of everything the precomputed textures depend on.*/
+  uint64_t cacheKey(uint32_t num_scattering_orders) const;
+  bool loadCache(const std::string &cacheFile, uint64_t key);
+  void saveCache(const std::string &cacheFile, uint64_t key);
+
 private:
   Device &device;
   DebugMarker &debugMarker;
@@ -36,6 +36,9 @@ struct LightInstanceUBO {
   uint type;
 };
 
+// ref in shaders
+const uint MAX_LODS = 4u;
+
 struct PrimitiveUBO {
   uvec2 index, position, normal, uv, joint0, weight0;
   vec4 min, max;
@@ -43,8 +46,29 @@ struct PrimitiveUBO {
   float tesselationLevel;
   uint topology;
   uint type;
+  vec4 quantizationMin, quantizationMax;
+  /**index ranges of the coarser levels of detail and their errors in model units.*/
+  uvec2 lods[MAX_LODS - 1u];
+  float lodErrors[MAX_LODS - 1u];
+  uint numLODs;
+  /**range of the clusters of the full indices, see culling/cluster_cull.comp.*/
+  uvec2 clusters;
 };
 
+/**position from the snorm coordinates q within the primitive's quantization box.*/
+vec3 dequantizePosition(vec3 q, PrimitiveUBO primitive) {
+  return mix(primitive.quantizationMin.xyz, primitive.quantizationMax.xyz, q * 0.5 + 0.5);
+}
+
+/**unit vector from its octahedral encoding e.*/
+vec3 octDecode(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
 struct MeshInstanceUBO {
   uint primitive, material, node, instance;
 };
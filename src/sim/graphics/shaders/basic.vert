@@ -6,6 +6,9 @@ layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV0;
 
+// static primitives with quantized vertices, see QuantizedVertex.
+layout(constant_id = 0) const bool quantized = false;
+
 layout(set = 0, binding = 0) uniform Camera { CameraUBO cam; };
 layout(set = 0, binding = 1, std430) readonly buffer PrimitivesBuffer {
   PrimitiveUBO primitives[];
@@ -16,6 +19,9 @@ layout(set = 0, binding = 2, std430) readonly buffer MeshesBuffer {
 layout(set = 0, binding = 3, std430) readonly buffer TransformBuffer {
   mat4 transforms[];
 };
+layout(set = 0, binding = 7, std430) readonly buffer InstanceIDBuffer {
+  uint instanceIDs[];
+};
 
 layout(location = 0) out vs {
   vec3 outWorldPos;
@@ -27,11 +33,16 @@ layout(location = 0) out vs {
 out gl_PerVertex { vec4 gl_Position; };
 
 void main() {
-  MeshInstanceUBO mesh = meshes[gl_InstanceIndex];
+  MeshInstanceUBO mesh = meshes[instanceIDs[gl_InstanceIndex]];
   mat4 model = transforms[mesh.instance] * transforms[mesh.node];
-  vec4 pos = model * vec4(inPos, 1.0);
+  vec3 position = inPos, normal = inNormal;
+  if(quantized) {
+    position = dequantizePosition(inPos, primitives[mesh.primitive]);
+    normal = octDecode(inNormal.xy);
+  }
+  vec4 pos = model * vec4(position, 1.0);
   outWorldPos = pos.xyz / pos.w;
-  outNormal = normalize(transpose(inverse(mat3(model))) * inNormal);
+  outNormal = normalize(transpose(inverse(mat3(model))) * normal);
   outUV0 = inUV0;
   outMaterialID = mesh.material;
   gl_Position = cam.projView * vec4(outWorldPos, 1.0);
@@ -0,0 +1,252 @@
+#ifndef SIM_CULLING_H
+#define SIM_CULLING_H
+
+// ref in shaders
+struct DrawCMD {
+  uint indexCount;
+  uint instanceCount;
+  uint firstIndex;
+  int vertexOffset;
+  uint firstInstance;
+};
+
+// ref in shaders
+const uint NUM_CULLED_QUEUES = 4;
+
+// ref in shaders
+struct Cluster {
+  vec4 sphere;
+  vec4 cone;
+  uvec2 index;
+};
+
+layout(push_constant) uniform CullConstant {
+  mat4 prevProjView;
+  uint queue;
+  uint numCMDs;
+  uint outOffset;
+  uint countIndex;
+  uint compact;
+  uint pyramidWidth, pyramidHeight, pyramidLevels;
+  uint culledIDOffset;
+  uint lodSlots;
+  float lodError;
+  uint frame;
+  uint maxClusterJobs;
+  uint maxDraws;
+  uint cmdOffset;
+};
+
+layout(set = 0, binding = 0) uniform Camera { CameraUBO cam; };
+layout(set = 0, binding = 1, std430) readonly buffer PrimitivesBuffer {
+  PrimitiveUBO primitives[];
+};
+layout(set = 0, binding = 2, std430) readonly buffer MeshesBuffer {
+  MeshInstanceUBO meshes[];
+};
+layout(set = 0, binding = 3, std430) readonly buffer TransformBuffer {
+  mat4 transforms[];
+};
+layout(set = 0, binding = 4, std430) readonly buffer DrawCMDs { DrawCMD cmds[]; }
+queues[NUM_CULLED_QUEUES];
+layout(set = 0, binding = 5, std430) writeonly buffer CulledCMDs { DrawCMD culled[]; };
+layout(set = 0, binding = 6, std430) buffer DrawCounts { uint counts[]; };
+layout(set = 0, binding = 8, std430) buffer InstanceIDBuffer { uint instanceIDs[]; };
+layout(set = 0, binding = 9, std430) readonly buffer ClusterBuffer {
+  Cluster clusters[];
+};
+/**mesh instance and instance ID slot of each cluster job, maxClusterJobs per frame.*/
+layout(set = 0, binding = 10, std430) buffer ClusterJobs { uvec2 jobs[]; };
+/**
+ * the dispatch of each frame's cluster pass, counting its jobs in x and the draws
+ * reserved for them in w.
+ */
+layout(set = 0, binding = 11, std430) buffer ClusterDispatch { uvec4 dispatches[]; };
+
+// one workgroup per command, looping over its instances; at least MAX_LODS.
+const uint CULL_GROUP_SIZE = 32u;
+layout(local_size_x = CULL_GROUP_SIZE) in;
+
+/**visible instances of each level of detail, and the end of each level's IDs.*/
+shared uint lodCounts[MAX_LODS], lodEnds[MAX_LODS];
+/**the visible instances of the full level are culled by clusters, as jobs from jobBase.*/
+shared bool clustered;
+shared uint jobBase, jobCursor;
+
+/**world space bounding box of a mesh instance as center and half extent.*/
+void worldBounds(MeshInstanceUBO mesh, out vec3 center, out vec3 extent) {
+  PrimitiveUBO primitive = primitives[mesh.primitive];
+  mat4 model = transforms[mesh.instance] * transforms[mesh.node];
+  vec3 localCenter = (primitive.min.xyz + primitive.max.xyz) * 0.5;
+  vec3 localExtent = (primitive.max.xyz - primitive.min.xyz) * 0.5;
+  center = (model * vec4(localCenter, 1.0)).xyz;
+  mat3 m = mat3(model);
+  extent = abs(m[0]) * localExtent.x + abs(m[1]) * localExtent.y +
+           abs(m[2]) * localExtent.z;
+}
+
+/**
+ * false only if the box is completely outside one of the frustum planes. A degenerate
+ * box yields NaNs, which compare false and keep the mesh.
+ */
+bool insideFrustum(vec3 center, vec3 extent) {
+  for(int i = 0; i < 6; ++i) {
+    vec4 plane = cam.frustumPlanes[i];
+    if(dot(plane.xyz, center) + plane.w + dot(abs(plane.xyz), extent) < 0.0)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * write cmd to the output region. Compacting appends surviving commands and counts them;
+ * otherwise every command keeps its slot and culled ones draw zero instances.
+ */
+void emit(uint id, DrawCMD cmd, bool visible) {
+  if(compact == 1u) {
+    if(visible) culled[outOffset + atomicAdd(counts[countIndex], 1u)] = cmd;
+  } else {
+    if(!visible) cmd.instanceCount = 0u;
+    culled[outOffset + id] = cmd;
+  }
+}
+
+/**true unless the mesh instance with the world space box is culled.*/
+bool visible(vec3 center, vec3 extent);
+
+/**
+ * the coarsest of the first numLODs levels of primitive whose error, seen from the
+ * nearest point of the box, stays within lodError pixels.
+ */
+uint selectLOD(
+  PrimitiveUBO primitive, uint numLODs, MeshInstanceUBO mesh, vec3 center, vec3 extent) {
+  mat4 model = transforms[mesh.instance] * transforms[mesh.node];
+  float scale =
+    max(max(length(model[0].xyz), length(model[1].xyz)), length(model[2].xyz));
+  float distance = max(length(center - cam.eye.xyz) - length(extent), cam.zNear);
+  float pixels = scale * cam.h / (2.0 * tan(cam.fov * 0.5) * distance);
+  uint lod = 0u;
+  for(uint l = 1u; l < numLODs; ++l)
+    if(primitive.lodErrors[l - 1u] * pixels <= lodError) lod = l;
+  return lod;
+}
+
+/**
+ * reserve count cluster jobs of this frame and a draw for each of their numClusters
+ * clusters, all or none. The draws share the region of the opaque triangle queue past
+ * its lodSlots commands per command.
+ * @return false if they don't fit, and the instances are drawn whole.
+ */
+bool reserveJobs(uint count, uint numClusters, out uint base) {
+  base = 0u;
+  uint maxClusterDraws = maxDraws - numCMDs * lodSlots;
+  if(numClusters > maxClusterDraws / count) return false;
+  // the draws only bound a counter, so a reservation that fit can be taken back.
+  uint numDraws = count * numClusters;
+  uint draws = atomicAdd(dispatches[frame].w, numDraws);
+  if(draws + numDraws > maxClusterDraws) {
+    atomicAdd(dispatches[frame].w, 0u - numDraws);
+    return false;
+  }
+  base = atomicAdd(dispatches[frame].x, count);
+  if(base + count <= maxClusterJobs) return true;
+  // while a reservation that doesn't fit is counted, no other one fits either, so the
+  // ones that do never overlap.
+  atomicAdd(dispatches[frame].x, 0u - count);
+  atomicAdd(dispatches[frame].w, 0u - numDraws);
+  return false;
+}
+
+/**true if the mesh instance is visible, with the level of detail to draw it with.*/
+bool cullInstance(uint meshID, PrimitiveUBO primitive, uint numLODs, out uint lod) {
+  lod = 0u;
+  MeshInstanceUBO mesh = meshes[meshID];
+  vec3 center, extent;
+  worldBounds(mesh, center, extent);
+  if(!visible(center, extent)) return false;
+  if(numLODs > 1u) lod = selectLOD(primitive, numLODs, mesh, center, extent);
+  return true;
+}
+
+/**
+ * cull the instances of the workgroup's command. The visible instance IDs are compacted
+ * into the frame's culled region, at the same offset as the command's range, grouped by
+ * level of detail. The command's lodSlots output commands draw one level each from
+ * there. Opaque triangle instances of a clustered primitive at the full level become
+ * cluster jobs instead, drawn by cluster_cull.comp.
+ */
+void cullCMD() {
+  // commands spread over y as well to stay within the dispatch limits.
+  uint id = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+  if(id >= numCMDs) return;
+  DrawCMD cmd = queues[queue].cmds[cmdOffset + id];
+  // the instances of a command share its primitive.
+  PrimitiveUBO primitive;
+  uint numLODs = 1u;
+  if(cmd.instanceCount > 0u) {
+    primitive = primitives[meshes[instanceIDs[cmd.firstInstance]].primitive];
+    numLODs = min(primitive.numLODs, lodSlots);
+  }
+  bool clusterable = queue == 0u && maxClusterJobs > 0u && cmd.instanceCount > 0u &&
+                     primitive.clusters.y > 0u;
+  if(gl_LocalInvocationIndex < MAX_LODS) {
+    lodCounts[gl_LocalInvocationIndex] = 0u;
+    lodEnds[gl_LocalInvocationIndex] = 0u;
+  }
+  if(gl_LocalInvocationIndex == 0u) {
+    clustered = false;
+    jobCursor = 0u;
+  }
+  barrier();
+
+  // with several levels, count each level's instances first to place their IDs; the
+  // jobs of the full level are reserved from its count.
+  uint lod;
+  bool counted = numLODs > 1u || clusterable;
+  if(counted) {
+    for(uint i = gl_LocalInvocationIndex; i < cmd.instanceCount; i += CULL_GROUP_SIZE)
+      if(cullInstance(instanceIDs[cmd.firstInstance + i], primitive, numLODs, lod))
+        atomicAdd(lodCounts[lod], 1u);
+    barrier();
+    if(gl_LocalInvocationIndex == 0u) {
+      for(uint l = 1u; l < MAX_LODS; ++l)
+        lodEnds[l] = lodEnds[l - 1u] + lodCounts[l - 1u];
+      uint base = 0u;
+      clustered = clusterable && lodCounts[0] > 0u &&
+                  reserveJobs(lodCounts[0], primitive.clusters.y, base);
+      jobBase = base;
+    }
+    barrier();
+  }
+  for(uint i = gl_LocalInvocationIndex; i < cmd.instanceCount; i += CULL_GROUP_SIZE) {
+    uint meshID = instanceIDs[cmd.firstInstance + i];
+    if(cullInstance(meshID, primitive, numLODs, lod)) {
+      if(lod == 0u && clustered) {
+        // the base ID slot holds meshID for the cluster draws to read.
+        uint job = jobBase + atomicAdd(jobCursor, 1u);
+        jobs[frame * maxClusterJobs + job] = uvec2(meshID, cmd.firstInstance + i);
+      } else {
+        uint slot = cmd.firstInstance + atomicAdd(lodEnds[lod], 1u);
+        instanceIDs[culledIDOffset + slot] = meshID;
+      }
+    }
+  }
+  barrier();
+
+  uint l = gl_LocalInvocationIndex;
+  if(l < lodSlots) {
+    // a single level isn't counted ahead; its end is its count.
+    uint count = counted ? lodCounts[l] : (l == 0u ? lodEnds[0] : 0u);
+    if(l == 0u && clustered) count = 0u;
+    DrawCMD level = cmd;
+    level.firstInstance = culledIDOffset + cmd.firstInstance + lodEnds[l] - count;
+    level.instanceCount = count;
+    if(l > 0u && l < numLODs) {
+      level.firstIndex = primitive.lods[l - 1u].x;
+      level.indexCount = primitive.lods[l - 1u].y;
+    }
+    emit(id * lodSlots + l, level, count > 0u);
+  }
+}
+
+#endif //SIM_CULLING_H
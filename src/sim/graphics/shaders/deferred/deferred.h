@@ -24,8 +24,8 @@ layout(set = 1, binding = 5,input_attachment_index = 5) uniform SUBPASS_INPUT sa
 // clang-format on
 
 layout(set = 0, binding = 0) uniform Camera { CameraUBO cam; };
-layout(set = 0, binding = 6) uniform LightingUBO { LightUBO lighting; };
-layout(set = 0, binding = 7, std430) readonly buffer LightsBuffer {
+layout(set = 0, binding = 5) uniform LightingUBO { LightUBO lighting; };
+layout(set = 0, binding = 6, std430) readonly buffer LightsBuffer {
   LightInstanceUBO lights[];
 };
 
@@ -1,10 +1,9 @@
 #version 450
 #extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
 #include "../basic.h"
 #include "../tonemap.h"
 
-layout(constant_id = 0) const uint maxNumTextures = 1;
-
 layout(location = 0) in fs {
   vec3 inWorldPos;
   vec3 inNormal;
@@ -21,7 +20,7 @@ layout(location = 4) out vec4 outEmissive;
 layout(set = 0, binding = 4, std430) readonly buffer MaterialBuffer {
   MaterialUBO materials[];
 };
-layout(set = 0, binding = 5) uniform sampler2D textures[maxNumTextures];
+layout(set = 5, binding = 0) uniform sampler2D textures[];
 
 vec3 computeNormal(vec3 sampledNormal) {
   vec3 pos_dx = dFdx(inWorldPos);
@@ -0,0 +1,60 @@
+#ifndef SIM_SKINNING_H
+#define SIM_SKINNING_H
+#include "../basic.h"
+
+// ref in shaders
+struct PaletteEntry {
+  uint joint;
+  uint inverseBindMatrix;
+  uint meshNode;
+  uint padding;
+};
+
+// ref in shaders
+struct SkinJob {
+  uint srcVertex;
+  uint joint;
+  uint weight;
+  uint numVertices;
+  uint dstVertex;
+  uint palette;
+  uint primitive;
+};
+
+layout(push_constant) uniform SkinConstant {
+  uint frame;
+  uint paletteOffset;
+  uint numEntries;
+  uint numJobs;
+};
+
+layout(set = 0, binding = 0, std430) buffer PositionBuffer { float positions[]; };
+layout(set = 0, binding = 1, std430) buffer NormalBuffer { float normals[]; };
+layout(set = 0, binding = 2, std430) buffer UVBuffer { vec2 uvs[]; };
+layout(set = 0, binding = 3, std430) readonly buffer JointBuffer { vec4 joints[]; };
+layout(set = 0, binding = 4, std430) readonly buffer WeightBuffer { vec4 weights[]; };
+layout(set = 0, binding = 5, std430) readonly buffer TransformBuffer {
+  mat4 transforms[];
+};
+layout(set = 0, binding = 6, std430) readonly buffer InverseBindMatrixBuffer {
+  mat4 inverseBindMatrices[];
+};
+layout(set = 0, binding = 7, std430) readonly buffer PaletteEntryBuffer {
+  PaletteEntry entries[];
+};
+layout(set = 0, binding = 8, std430) readonly buffer JobBuffer { SkinJob jobs[]; };
+layout(set = 0, binding = 9, std430) buffer PaletteBuffer { mat4 palette[]; };
+layout(set = 0, binding = 10, std430) readonly buffer QuantizedPositionBuffer {
+  uvec2 quantizedPositions[];
+};
+layout(set = 0, binding = 11, std430) readonly buffer QuantizedNormalBuffer {
+  uint quantizedNormals[];
+};
+layout(set = 0, binding = 12, std430) readonly buffer QuantizedUVBuffer {
+  uint quantizedUVs[];
+};
+layout(set = 0, binding = 13, std430) readonly buffer PrimitivesBuffer {
+  PrimitiveUBO primitives[];
+};
+
+#endif //SIM_SKINNING_H
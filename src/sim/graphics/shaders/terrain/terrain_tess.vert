@@ -6,6 +6,9 @@ layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV0;
 
+// static primitives with quantized vertices, see QuantizedVertex.
+layout(constant_id = 0) const bool quantized = false;
+
 layout(set = 0, binding = 1, std430) readonly buffer PrimitivesBuffer {
   PrimitiveUBO primitives[];
 };
@@ -18,6 +21,9 @@ layout(set = 0, binding = 3, std430) readonly buffer TransformBuffer {
 layout(set = 0, binding = 4, std430) readonly buffer MaterialBuffer {
   MaterialUBO materials[];
 };
+layout(set = 0, binding = 7, std430) readonly buffer InstanceIDBuffer {
+  uint instanceIDs[];
+};
 
 layout(location = 0) out vec2 outUV0;
 layout(location = 1) out float minHeight;
@@ -30,7 +36,7 @@ layout(location = 7) out flat uint outNormalTex;
 layout(location = 8) out mat4 outModel;
 
 void main() {
-  MeshInstanceUBO mesh = meshes[gl_InstanceIndex];
+  MeshInstanceUBO mesh = meshes[instanceIDs[gl_InstanceIndex]];
   PrimitiveUBO primitive = primitives[mesh.primitive];
   MaterialUBO material = materials[mesh.material];
 
@@ -44,5 +50,5 @@ void main() {
   outNormalTex = material.normalTex;
   outModel = transforms[mesh.instance] * transforms[mesh.node];
 
-  gl_Position = vec4(inPos, 1.0);
+  gl_Position = vec4(quantized ? dequantizePosition(inPos, primitive) : inPos, 1.0);
 }
@@ -1,10 +1,9 @@
 #version 450
 #extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
 #include "basic.h"
 #include "tonemap.h"
 
-layout(constant_id = 0) const uint maxNumTextures = 1;
-
 layout(location = 0) in fs {
   vec3 inWorldPos;
   vec3 inNormal;
@@ -16,9 +15,9 @@ layout(set = 0, binding = 0) uniform Camera { CameraUBO cam; };
 layout(set = 0, binding = 4, std430) readonly buffer MaterialBuffer {
   MaterialUBO materials[];
 };
-layout(set = 0, binding = 5) uniform sampler2D textures[maxNumTextures];
-layout(set = 0, binding = 6) uniform LightingUBO { LightUBO lighting; };
-layout(set = 0, binding = 7, std430) readonly buffer LightsBuffer {
+layout(set = 5, binding = 0) uniform sampler2D textures[];
+layout(set = 0, binding = 5) uniform LightingUBO { LightUBO lighting; };
+layout(set = 0, binding = 6, std430) readonly buffer LightsBuffer {
   LightInstanceUBO lights[];
 };
 layout(location = 0) out vec4 outColor;
@@ -1,151 +1,191 @@
 #include "ocean_fft.h"
+#include <algorithm>
+#include <cmath>
 
 namespace sim::graphics {
-using bindpoint = vk::PipelineBindPoint;
-using stage = vk::PipelineStageFlagBits;
-using access = vk::AccessFlagBits;
+namespace {
+constexpr float g = 9.8f;
 
-glm::vec2 OceanFFT::hTiled_0(glm::vec2 k) {
-  float phillips = (k.x == 0 && k.y == 0) ? 0 : sqrt(phillipsSpectrum(k));
-  return {guassian() * phillips / sqrt(2), guassian() * phillips / sqrt(2)};
+/**the quantized dispersion of the shaders, which makes the surface repeat in time.*/
+float dispersion(glm::vec2 k) {
+  const float w_0 = 2 * glm::pi<float>() / 200.0f;
+  return std::floor(std::sqrt(g * glm::length(k)) / w_0) * w_0;
 }
-float OceanFFT::phillipsSpectrum(glm::vec2 k) {
-  float L = waveConfig.windSpeed * waveConfig.windSpeed / g;
-  float damping = 0.001f;
-  float l = L * damping;
-  float sqrK = dot(k, k);
-  glm::vec2 windDir{waveConfig.windDx, waveConfig.windDy};
-  float cosK = dot(k, windDir);
-  float phillips = waveConfig.waveAmplitude * exp(-1 / (sqrK * L * L)) /
-                   (sqrK * sqrK * sqrK) * (cosK * cosK);
-  if(cosK < 0) phillips *= 0.07f;
-  return phillips * exp(-sqrK * l * l);
+
+glm::vec2 mul(glm::vec2 a, glm::vec2 b) {
+  return {a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x};
 }
-void OceanFFT::initOceanData() {
-  {
-    auto ptr = datumBuffer->ptr<Ocean>();
-    for(auto row = 0; row < N; ++row) {
-      glm::vec2 k;
-      k.y = (-N / 2.f + row) * 2 * PI / waveConfig.patchSize;
-      for(auto column = 0; column < N; ++column) {
-        k.x = (-N / 2.f + column) * 2 * PI / waveConfig.patchSize;
-        glm::vec2 phi = hTiled_0(k);
-        ptr[row * N + column].h0 = {phi.x, phi.y};
-      }
+
+glm::vec2 polar(float rho, float theta) {
+  return {rho * std::cos(theta), rho * std::sin(theta)};
+}
+}
+
+OceanFFT::OceanFFT(const OceanSpectrum &spectrum, ThreadPool *pool)
+  : spectrum{spectrum}, pool{pool}, N{spectrum.size()}, rev(N, 0) {
+  auto bit = int32_t(log2f(float(N)));
+  for(auto i = 0; i < N; ++i)
+    rev[i] = (rev[i >> 1] >> 1) | ((i & 1) << (bit - 1));
+
+  // w_m^k, multiplied up k times like the shaders do.
+  for(int32_t groupSize = 2; groupSize <= N; groupSize *= 2) {
+    auto w_m = polar(1, 2 * glm::pi<float>() / float(groupSize));
+    glm::vec2 w{1, 0};
+    for(auto k = 0; k < groupSize / 2; ++k) {
+      twiddles.re.push_back(w.x);
+      twiddles.im.push_back(w.y);
+      w = mul(w, w_m);
     }
   }
-  {
-    auto rev = u<int32_t[]>(N);
-    auto bit = int32_t(log2f(float(N)));
-    for(auto i = 0; i < N; ++i)
-      rev[i] = (rev[i >> 1] >> 1) | ((i & 1) << (bit - 1));
-    bitReversalBuffer->update(rev.get(), N * sizeof(int32_t));
+
+  rows.resize(NumCategories);
+  for(auto &row: rows) {
+    row.re.resize(N * N);
+    row.im.resize(N * N);
   }
+  fields.assign(NumCategories, std::vector<float>(N * N));
 }
 
-void OceanFFT::createComputePipelines() {
-  //  uboWave = u<HostUniformBuffer>(*allocator, waveConfig);
-  //  datumBuffer = u<HostStorageBuffer>(*allocator, N * N * sizeof(Ocean));
-  //  bitReversalBuffer = u<HostStorageBuffer>(*allocator, N * sizeof(int32_t));
-  //  initOceanData();
-  //  vk::DispatchIndirectCommand dispatch;
-  //  dispatch.x = N / waveConstant.lx;
-  //  dispatch.y = N / waveConstant.ly;
-  //  dispatch.z = 5;
-  //  computeDispatchBuffer = u<HostIndirectBuffer>(*allocator, dispatch);
-  //  debugMarker.name(*uboWave, "ubo.wave");
-  //  debugMarker.name(*computeDispatchBuffer, "computeDispatchBuffer");
-  //  debugMarker.name(*datumBuffer, "datumBuffer");
-  //  debugMarker.name(*bitReversalBuffer, "bitReversalBuffer");
-  //
-  //  computeDef.init(vkDevice);
-  //  computeSet = computeDef.createSet(descriptorPool);
-  //  computeDef.wave(uboWave->buffer());
-  //  computeDef.bitReversal(bitReversalBuffer->buffer());
-  //  computeDef.datum(datumBuffer->buffer());
-  //  computeDef.vertices(scene->Buffer.vertices);
-  //  computeDef.viewProj(*ubo.viewProj);
-  //  computeDef.update(computeSet);
-  //
-  //  computePing.pipelineLayout = PipelineLayoutMaker()
-  //                                 .descriptorSetLayout(*computeDef.descriptorSetLayout)
-  //                                 .createUnique(vkDevice);
-  //  computePong.pipelineLayout = PipelineLayoutMaker()
-  //                                 .descriptorSetLayout(*computeDef.descriptorSetLayout)
-  //                                 .createUnique(vkDevice);
-  //
-  //  {
-  //    //compute pipeline
-  //    waveConstant.N = N;
-  //    ComputePipelineMaker pipelineMaker;
-  //    using sEntry = vk::SpecializationMapEntry;
-  //    std::array<sEntry, 3> constants = {
-  //      sEntry{0, offsetOf(WaveConstant, lx), sizeof(uint32_t)},
-  //      sEntry{1, offsetOf(WaveConstant, ly), sizeof(uint32_t)},
-  //      sEntry{2, offsetOf(WaveConstant, N), sizeof(int32_t)}};
-  //    vk::SpecializationInfo constInfo;
-  //    constInfo.mapEntryCount = constants.size();
-  //    constInfo.pMapEntries = constants.data();
-  //    constInfo.dataSize = sizeof(waveConstant);
-  //    constInfo.pData = &waveConstant;
-  //    {
-  //      ShaderModule comp{vkDevice,
-  //                        "./assets/public/sim/shaders/ocean/wave-fft-ping.comp.spv"s};
-  //      pipelineMaker.shader(comp, &constInfo);
-  //      computePing.pipeline =
-  //        pipelineMaker.createUnique(vkDevice, *pipelineCache, *computePing.pipelineLayout);
-  //      debugMarker.name(*computePing.pipeline, "computePing pipeline");
-  //    }
-  //    {
-  //      ShaderModule comp{vkDevice,
-  //                        "./assets/public/sim/shaders/ocean/wave-fft-pong.comp.spv"s};
-  //      pipelineMaker.shader(comp, &constInfo);
-  //      computePong.pipeline =
-  //        pipelineMaker.createUnique(vkDevice, *pipelineCache, *computePong.pipelineLayout);
-  //      debugMarker.name(*computePong.pipeline, "computePong pipeline");
-  //    }
-  //  }
+void OceanFFT::forRanges(const std::function<void(int32_t begin, int32_t end)> &func) {
+  auto numChunks = pool ? std::min<int32_t>(N, int32_t(pool->size()) * 4) : 1;
+  if(numChunks <= 1) {
+    func(0, N);
+    return;
+  }
+  auto perChunk = (N + numChunks - 1) / numChunks;
+  pool->parallelFor(size_t(numChunks), [&](size_t chunk) {
+    auto begin = int32_t(chunk) * perChunk;
+    func(begin, std::min(begin + perChunk, N));
+  });
 }
-void OceanFFT::fillComputeCmdBuffer(const vk::CommandBuffer &cb, uint32_t i) {
-  //  {
-  //    vk::BufferMemoryBarrier barrier{access::eIndirectCommandRead,
-  //                                    access::eShaderWrite,
-  //                                    VK_QUEUE_FAMILY_IGNORED,
-  //                                    VK_QUEUE_FAMILY_IGNORED,
-  //                                    *scene->Buffer.vertices,
-  //                                    0,
-  //                                    VK_WHOLE_SIZE};
-  //    cb.pipelineBarrier(
-  //      stage::eDrawIndirect, stage::eComputeShader, {}, nullptr, barrier, nullptr);
-  //  }
-  cb.bindPipeline(bindpoint::eCompute, *computePing.pipeline);
-  cb.bindDescriptorSets(
-    bindpoint::eCompute, *computePing.pipelineLayout, 0, computeSet, nullptr);
-  cb.dispatchIndirect(computeDispatchBuffer->buffer(), 0);
-  {
-    vk::BufferMemoryBarrier barrier{access::eShaderWrite,
-                                    access::eShaderRead,
-                                    VK_QUEUE_FAMILY_IGNORED,
-                                    VK_QUEUE_FAMILY_IGNORED,
-                                    datumBuffer->buffer(),
-                                    0,
-                                    VK_WHOLE_SIZE};
-    cb.pipelineBarrier(
-      stage::eComputeShader, stage::eComputeShader, {}, nullptr, barrier, nullptr);
+
+void OceanFFT::transform(float *re, float *im) const {
+  auto twRe = twiddles.re.data(), twIm = twiddles.im.data();
+  for(int32_t half = 1; half < N; half *= 2) {
+    for(int32_t group = 0; group < N; group += 2 * half) {
+      auto aRe = re + group, aIm = im + group;
+      auto bRe = aRe + half, bIm = aIm + half;
+      for(int32_t k = 0; k < half; ++k) {
+        auto tRe = twRe[k] * bRe[k] - twIm[k] * bIm[k];
+        auto tIm = twRe[k] * bIm[k] + twIm[k] * bRe[k];
+        auto uRe = aRe[k], uIm = aIm[k];
+        aRe[k] = uRe + tRe;
+        aIm[k] = uIm + tIm;
+        bRe[k] = uRe - tRe;
+        bIm[k] = uIm - tIm;
+      }
+    }
+    twRe += half;
+    twIm += half;
   }
-  cb.bindPipeline(bindpoint::eCompute, *computePong.pipeline);
-  cb.dispatchIndirect(computeDispatchBuffer->buffer(), 0);
-
-  {
-    //    vk::BufferMemoryBarrier barrier{access::eShaderWrite,
-    //                                    access::eIndirectCommandRead,
-    //                                    VK_QUEUE_FAMILY_IGNORED,
-    //                                    VK_QUEUE_FAMILY_IGNORED,
-    //                                    *scene->Buffer.vertices,
-    //                                    0,
-    //                                    VK_WHOLE_SIZE};
-    //    cb.pipelineBarrier(
-    //      stage::eComputeShader, stage::eDrawIndirect, {}, nullptr, barrier, nullptr);
+  for(int32_t i = 0; i < N; ++i) {
+    re[i] /= float(N);
+    im[i] /= float(N);
   }
 }
-}
\ No newline at end of file
+
+void OceanFFT::evaluate(float time, float timeScale) {
+  if(evaluated && time == this->time && timeScale == this->timeScale) return;
+  evaluated = true;
+  this->time = time;
+  this->timeScale = timeScale;
+  auto &h0 = spectrum.h0();
+
+  // wave-fft-ping: the time dependent spectrum, transformed row by row.
+  forRanges([&](int32_t begin, int32_t end) {
+    for(auto row = begin; row < end; ++row) {
+      auto offset = row * N;
+      for(int32_t id = 0; id < N; ++id) {
+        auto revId = rev[id];
+        auto _h0 = h0[row * N + revId];
+        auto _invH0 = h0[(N - 1 - row) * N + (N - 1 - revId)];
+        auto k = spectrum.waveNumber(revId, row);
+        auto omegat = dispersion(k) * time * timeScale;
+        auto ht = mul(_h0, polar(1, omegat)) + mul(_invH0, polar(1, -omegat));
+        auto len = glm::length(k);
+        glm::vec2 dx{0}, dz{0};
+        if(len >= 1e-6f) {
+          dx = mul(ht, {0, -k.x / len});
+          dz = mul(ht, {0, -k.y / len});
+        }
+        rows[Height].re[offset + id] = ht.x;
+        rows[Height].im[offset + id] = ht.y;
+        rows[DisplacementX].re[offset + id] = dx.x;
+        rows[DisplacementX].im[offset + id] = dx.y;
+        rows[DisplacementZ].re[offset + id] = dz.x;
+        rows[DisplacementZ].im[offset + id] = dz.y;
+      }
+      for(auto &line: rows)
+        transform(line.re.data() + offset, line.im.data() + offset);
+    }
+  });
+
+  // wave-fft-pong: the columns, with the sign flip that centers the zero wave number.
+  // Blocks of adjacent columns are gathered together, so rows are read in runs.
+  forRanges([&](int32_t begin, int32_t end) {
+    std::vector<float> re(block * N), im(block * N);
+    for(auto first = begin; first < end; first += block) {
+      auto count = std::min(block, end - first);
+      for(int32_t category = 0; category < NumCategories; ++category) {
+        auto &line = rows[category];
+        for(int32_t id = 0; id < N; ++id) {
+          auto src = rev[id] * N + first;
+          for(int32_t c = 0; c < count; ++c) {
+            re[c * N + id] = line.re[src + c];
+            im[c * N + id] = line.im[src + c];
+          }
+        }
+        for(int32_t c = 0; c < count; ++c)
+          transform(re.data() + c * N, im.data() + c * N);
+        auto &field = fields[category];
+        for(int32_t row = 0; row < N; ++row)
+          for(int32_t c = 0; c < count; ++c)
+            field[row * N + first + c] =
+              re[c * N + row] * ((row + first + c) & 1 ? -1.f : 1.f);
+      }
+    }
+  });
+}
+
+void OceanFFT::invalidate() { evaluated = false; }
+
+float OceanFFT::heightAt(float x, float z) const {
+  auto u = x + float(N) / 2, v = z + float(N) / 2;
+  auto u0 = std::floor(u), v0 = std::floor(v);
+  auto fu = u - u0, fv = v - v0;
+  auto wrap = [&](float i) { return ((int32_t(i) % N) + N) % N; };
+  auto c0 = wrap(u0), c1 = (c0 + 1) % N, r0 = wrap(v0), r1 = (r0 + 1) % N;
+  auto &height = fields[Height];
+  auto h0 = height[r0 * N + c0] * (1 - fu) + height[r0 * N + c1] * fu;
+  auto h1 = height[r1 * N + c0] * (1 - fu) + height[r1 * N + c1] * fu;
+  return h0 * (1 - fv) + h1 * fv;
+}
+
+float OceanFFT::sampleHeight(float x, float z, float time, float timeScale) {
+  evaluate(time, timeScale);
+  return heightAt(x, z);
+}
+
+void OceanFFT::sampleHeights(
+  const glm::vec2 *positions, float *heights, size_t count, float time,
+  float timeScale) {
+  evaluate(time, timeScale);
+  for(size_t i = 0; i < count; ++i)
+    heights[i] = heightAt(positions[i].x, positions[i].y);
+}
+
+glm::vec3 OceanFFT::displacement(int32_t column, int32_t row, float choppyScale) const {
+  auto i = row * N + column;
+  return {
+    fields[DisplacementX][i] * choppyScale, fields[Height][i],
+    fields[DisplacementZ][i] * choppyScale};
+}
+
+void OceanFFT::displacements(glm::vec3 *offsets, float choppyScale) const {
+  for(int32_t row = 0; row < N; ++row)
+    for(int32_t column = 0; column < N; ++column)
+      offsets[row * N + column] = displacement(column, row, choppyScale);
+}
+
+int32_t OceanFFT::size() const { return N; }
+}
@@ -1,62 +1,76 @@
 #pragma once
+#include <vector>
+#include <functional>
+#include "ocean_spectrum.h"
 
-#include "sim/graphics/base/vulkan_base.h"
-#include "sim/graphics/resource/buffers.h"
-#include "sim/graphics/pipeline/descriptors.h"
-
-namespace sim { namespace graphics {
+namespace sim::graphics {
+/**
+ * The ocean surface of an OceanSpectrum on the CPU, for physics that cannot wait for the
+ * GPU. It runs the transform of the wave-fft-ping and wave-fft-pong compute shaders step
+ * by step, with the same twiddle factors, order of operations and scaling, so that it
+ * also serves as a reference for them.
+ *
+ * Positions are in the ocean field's model space, where the vertex of texel (column,
+ * row) rests at (column - N/2, row - N/2) and the surface repeats every N units.
+ */
 class OceanFFT {
-  using shader = vk::ShaderStageFlagBits;
-
 public:
-  OceanFFT();
+  /**@param pool spreads rows and columns over its workers if not null.*/
+  explicit OceanFFT(const OceanSpectrum &spectrum, ThreadPool *pool = nullptr);
+
+  /**
+   * transform the spectrum at time, unless the last transform was at the same time.
+   * @param time, timeScale the time and time scale the shaders are given; they are
+   * multiplied in the shaders' order, so that the phases round the same.
+   */
+  void evaluate(float time, float timeScale = 1.f);
+  /**the spectrum changed; the next evaluate transforms it again.*/
+  void invalidate();
+
+  /**height of the surface above (x, z), bilinear between the vertices at rest.*/
+  float sampleHeight(float x, float z, float time, float timeScale = 1.f);
+  /**height of the surface above each of count (x, z) positions.*/
+  void sampleHeights(
+    const glm::vec2 *positions, float *heights, size_t count, float time,
+    float timeScale = 1.f);
+  /**
+   * offset of the vertex of texel (column, row) from its rest position at the last
+   * evaluated time, as the shaders write it.
+   */
+  glm::vec3 displacement(int32_t column, int32_t row, float choppyScale = -1.f) const;
+  /**offsets of every vertex, row by row, at the last evaluated time.*/
+  void displacements(glm::vec3 *offsets, float choppyScale = -1.f) const;
+
+  int32_t size() const;
 
 private:
-  struct WaveConstant {
-    uint32_t lx{128}, ly{1};
-    int32_t N{128};
-  } waveConstant{};
-
-  int N{128};
-
-  struct WaveUniform {
-    int meshOffset{};
-    float patchSize{500.f};
-    float windSpeed{60.f};
-    float waveAmplitude{10.f};
-    float choppyScale{-1.f};
-    float timeScale{0.01f};
-    float windDx{0.8f}, windDy{0.6f};
-    float ampFactor{1.f};
-    float time{0.f};
-  } waveConfig;
-
-  struct Ocean {
-    glm::vec2 h0, ht, hDx, hDz, slopeX, slopeZ;
+  enum Category { Height, DisplacementX, DisplacementZ, NumCategories };
+  /**columns the second pass transforms together.*/
+  static constexpr int32_t block = 16;
+
+  /**complex numbers in split form, so that the butterflies vectorize.*/
+  struct Complex {
+    std::vector<float> re, im;
   };
 
-  struct ComputeDescriptorSet: DescriptorSetDef {
-    __uniform__(wave, shader::eCompute);
-    __buffer__(bitReversal, shader::eCompute);
-    __buffer__(datum, shader::eCompute);
-    __buffer__(vertices, shader::eCompute);
-    __uniform__(viewProj, shader::eCompute);
-  } computeDef;
-
-  vk::DescriptorSet computeSet;
-  uPtr<HostUniformBuffer> uboWave;
-  uPtr<HostStorageBuffer> bitReversalBuffer, datumBuffer;
-  uPtr<HostIndirectBuffer> computeDispatchBuffer;
-  Pipe computePing, computePong;
-
-  const float g = 9.8f;
-  const float PI = glm::pi<float>();
-
-  glm::vec2 hTiled_0(glm::vec2 k);
-  float phillipsSpectrum(glm::vec2 k);
-  void initOceanData();
-
-  void createComputePipelines();
-  void fillComputeCmdBuffer(const vk::CommandBuffer &cb, uint32_t i);
+  /**run func(begin, end) over ranges of [0, N) on the workers.*/
+  void forRanges(const std::function<void(int32_t begin, int32_t end)> &func);
+  /**transform N numbers in bit reversed order in place, scaled by 1/N.*/
+  void transform(float *re, float *im) const;
+  float heightAt(float x, float z) const;
+
+  const OceanSpectrum &spectrum;
+  ThreadPool *pool;
+  int32_t N;
+  std::vector<int32_t> rev;
+  /**the twiddle factors of every stage, one stage after another.*/
+  Complex twiddles;
+
+  bool evaluated{false};
+  float time{0}, timeScale{1};
+  /**the rows transformed by the first pass, per category.*/
+  std::vector<Complex> rows;
+  /**the result of both passes with the signs of the shaders applied, per category.*/
+  std::vector<std::vector<float>> fields;
 };
-}}
\ No newline at end of file
+}
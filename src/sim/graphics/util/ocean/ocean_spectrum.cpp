@@ -0,0 +1,116 @@
+#include "ocean_spectrum.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace sim::graphics {
+namespace {
+/**
+ * e^x for x up to 88 by a polynomial after reducing x to [-ln2/2, ln2/2] (Cephes expf),
+ * within a few ulp. Unlike std::exp it is inlined and has no branches, so loops calling
+ * it vectorize; x below -87, -inf included, gives e^-87.
+ */
+inline float polyExp(float x) {
+  // the bits of negative floats grow with their magnitude, so an unsigned min clamps x
+  // to -87 without a float compare, which the vectorizer cannot turn into a select.
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  bits = std::min(bits, 0xC2AE0000u);
+  std::memcpy(&x, &bits, sizeof(x));
+  // adding and subtracting 1.5 * 2^23 rounds to the nearest integer.
+  auto n = (x * 1.44269504f + 12582912.f) - 12582912.f;
+  auto r = x - n * 0.693359375f + n * 2.12194440e-4f;
+  auto p = 1.9875691500e-4f;
+  p = p * r + 1.3981999507e-3f;
+  p = p * r + 8.3334519073e-3f;
+  p = p * r + 4.1665795894e-2f;
+  p = p * r + 1.6666665459e-1f;
+  p = p * r + 5.0000001201e-1f;
+  p = p * r * r + r + 1.f;
+  bits = uint32_t(int32_t(n) + 127) << 23u;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+}
+OceanSpectrum::OceanSpectrum(int32_t N, float patchSize, uint32_t seed)
+  : N{N}, _patchSize{patchSize}, gaussians(N * N), _h0(N * N) {
+  std::mt19937 rng{seed};
+  std::normal_distribution<float> gaussian{0.f, 1.f};
+  for(auto &value: gaussians)
+    value = {gaussian(rng), gaussian(rng)};
+}
+
+void OceanSpectrum::setWind(glm::vec2 direction, float speed) {
+  windDirection = direction;
+  windSpeed = speed;
+}
+
+void OceanSpectrum::setWaveAmplitude(float amplitude) { waveAmplitude = amplitude; }
+
+void OceanSpectrum::update(ThreadPool *pool) {
+  float L = windSpeed * windSpeed / g;
+  float damping = 0.001f;
+  float l = L * damping;
+  auto windX = windDirection.x, windY = windDirection.y;
+  auto amplitude = waveAmplitude;
+
+  // kx only depends on the column.
+  std::vector<float> kxs(N);
+  for(int32_t column = 0; column < N; ++column)
+    kxs[column] = waveNumber(column, 0).x;
+
+  // the scales of a row are computed over plain float arrays without branches, with
+  // polyExp instead of std::exp, so that the loop vectorizes; std::sqrt inlines with the
+  // -fno-math-errno the build gives this file. The zero wave number is cleared after the
+  // loop, and the scales are applied to the interleaved gaussian pairs in a second pass.
+  // Rows are independent.
+  auto updateRows = [&](int32_t begin, int32_t end) {
+    std::vector<float> scales(N);
+    auto kx = kxs.data();
+    auto scale = scales.data();
+    for(auto row = begin; row < end; ++row) {
+      auto ky = waveNumber(0, row).y;
+      for(int32_t column = 0; column < N; ++column) {
+        auto sqrK = kx[column] * kx[column] + ky * ky;
+        auto cosK = kx[column] * windX + ky * windY;
+        auto phillips = amplitude * polyExp(-1 / (sqrK * L * L)) /
+                        (sqrK * sqrK * sqrK) * (cosK * cosK);
+        // 0.07 against the wind, 1 along it.
+        phillips *= 0.535f + 0.465f * std::copysign(1.f, cosK);
+        phillips *= polyExp(-sqrK * l * l);
+        scale[column] = std::sqrt(phillips / 2);
+      }
+      if(row == N / 2) scale[N / 2] = 0;
+      auto gaussian = gaussians.data() + row * N;
+      auto h0 = _h0.data() + row * N;
+      for(int32_t column = 0; column < N; ++column)
+        h0[column] = gaussian[column] * scale[column];
+    }
+  };
+
+  auto numChunks = pool ? std::min<int32_t>(N, int32_t(pool->size()) * 4) : 1;
+  if(numChunks <= 1) {
+    updateRows(0, N);
+    return;
+  }
+  auto rowsPerChunk = (N + numChunks - 1) / numChunks;
+  pool->parallelFor(size_t(numChunks), [&](size_t chunk) {
+    auto begin = int32_t(chunk) * rowsPerChunk;
+    updateRows(begin, std::min(begin + rowsPerChunk, N));
+  });
+}
+
+const std::vector<glm::vec2> &OceanSpectrum::h0() const { return _h0; }
+
+glm::vec2 OceanSpectrum::waveNumber(int32_t column, int32_t row) const {
+  auto pi = glm::pi<float>();
+  return {
+    (float(-N) / 2.f + column) * 2 * pi / _patchSize,
+    (float(-N) / 2.f + row) * 2 * pi / _patchSize};
+}
+
+int32_t OceanSpectrum::size() const { return N; }
+float OceanSpectrum::patchSize() const { return _patchSize; }
+}
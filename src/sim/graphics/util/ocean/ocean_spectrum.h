@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "sim/graphics/base/glm_common.h"
+#include "sim/util/thread_pool.h"
+
+namespace sim::graphics {
+/**
+ * The initial wave amplitudes h0 of an N x N ocean patch drawn from the Phillips spectrum
+ * (Tessendorf). Every texel keeps the two gaussian numbers it was drawn with, so a new
+ * wind or wave amplitude rescales the same waves instead of drawing new ones.
+ */
+class OceanSpectrum {
+public:
+  /**@param seed seeds the gaussian numbers; equal seeds give equal waves.*/
+  OceanSpectrum(int32_t N, float patchSize, uint32_t seed);
+
+  void setWind(glm::vec2 direction, float speed);
+  void setWaveAmplitude(float amplitude);
+  /**evaluate h0 of every texel, spreading the rows over the workers of pool if any.*/
+  void update(ThreadPool *pool = nullptr);
+
+  /**h0 of texel (column, row) at row * N + column.*/
+  const std::vector<glm::vec2> &h0() const;
+  /**wave number of texel (column, row); texel (N/2, N/2) has the zero wave number.*/
+  glm::vec2 waveNumber(int32_t column, int32_t row) const;
+  int32_t size() const;
+  float patchSize() const;
+
+private:
+  static constexpr float g = 9.8f;
+
+  int32_t N;
+  float _patchSize;
+  glm::vec2 windDirection{0.8f, 0.6f};
+  float windSpeed{60.f};
+  float waveAmplitude{10.f};
+
+  std::vector<glm::vec2> gaussians, _h0;
+};
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace sim::util {
+constexpr uint64_t fnvOffsetBasis = 0xcbf29ce484222325ull;
+
+/**64-bit FNV-1a of size bytes, continuing from hash; keys caches by their contents.*/
+inline uint64_t fnv1a(const void *data, size_t size, uint64_t hash = fnvOffsetBasis) {
+  auto bytes = static_cast<const unsigned char *>(data);
+  for(size_t i = 0; i < size; ++i)
+    hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+  return hash;
+}
+}
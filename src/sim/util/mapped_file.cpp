@@ -0,0 +1,60 @@
+#include "mapped_file.h"
+#ifdef _WIN32
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+namespace sim {
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string &path) {
+  file = CreateFileA(
+    path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if(file == INVALID_HANDLE_VALUE) {
+    file = nullptr;
+    return;
+  }
+  LARGE_INTEGER size;
+  if(!GetFileSizeEx(file, &size) || size.QuadPart == 0) return;
+  mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if(!mapping) return;
+  auto ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if(!ptr) return;
+  _data = static_cast<const std::byte *>(ptr);
+  _size = size_t(size.QuadPart);
+}
+
+MappedFile::~MappedFile() {
+  if(_data) UnmapViewOfFile(_data);
+  if(mapping) CloseHandle(mapping);
+  if(file) CloseHandle(file);
+}
+#else
+MappedFile::MappedFile(const std::string &path) {
+  auto fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) return;
+  struct stat st {};
+  if(fstat(fd, &st) == 0 && st.st_size > 0) {
+    auto ptr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if(ptr != MAP_FAILED) {
+      // the file is read front to back exactly once.
+      madvise(ptr, size_t(st.st_size), MADV_SEQUENTIAL);
+      _data = static_cast<const std::byte *>(ptr);
+      _size = size_t(st.st_size);
+    }
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if(_data) munmap(const_cast<std::byte *>(_data), _size);
+}
+#endif
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+namespace sim {
+/**A read-only memory mapping of a whole file.*/
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**@return false if the file could not be opened or mapped.*/
+  bool valid() const { return _data != nullptr; }
+  const std::byte *data() const { return _data; }
+  size_t size() const { return _size; }
+
+private:
+  const std::byte *_data{nullptr};
+  size_t _size{0};
+#ifdef _WIN32
+  void *file{nullptr}, *mapping{nullptr};
+#endif
+};
+}
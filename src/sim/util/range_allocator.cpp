@@ -0,0 +1,200 @@
+#include "range_allocator.h"
+#include "syntactic_sugar.h"
+#include <algorithm>
+
+namespace sim::util {
+namespace {
+uint32_t msb(uint32_t x) {
+  uint32_t n = 0;
+  while(x >>= 1u) ++n;
+  return n;
+}
+uint32_t lsb(uint32_t x) {
+  uint32_t n = 0;
+  while(!(x & 1u)) {
+    x >>= 1u;
+    ++n;
+  }
+  return n;
+}
+}
+
+RangeAllocator::RangeAllocator(uint32_t capacity): _capacity{capacity} {
+  errorIf(capacity == 0, "range allocator capacity should be greater than 0!");
+  heads.fill(none);
+  // the block at offset 0 is never merged into a previous one, so it stays blocks[0].
+  insertFree(newBlock(0, capacity));
+}
+
+void RangeAllocator::mapping(uint32_t size, uint32_t &fl, uint32_t &sl) {
+  if(size < slCount) {
+    fl = 0;
+    sl = size;
+    return;
+  }
+  auto m = msb(size);
+  fl = m - slBits + 1;
+  sl = (size >> (m - slBits)) ^ slCount;
+}
+
+uint32_t RangeAllocator::findFree(uint32_t size) const {
+  uint64_t rounded = size;
+  // round up to the next bin, so that every block of the bin is large enough.
+  if(size >= slCount) rounded += (uint64_t(1) << (msb(size) - slBits)) - 1;
+  uint32_t fl, sl;
+  mapping(uint32_t(std::min<uint64_t>(rounded, ~0u)), fl, sl);
+
+  auto slMask = slMasks[fl] & (~0u << sl);
+  if(!slMask) {
+    auto flMaskAbove = fl + 1 < flCount ? flMask & (~0u << (fl + 1)) : 0;
+    if(flMaskAbove) {
+      fl = lsb(flMaskAbove);
+      slMask = slMasks[fl];
+    }
+  }
+  if(slMask) return heads[fl * slCount + lsb(slMask)];
+
+  // only the bin of size itself may still hold a block that fits.
+  mapping(size, fl, sl);
+  auto block = heads[fl * slCount + sl];
+  for(; block != none; block = blocks[block].nextFree)
+    if(blocks[block].size >= size) return block;
+  return none;
+}
+
+void RangeAllocator::insertFree(uint32_t block) {
+  auto &b = blocks[block];
+  uint32_t fl, sl;
+  mapping(b.size, fl, sl);
+  auto &head = heads[fl * slCount + sl];
+  b.free = true;
+  b.prevFree = none;
+  b.nextFree = head;
+  if(head != none) blocks[head].prevFree = block;
+  head = block;
+  flMask |= 1u << fl;
+  slMasks[fl] |= 1u << sl;
+  ++_numFreeBlocks;
+}
+
+void RangeAllocator::removeFree(uint32_t block) {
+  auto &b = blocks[block];
+  uint32_t fl, sl;
+  mapping(b.size, fl, sl);
+  auto &head = heads[fl * slCount + sl];
+  if(b.prevFree != none) blocks[b.prevFree].nextFree = b.nextFree;
+  else
+    head = b.nextFree;
+  if(b.nextFree != none) blocks[b.nextFree].prevFree = b.prevFree;
+  if(head == none) {
+    slMasks[fl] &= ~(1u << sl);
+    if(!slMasks[fl]) flMask &= ~(1u << fl);
+  }
+  b.free = false;
+  b.prevFree = b.nextFree = none;
+  --_numFreeBlocks;
+}
+
+uint32_t RangeAllocator::newBlock(uint32_t offset, uint32_t size) {
+  Block block;
+  block.offset = offset;
+  block.size = size;
+  if(!unusedBlocks.empty()) {
+    auto idx = unusedBlocks.back();
+    unusedBlocks.pop_back();
+    blocks[idx] = block;
+    return idx;
+  }
+  blocks.push_back(block);
+  return uint32_t(blocks.size() - 1);
+}
+
+void RangeAllocator::take(uint32_t block, uint32_t size, Range &range) {
+  removeFree(block);
+  if(blocks[block].size > size) {
+    auto rest =
+      newBlock(blocks[block].offset + size, blocks[block].size - size); // may reallocate
+    auto &b = blocks[block];
+    auto &r = blocks[rest];
+    r.prev = block;
+    r.next = b.next;
+    if(b.next != none) blocks[b.next].prev = rest;
+    b.next = rest;
+    b.size = size;
+    insertFree(rest);
+  }
+  range = {blocks[block].offset, size};
+  allocated[range.offset] = block;
+  _used += size;
+}
+
+void RangeAllocator::merge(uint32_t block) {
+  auto &b = blocks[block];
+  auto next = b.next;
+  auto &n = blocks[next];
+  b.size += n.size;
+  b.next = n.next;
+  if(n.next != none) blocks[n.next].prev = block;
+  unusedBlocks.push_back(next);
+}
+
+bool RangeAllocator::allocate(uint32_t size, Range &range) {
+  if(size == 0) {
+    range = {};
+    return true;
+  }
+  auto block = findFree(size);
+  if(block == none) return false;
+  take(block, size, range);
+  return true;
+}
+
+bool RangeAllocator::allocateLowest(uint32_t size, uint32_t end, Range &range) {
+  if(size == 0) {
+    range = {};
+    return true;
+  }
+  for(auto block = 0u; block != none; block = blocks[block].next) {
+    auto &b = blocks[block];
+    if(uint64_t(b.offset) + size > end) return false;
+    if(b.free && b.size >= size) {
+      take(block, size, range);
+      return true;
+    }
+  }
+  return false;
+}
+
+void RangeAllocator::free(const Range &range) {
+  if(range.size == 0) return;
+  auto it = allocated.find(range.offset);
+  errorIf(it == allocated.end(), "freeing a range that is not allocated!");
+  auto block = it->second;
+  errorIf(blocks[block].size != range.size, "freeing a range of mismatched size!");
+  allocated.erase(it);
+  _used -= range.size;
+
+  auto next = blocks[block].next;
+  if(next != none && blocks[next].free) {
+    removeFree(next);
+    merge(block);
+  }
+  auto prev = blocks[block].prev;
+  if(prev != none && blocks[prev].free) {
+    removeFree(prev);
+    merge(prev);
+    block = prev;
+  }
+  insertFree(block);
+}
+
+uint32_t RangeAllocator::capacity() const { return _capacity; }
+uint32_t RangeAllocator::used() const { return _used; }
+uint32_t RangeAllocator::numFreeBlocks() const { return _numFreeBlocks; }
+bool RangeAllocator::fragmented() const {
+  if(_numFreeBlocks != 1) return _numFreeBlocks > 1;
+  uint32_t fl, sl;
+  mapping(_capacity - _used, fl, sl);
+  return blocks[heads[fl * slCount + sl]].offset != _used;
+}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include "range.h"
+
+namespace sim::util {
+/**
+ * Sub-allocates ranges of [0, capacity) with a two-level segregated fit: free blocks are
+ * binned by the power of two of their size and eight linear steps within it, and bitmaps
+ * of the non-empty bins find a block that fits in constant time. Released ranges merge
+ * with free neighbours immediately.
+ */
+class RangeAllocator {
+public:
+  explicit RangeAllocator(uint32_t capacity);
+
+  /**@return false if no free block can hold size elements.*/
+  bool allocate(uint32_t size, Range &range);
+  /**
+   * allocate from the start of the free block with the lowest offset that can hold size
+   * elements, as long as the range ends at or before end. Used to compact live ranges.
+   */
+  bool allocateLowest(uint32_t size, uint32_t end, Range &range);
+  void free(const Range &range);
+
+  uint32_t capacity() const;
+  /**number of allocated elements.*/
+  uint32_t used() const;
+  uint32_t numFreeBlocks() const;
+  /**@return true unless the free space is one block at the end.*/
+  bool fragmented() const;
+
+private:
+  static constexpr uint32_t slBits = 3;
+  static constexpr uint32_t slCount = 1u << slBits;
+  static constexpr uint32_t flCount = 32;
+  static constexpr uint32_t none = ~0u;
+
+  struct Block {
+    uint32_t offset, size;
+    /**neighbours in address order.*/
+    uint32_t prev{none}, next{none};
+    /**neighbours in the free list of the block's bin.*/
+    uint32_t prevFree{none}, nextFree{none};
+    bool free{false};
+  };
+
+  static void mapping(uint32_t size, uint32_t &fl, uint32_t &sl);
+  /**@return a free block that can hold size, or none.*/
+  uint32_t findFree(uint32_t size) const;
+  void insertFree(uint32_t block);
+  void removeFree(uint32_t block);
+  uint32_t newBlock(uint32_t offset, uint32_t size);
+  /**allocate size elements from the start of the free block.*/
+  void take(uint32_t block, uint32_t size, Range &range);
+  /**merge the block after block into it.*/
+  void merge(uint32_t block);
+
+  std::vector<Block> blocks;
+  std::vector<uint32_t> unusedBlocks;
+  /**allocated block of each allocated offset.*/
+  std::unordered_map<uint32_t, uint32_t> allocated;
+
+  uint32_t flMask{0};
+  std::array<uint32_t, flCount> slMasks{};
+  std::array<uint32_t, flCount * slCount> heads;
+
+  uint32_t _capacity, _used{0}, _numFreeBlocks{0};
+};
+}
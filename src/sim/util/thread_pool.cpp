@@ -0,0 +1,45 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace sim {
+ThreadPool::ThreadPool(uint32_t numThreads) {
+  if(numThreads == 0) numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  workers.reserve(numThreads);
+  for(uint32_t i = 0; i < numThreads; ++i)
+    workers.emplace_back([this] {
+      while(true) {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lock{mutex};
+          cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+          if(stopping && tasks.empty()) return;
+          task = std::move(tasks.front());
+          tasks.pop();
+        }
+        task();
+      }
+    });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  cv.notify_all();
+  for(auto &worker: workers)
+    worker.join();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &func) {
+  std::vector<std::future<void>> futures;
+  futures.reserve(count);
+  for(size_t i = 0; i < count; ++i)
+    futures.push_back(submit([&func, i] { func(i); }));
+  // wait for every task before rethrowing, so none outlives func.
+  for(auto &future: futures)
+    future.wait();
+  for(auto &future: futures)
+    future.get();
+}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <queue>
+#include <vector>
+#include <functional>
+
+namespace sim {
+/**
+ * A fixed set of worker threads consuming a shared task queue. Exceptions thrown by a
+ * task are rethrown from the future returned by submit().
+ */
+class ThreadPool {
+public:
+  /**@param numThreads number of workers; 0 uses the hardware concurrency.*/
+  explicit ThreadPool(uint32_t numThreads = 0);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  template<typename F>
+  auto submit(F &&func) -> std::future<decltype(func())> {
+    using R = decltype(func());
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+    auto future = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      tasks.emplace([task] { (*task)(); });
+    }
+    cv.notify_one();
+    return future;
+  }
+
+  /**run func(i) for every i in [0, count) on the workers and wait for all of them.*/
+  void parallelFor(size_t count, const std::function<void(size_t)> &func);
+
+  uint32_t size() const { return uint32_t(workers.size()); }
+
+private:
+  std::vector<std::thread> workers;
+  std::queue<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stopping{false};
+};
+}
@@ -0,0 +1,122 @@
+#include "sim/graphics/util/ocean/ocean_fft.h"
+#include "sim/util/syntactic_sugar.h"
+#include <chrono>
+#include <cmath>
+#include <complex>
+
+using namespace sim;
+using namespace sim::graphics;
+
+namespace {
+using complex = std::complex<double>;
+enum Field { Height, DisplacementX, DisplacementZ };
+
+/**
+ * field of spectrum at time by the plain inverse transform and the shaders' signs; the
+ * horizontal displacements are not multiplied by the choppy scale.
+ */
+std::vector<double> naiveField(
+  const OceanSpectrum &spectrum, float time, float timeScale, Field field) {
+  auto N = spectrum.size();
+  auto &h0 = spectrum.h0();
+  auto pi = glm::pi<double>();
+  const double w_0 = 2 * pi / 200.0;
+  std::vector<complex> ht(N * N), rows(N * N);
+  for(int32_t row = 0; row < N; ++row)
+    for(int32_t column = 0; column < N; ++column) {
+      auto k = spectrum.waveNumber(column, row);
+      auto len = double(glm::length(k));
+      auto omegat = std::floor(std::sqrt(9.8 * len) / w_0) * w_0 * time * timeScale;
+      auto h = h0[row * N + column], invH = h0[(N - 1 - row) * N + (N - 1 - column)];
+      auto value = complex{h.x, h.y} * std::polar(1.0, omegat) +
+                   complex{invH.x, invH.y} * std::polar(1.0, -omegat);
+      // the displacements are -i k/|k| h.
+      if(field != Height) {
+        auto kxz = field == DisplacementX ? k.x : k.y;
+        value = len < 1e-6 ? 0 : value * complex{0, -kxz / len};
+      }
+      ht[row * N + column] = value;
+    }
+  for(int32_t row = 0; row < N; ++row)
+    for(int32_t n = 0; n < N; ++n) {
+      complex sum;
+      for(int32_t m = 0; m < N; ++m)
+        sum += ht[row * N + m] * std::polar(1.0, 2 * pi * m * n / N);
+      rows[row * N + n] = sum / double(N);
+    }
+  std::vector<double> values(N * N);
+  for(int32_t column = 0; column < N; ++column)
+    for(int32_t p = 0; p < N; ++p) {
+      complex sum;
+      for(int32_t q = 0; q < N; ++q)
+        sum += rows[q * N + column] * std::polar(1.0, 2 * pi * q * p / N);
+      values[p * N + column] = (sum / double(N)).real() * ((p + column) & 1 ? -1 : 1);
+    }
+  return values;
+}
+}
+
+auto main(int argc, const char **argv) -> int {
+  {
+    OceanSpectrum spectrum{32, 32, 1};
+    spectrum.update();
+    OceanFFT fft{spectrum};
+    auto time = 3.7f, timeScale = 0.8f;
+    fft.evaluate(time, timeScale);
+    const char *names[]{"height", "displacement x", "displacement z"};
+    for(auto field: {Height, DisplacementX, DisplacementZ}) {
+      auto expected = naiveField(spectrum, time, timeScale, field);
+      double maxValue = 0, maxError = 0;
+      for(int32_t row = 0; row < 32; ++row)
+        for(int32_t column = 0; column < 32; ++column) {
+          auto value = expected[row * 32 + column];
+          auto d = fft.displacement(column, row, 1.f);
+          auto actual = field == Height ? d.y : field == DisplacementX ? d.x : d.z;
+          maxValue = std::max(maxValue, std::abs(value));
+          maxError = std::max(maxError, std::abs(actual - value));
+        }
+      println("N 32, ", names[field], ": max ", maxValue, ", max error ", maxError);
+      errorIf(
+        maxError > 1e-4 * std::max(maxValue, 1.0), names[field], " differs from the dft");
+    }
+
+    for(int32_t row = 0; row < 32; ++row)
+      for(int32_t column = 0; column < 32; ++column) {
+        // texel (column, row) rests at (column - N/2, row - N/2).
+        auto sampled = fft.sampleHeight(column - 16.f, row - 16.f, time, timeScale);
+        errorIf(sampled != fft.displacement(column, row).y, "sampled off the grid");
+      }
+  }
+
+  {
+    // the workers transform the same rows and columns the calling thread does, in the
+    // same order, so the results agree exactly.
+    OceanSpectrum spectrum{512, 512, 1};
+    spectrum.update();
+    auto pool = u<ThreadPool>(0);
+    OceanFFT serial{spectrum}, parallel{spectrum, pool.get()};
+    std::vector<glm::vec3> expected(512 * 512), actual(512 * 512);
+    double serialMs = 0, parallelMs = 0;
+    for(auto frame = 0; frame < 10; ++frame) {
+      auto start = std::chrono::steady_clock::now();
+      serial.evaluate(frame / 60.f);
+      auto middle = std::chrono::steady_clock::now();
+      parallel.evaluate(frame / 60.f);
+      auto end = std::chrono::steady_clock::now();
+      serialMs += std::chrono::duration<double, std::milli>(middle - start).count();
+      parallelMs += std::chrono::duration<double, std::milli>(end - middle).count();
+
+      serial.displacements(expected.data());
+      parallel.displacements(actual.data());
+      for(size_t i = 0; i < expected.size(); ++i)
+        errorIf(
+          expected[i].x != actual[i].x || expected[i].y != actual[i].y ||
+            expected[i].z != actual[i].z,
+          "the workers differ from the calling thread at frame ", frame);
+    }
+    println(
+      "N 512: ", serialMs / 10, " ms per evaluate on 1 thread, ", parallelMs / 10,
+      " ms on ", pool->size());
+  }
+  return 0;
+}
@@ -40,6 +40,8 @@ auto main(int argc, const char **argv) -> int {
       Transform t{{origin + -center * scale + vec3{nx, 0, ny}}, glm::vec3{scale}};
       //  t.translation = -center;
       auto instance = mm.newModelInstance(model, t);
+      for(uint32_t i = 0; i < model->animations().size(); ++i)
+        mm.animationManager().play(instance, i, float(nx * width + ny) * 0.01f);
     }
 
   //  auto envCube = mm.newCubeTexture("assets/private/environments/noga_2k.ktx");
@@ -63,8 +65,6 @@ auto main(int argc, const char **argv) -> int {
       " ", int32_t(mFPSMeter.FPS()), " FPS (", mFPSMeter.FrameTime(), " ms)");
     auto fullTitle = "Test  " + frameStats;
     app.setWindowTitle(fullTitle);
-    for(auto &animation: model->animations())
-      animation.animateAll(elapsedDuration);
     if(app.input.keyPressed[KeyW]) pressed = true;
     else if(pressed) {
       mm.setWireframe(!mm.wireframe());
@@ -0,0 +1,44 @@
+#include "sim/graphics/renderer/basic/basic_renderer.h"
+#include "sim/graphics/util/fps_meter.h"
+
+using namespace sim;
+using namespace sim::graphics;
+using namespace sim::graphics::renderer::basic;
+using namespace glm;
+
+auto main(int argc, const char **argv) -> int {
+  Config config{};
+  config.headless = true;
+  config.numFrame = 3;
+  BasicRenderer app{config};
+
+  auto &mm = app.sceneManager();
+
+  auto &camera = mm.camera();
+  camera.setLocation({20.f, 20.f, 20.f});
+  mm.addLight(LightType ::Directional, {-1, -1, -1});
+
+  auto primitive =
+    mm.newPrimitive(PrimitiveBuilder(mm).box({}, {0, 0, 1}, {1, 0, 0}, 1).newPrimitive());
+  auto material = mm.newMaterial();
+  material->setColorFactor({0.f, 1.f, 0.f, 1.f});
+  auto mesh = mm.newMesh(primitive, material);
+  auto node = mm.newNode();
+  Node::addMesh(node, mesh);
+  auto model = mm.newModel({node});
+
+  for(int x = -5; x <= 5; ++x)
+    for(int z = -5; z <= 5; ++z)
+      mm.newModelInstance(model, Transform{{x * 2.f, 0.f, z * 2.f}});
+
+  mm.debugInfo();
+
+  const uint32_t numFrames = 1000;
+  uint32_t frame = 0;
+  float total = 0;
+  app.run([&](uint32_t imageIndex, float elapsedDuration) {
+    total += elapsedDuration;
+    if(++frame >= numFrames) app.closeWindow();
+  });
+  println("rendered", frame, "frames in", total, "s,", frame / total, "FPS");
+}
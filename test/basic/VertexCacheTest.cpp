@@ -0,0 +1,96 @@
+#include "sim/graphics/renderer/basic/builder/mesh_optimizer.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+
+using namespace sim;
+using namespace sim::graphics;
+using namespace sim::graphics::renderer::basic;
+
+namespace {
+/**@return the triangles of indices rotated to start at their smallest index, sorted.*/
+std::vector<std::array<uint32_t, 3>> triangleSet(const std::vector<uint32_t> &indices) {
+  std::vector<std::array<uint32_t, 3>> triangles;
+  triangles.reserve(indices.size() / 3);
+  for(size_t i = 0; i < indices.size(); i += 3) {
+    std::array<uint32_t, 3> t{indices[i], indices[i + 1], indices[i + 2]};
+    // rotating keeps the winding, unlike sorting the corners.
+    std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+    triangles.push_back(t);
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+/**an n x n grid of quads split into two counter-clockwise triangles each.*/
+void grid(uint32_t n, std::vector<glm::vec3> &positions, std::vector<uint32_t> &indices) {
+  for(uint32_t y = 0; y <= n; ++y)
+    for(uint32_t x = 0; x <= n; ++x)
+      positions.emplace_back(float(x), 0.f, float(y));
+  for(uint32_t y = 0; y < n; ++y)
+    for(uint32_t x = 0; x < n; ++x) {
+      auto a = y * (n + 1) + x, b = a + 1, c = a + n + 1, d = c + 1;
+      indices.insert(indices.end(), {a, c, b, b, c, d});
+    }
+}
+
+void measure(
+  const std::string &name, std::vector<uint32_t> indices,
+  const std::vector<glm::vec3> &positions, uint32_t numThreads) {
+  auto numVertices = uint32_t(positions.size());
+  auto before = MeshOptimizer::acmr(indices.data(), indices.size(), numVertices);
+  auto original = indices;
+
+  MeshOptimizer optimizer{numThreads};
+  auto start = std::chrono::steady_clock::now();
+  optimizer.optimizeTriangles(indices, positions.data(), numVertices);
+  auto remap = MeshOptimizer::optimizeVertexFetch(indices, numVertices);
+  auto optimized = MeshOptimizer::remap(positions.data(), remap);
+  auto end = std::chrono::steady_clock::now();
+
+  auto after = MeshOptimizer::acmr(indices.data(), indices.size(), numVertices);
+  auto ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+  errorIf(remap.size() != numVertices, "remap misses vertices");
+  std::vector<bool> used(numVertices);
+  for(auto v: remap) {
+    errorIf(v >= numVertices || used[v], "remap is not a permutation");
+    used[v] = true;
+  }
+  for(auto &i: original)
+    i = remap[i];
+  errorIf(
+    triangleSet(indices) != triangleSet(original),
+    "optimizing changed the triangles or their winding");
+  for(uint32_t i = 0; i < numVertices; ++i)
+    errorIf(optimized[remap[i]] != positions[i], "remapped positions differ");
+  errorIf(after > before, "optimizing raised the cache miss ratio");
+  println(
+    name, ": ", indices.size() / 3, " triangles, threads ", numThreads, ", acmr ", before,
+    " -> ", after, ", ", ms, " ms");
+}
+}
+
+auto main(int argc, const char **argv) -> int {
+  for(auto n: {64u, 256u, 1024u}) {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    grid(n, positions, indices);
+    measure(toString("grid ", n), indices, positions, 1);
+
+    // shuffled triangles resemble exported meshes without any cache ordering.
+    std::vector<uint32_t> triangles(indices.size() / 3);
+    for(uint32_t i = 0; i < triangles.size(); ++i)
+      triangles[i] = i;
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937{n});
+    std::vector<uint32_t> shuffled;
+    shuffled.reserve(indices.size());
+    for(auto t: triangles)
+      shuffled.insert(
+        shuffled.end(), indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+    measure(toString("shuffled grid ", n), shuffled, positions, 1);
+    measure(toString("shuffled grid ", n), shuffled, positions, 0);
+  }
+  return 0;
+}